@@ -0,0 +1,67 @@
+#include "BoundingWindow.h"
+
+#include <cmath>
+
+
+BoundingWindow::BoundingWindow() : smallFrames(0)
+{
+}
+
+void BoundingWindow::SetScreen(const DamageRect& screen)
+{
+    this->screen = screen;
+    int size = 2 * Slack;
+    this->rect = DamageRect(screen.x + (screen.width - size) / 2, screen.y + (screen.height - size) / 2, size, size)
+        .Intersect(screen);
+    this->smallFrames = 0;
+}
+
+bool BoundingWindow::Update(bool any, const float bounds[4], float margin)
+{
+    // an empty trail keeps the window where it is until the cursor moves again
+    if (!any) {
+        return false;
+    }
+
+    int left = static_cast<int>(std::floor(bounds[0] - margin));
+    int top = static_cast<int>(std::floor(bounds[1] - margin));
+    int right = static_cast<int>(std::ceil(bounds[2] + margin));
+    int bottom = static_cast<int>(std::ceil(bounds[3] + margin));
+    DamageRect needed = DamageRect(left, top, right - left, bottom - top).Intersect(this->screen);
+    if (needed.Empty()) {
+        return false;
+    }
+
+    // grow right away, the trail must never be cut off
+    DamageRect covered = needed.Intersect(this->rect);
+    if (covered.width != needed.width || covered.height != needed.height) {
+        this->rect = this->fit(needed);
+        this->smallFrames = 0;
+        return true;
+    }
+
+    // shrink only after the trail stayed small for a while
+    long long neededArea = static_cast<long long>(needed.width) * needed.height;
+    long long windowArea = static_cast<long long>(this->rect.width) * this->rect.height;
+    if (neededArea * ShrinkRatio >= windowArea) {
+        this->smallFrames = 0;
+        return false;
+    }
+    if (++this->smallFrames < ShrinkFrames) {
+        return false;
+    }
+    this->smallFrames = 0;
+    DamageRect shrunk = this->fit(needed);
+    if (shrunk.x == this->rect.x && shrunk.y == this->rect.y &&
+        shrunk.width == this->rect.width && shrunk.height == this->rect.height) {
+        return false;
+    }
+    this->rect = shrunk;
+    return true;
+}
+
+DamageRect BoundingWindow::fit(const DamageRect& needed) const
+{
+    DamageRect grown(needed.x - Slack, needed.y - Slack, needed.width + 2 * Slack, needed.height + 2 * Slack);
+    return grown.Intersect(this->screen);
+}
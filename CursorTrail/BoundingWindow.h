@@ -0,0 +1,35 @@
+#ifndef BOUNDING_WINDOW_H
+#define BOUNDING_WINDOW_H
+
+#include "DamageTracker.h"
+
+// Screen rectangle of an overlay window that only covers the live trail
+// instead of the whole desktop, so compositing cost follows the trail
+// size. The window grows as soon as the trail leaves it, with some slack
+// so a moving cursor does not resize it every frame, and shrinks only
+// after the trail has used a small part of it for a while.
+class BoundingWindow
+{
+public:
+    // extra room added around the trail when the window is resized (pixels)
+    static const int Slack = 128;
+    // the window shrinks once the trail covers less than 1/ShrinkRatio of it...
+    static const int ShrinkRatio = 4;
+    // ...for this many consecutive frames
+    static const int ShrinkFrames = 30;
+
+    BoundingWindow();
+    // area the window has to stay inside, the initial window is centered in it
+    void              SetScreen(const DamageRect& screen);
+    // fits the window to the live particle bounds {minX, minY, maxX, maxY}
+    // (ignored when any is false) plus margin; true when the rectangle changed
+    bool              Update(bool any, const float bounds[4], float margin);
+    const DamageRect& Rect() const { return this->rect; }
+private:
+    DamageRect screen;
+    DamageRect rect;
+    int        smallFrames;     // consecutive frames the trail used little of the window
+    DamageRect fit(const DamageRect& needed) const;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "Clock.h"
+
+#include <chrono>
+
+const double Clock::RebaseInterval = 3600.0;
+
+Clock::Clock() : epoch(Clock::Seconds()), driven(false), time(0.0)
+{
+}
+
+float Clock::Now() const
+{
+    return static_cast<float>(this->current() - this->epoch);
+}
+
+bool Clock::Rebase(float& shift)
+{
+    double now = this->current();
+    if (now - this->epoch < RebaseInterval) {
+        return false;
+    }
+
+    shift = static_cast<float>(now - this->epoch);
+    this->epoch = now;
+    return true;
+}
+
+void Clock::SetTime(double seconds)
+{
+    if (!this->driven) {
+        this->driven = true;
+        this->epoch = seconds;
+    }
+    this->time = seconds;
+}
+
+double Clock::current() const
+{
+    return this->driven ? this->time : Clock::Seconds();
+}
+
+double Clock::Seconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
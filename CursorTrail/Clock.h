@@ -0,0 +1,34 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+// Monotonic clock used to timestamp trail particles. Times are reported
+// in seconds relative to an epoch that is moved forward periodically so
+// they stay small enough to be stored in floats (and uploaded to the GPU)
+// without losing precision on long running sessions.
+// A replayed cursor trace drives the clock with its own timestamps, so a
+// replay runs on the recorded timeline instead of the system clock.
+class Clock
+{
+public:
+    // interval after which Rebase() moves the epoch forward (seconds)
+    static const double RebaseInterval;
+
+    Clock();
+    // seconds elapsed since the current epoch
+    float  Now() const;
+    // moves the epoch to the current time once RebaseInterval has passed;
+    // returns true and the amount every stored timestamp must be shifted by
+    bool   Rebase(float& shift);
+    // from now on reports the given time (seconds, any origin) instead of
+    // the system clock; the first call moves the epoch to it
+    void   SetTime(double seconds);
+    // absolute monotonic time in seconds
+    static double Seconds();
+private:
+    double epoch;
+    bool   driven;  // SetTime() replaced the system clock
+    double time;    // time given to SetTime()
+    double current() const;
+};
+
+#endif
@@ -5,10 +5,141 @@
 #include <string>
 #include <algorithm>
 #include <cctype>
+#include <stdexcept>
 
 // Global configuration instance
 Config g_config;
 
+const float Config::FadeReferenceRate = 60.0f;
+
+// Parses boolean config values such as "true", "yes", "on" or "1"
+static bool ParseBool(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    if (value == "true" || value == "yes" || value == "on" || value == "1") {
+        return true;
+    }
+    if (value == "false" || value == "no" || value == "off" || value == "0") {
+        return false;
+    }
+    throw std::invalid_argument("expected true or false");
+}
+
+// Parses the fade mode names "frame" and "time"
+static FadeMode ParseFadeMode(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    if (value == "frame") {
+        return FADE_FRAME;
+    }
+    if (value == "time") {
+        return FADE_TIME;
+    }
+    throw std::invalid_argument("expected frame or time");
+}
+
+// Parses the path modes "linear" and "spline"
+static PathMode ParsePathMode(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    if (value == "linear") {
+        return PATH_LINEAR;
+    }
+    if (value == "spline" || value == "catmull-rom") {
+        return PATH_SPLINE;
+    }
+    throw std::invalid_argument("expected linear or spline");
+}
+
+// Parses the frame dump formats "png" and "raw"
+static DumpFormat ParseDumpFormat(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    if (value == "png") {
+        return DUMP_PNG;
+    }
+    if (value == "raw" || value == "rgba") {
+        return DUMP_RAW;
+    }
+    throw std::invalid_argument("expected png or raw");
+}
+
+// Parses a resolution such as "1920x1080"
+static void ParseResolution(const std::string& value, int& width, int& height)
+{
+    size_t separator = value.find_first_of("xX");
+    if (separator == std::string::npos) {
+        throw std::invalid_argument("expected <width>x<height>");
+    }
+    int parsedWidth = std::stoi(value.substr(0, separator));
+    int parsedHeight = std::stoi(value.substr(separator + 1));
+    if (parsedWidth <= 0 || parsedHeight <= 0) {
+        throw std::invalid_argument("width and height must be positive");
+    }
+    width = parsedWidth;
+    height = parsedHeight;
+}
+
+// Parses a number that has to be above zero, such as a step or a count
+static float ParsePositive(const std::string& value)
+{
+    float parsed = std::stof(value);
+    if (!(parsed > 0.0f)) {
+        throw std::invalid_argument("must be positive");
+    }
+    return parsed;
+}
+
+static int ParsePositiveInt(const std::string& value)
+{
+    int parsed = std::stoi(value);
+    if (parsed <= 0) {
+        throw std::invalid_argument("must be positive");
+    }
+    return parsed;
+}
+
+// Parses a comma separated list of times such as "0.5,1,2.25"
+static std::vector<float> ParseTimes(const std::string& value)
+{
+    std::vector<float> times;
+    std::stringstream list(value);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        times.push_back(std::stof(item));
+    }
+    std::sort(times.begin(), times.end());
+    return times;
+}
+
+static const char* FadeModeName(FadeMode mode)
+{
+    return mode == FADE_FRAME ? "frame" : "time";
+}
+
+static const char* PathModeName(PathMode mode)
+{
+    return mode == PATH_LINEAR ? "linear" : "spline";
+}
+
+// Parses the X11 overlay backends "shm" and "render"
+static X11Backend ParseX11Backend(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    if (value == "shm") {
+        return X11_SHM;
+    }
+    if (value == "render" || value == "xrender") {
+        return X11_RENDER;
+    }
+    throw std::invalid_argument("expected shm or render");
+}
+
+static const char* X11BackendName(X11Backend backend)
+{
+    return backend == X11_SHM ? "shm" : "render";
+}
+
 bool Config::LoadFromFile(const std::string& filename)
 {
     std::ifstream file(filename);
@@ -84,6 +215,33 @@ bool Config::LoadFromFile(const std::string& filename)
                     fadeRate = 0.05f;
                 }
             }
+            else if (key == "fademode" || key == "fade_mode") {
+                fadeMode = ParseFadeMode(value);
+            }
+            else if (key == "pathmode" || key == "path_mode") {
+                pathMode = ParsePathMode(value);
+            }
+            else if (key == "filtercutoff" || key == "filter_cutoff") {
+                filterCutoff = std::stof(value);
+                if (filterCutoff < 0) {
+                    std::cout << "Warning: filterCutoff must not be negative, using default." << std::endl;
+                    filterCutoff = 0.0f;
+                }
+            }
+            else if (key == "filterbeta" || key == "filter_beta") {
+                filterBeta = std::stof(value);
+                if (filterBeta < 0) {
+                    std::cout << "Warning: filterBeta must not be negative, using default." << std::endl;
+                    filterBeta = 0.05f;
+                }
+            }
+            else if (key == "deadzone" || key == "dead_zone") {
+                deadZone = std::stof(value);
+                if (deadZone < 0) {
+                    std::cout << "Warning: deadZone must not be negative, using default." << std::endl;
+                    deadZone = 0.0f;
+                }
+            }
             else if (key == "spawnfrequency" || key == "spawn_frequency" || key == "density") {
                 spawnFrequency = std::stof(value);
                 if (spawnFrequency <= 0) {
@@ -98,6 +256,24 @@ bool Config::LoadFromFile(const std::string& filename)
                     maxParticles = 2048;
                 }
             }
+            else if (key == "batchrendering" || key == "batch_rendering" || key == "batch") {
+                batchRendering = ParseBool(value);
+            }
+            else if (key == "showstats" || key == "show_stats" || key == "stats") {
+                showStats = ParseBool(value);
+            }
+            else if (key == "persistentbuffers" || key == "persistent_buffers") {
+                persistentBuffers = ParseBool(value);
+            }
+            else if (key == "boundingwindow" || key == "bounding_window") {
+                boundingWindow = ParseBool(value);
+            }
+            else if (key == "nativeoverlay" || key == "native_overlay") {
+                nativeOverlay = ParseBool(value);
+            }
+            else if (key == "x11backend" || key == "x11_backend") {
+                x11Backend = ParseX11Backend(value);
+            }
             else {
                 std::cout << "Warning: Unknown config key '" << key << "' on line " << lineNumber << std::endl;
             }
@@ -129,8 +305,21 @@ bool Config::SaveToFile(const std::string& filename) const
     file << "# Trail behavior\n";
     file << "fadeTime=" << fadeTime << "       # How long particles last (seconds)\n";
     file << "fadeRate=" << fadeRate << "       # How fast particles fade per frame (0.0-1.0)\n";
+    file << "fadeMode=" << FadeModeName(fadeMode) << "       # frame = fade every frame, time = fade by particle age\n";
     file << "spawnFrequency=" << spawnFrequency << "   # Spawn interval - lower = denser trail (pixels)\n";
     file << "maxParticles=" << maxParticles << "     # Maximum number of particles\n";
+    file << "pathMode=" << PathModeName(pathMode) << "     # linear = straight segments, spline = curve through the cursor samples\n";
+    file << "filterCutoff=" << filterCutoff << "     # Cursor smoothing at rest (Hz), 0 = off\n";
+    file << "filterBeta=" << filterBeta << "     # Less smoothing per pixel/second of cursor speed\n";
+    file << "deadZone=" << deadZone << "     # Ignore cursor jitter below this distance (pixels)\n\n";
+    
+    file << "# Rendering\n";
+    file << "batchRendering=" << (batchRendering ? "true" : "false") << "   # Draw the trail with one instanced draw call\n";
+    file << "showStats=" << (showStats ? "true" : "false") << "     # Print renderer statistics once per second\n";
+    file << "persistentBuffers=" << (persistentBuffers ? "true" : "false") << "   # Use persistently mapped upload buffers (GL 4.4)\n";
+    file << "boundingWindow=" << (boundingWindow ? "true" : "false") << "   # Size the overlay window to the trail instead of the screen\n";
+    file << "nativeOverlay=" << (nativeOverlay ? "true" : "false") << "   # Win32/X11 overlay instead of the OpenGL window\n";
+    file << "x11Backend=" << X11BackendName(x11Backend) << "   # X11 overlay compositing: shm = CPU + MIT-SHM, render = XRender\n";
     
     std::cout << "Configuration saved to: " << filename << std::endl;
     return true;
@@ -149,8 +338,31 @@ bool Config::ParseCommandLine(int argc, char* argv[])
             std::cout << "  --texture <path>      Set texture path (default: " << texturePath << ")\n";
             std::cout << "  --fade-time <value>   Set fade time (default: " << fadeTime << ")\n";
             std::cout << "  --fade-rate <value>   Set fade rate (default: " << fadeRate << ")\n";
+            std::cout << "  --fade-mode <mode>    Fade per 'frame' or by 'time' (default: " << FadeModeName(fadeMode) << ")\n";
             std::cout << "  --density <value>     Set spawn density (default: " << spawnFrequency << ")\n";
             std::cout << "  --particles <value>   Set max particles (default: " << maxParticles << ")\n";
+            std::cout << "  --path-mode <mode>    Join cursor samples with 'linear' segments or a 'spline' (default: " << PathModeName(pathMode) << ")\n";
+            std::cout << "  --filter-cutoff <hz>  Cursor smoothing cutoff at rest, 0 = off (default: " << filterCutoff << ")\n";
+            std::cout << "  --filter-beta <value> Cutoff increase per pixel/second of speed (default: " << filterBeta << ")\n";
+            std::cout << "  --dead-zone <pixels>  Ignore filtered cursor moves shorter than this (default: " << deadZone << ")\n";
+            std::cout << "  --no-batch            Draw every particle with its own draw call\n";
+            std::cout << "  --stats               Print renderer statistics once per second\n";
+            std::cout << "  --no-persistent       Upload with buffer orphaning instead of persistent mapping\n";
+            std::cout << "  --bounding-window     Size the overlay window to the trail instead of the screen\n";
+            std::cout << "  --no-native-overlay   Use the OpenGL window instead of the Win32 or X11 overlay\n";
+            std::cout << "  --x11-backend <name>  X11 overlay compositing, 'shm' or 'render' (default: " << X11BackendName(x11Backend) << ")\n";
+            std::cout << "  --record-trace <file> Record the cursor to a trace file\n";
+            std::cout << "  --replay-trace <file> Replay a cursor trace instead of the live cursor, exit at its end\n";
+            std::cout << "  --replay-step <sec>   Replay with a fixed timestep instead of the recorded one\n";
+            std::cout << "  --no-input-thread     Read the X11 pointer once per frame instead of on an input thread\n";
+            std::cout << "  --sim-rate <hz>       Simulate on a thread of its own at this rate, 0 = once per frame (default: " << simulationRate << ")\n";
+            std::cout << "  --headless            Render offscreen through EGL, without a window or display\n";
+            std::cout << "  --resolution <WxH>    Headless framebuffer size (default: " << headlessWidth << "x" << headlessHeight << ")\n";
+            std::cout << "  --dump-frames <dir>   Write every headless frame to a directory\n";
+            std::cout << "  --dump-format <fmt>   Dump frames as 'png' or 'raw' RGBA (default: png)\n";
+            std::cout << "  --capture-at <t,...>  Dump or check only the frames at these trace times (seconds)\n";
+            std::cout << "  --golden <dir>        Check headless frames against the golden images in a directory\n";
+            std::cout << "  --golden-threshold <value> Perceptual difference allowed per pixel, 0-1 (default: " << goldenThreshold << ")\n";
             std::cout << "  --config <file>       Load config from file\n";
             std::cout << "  --save-config <file>  Save current config to file\n";
             std::cout << "  --help, -h            Show this help\n";
@@ -172,12 +384,144 @@ bool Config::ParseCommandLine(int argc, char* argv[])
             fadeRate = std::stof(argv[++i]);
             foundArgs = true;
         }
+        else if (arg == "--fade-mode" && i + 1 < argc) {
+            try {
+                fadeMode = ParseFadeMode(argv[++i]);
+            }
+            catch (const std::exception& e) {
+                std::cout << "Warning: Invalid --fade-mode: " << e.what() << std::endl;
+            }
+            foundArgs = true;
+        }
+        else if (arg == "--path-mode" && i + 1 < argc) {
+            try {
+                pathMode = ParsePathMode(argv[++i]);
+            }
+            catch (const std::exception& e) {
+                std::cout << "Warning: Invalid --path-mode: " << e.what() << std::endl;
+            }
+            foundArgs = true;
+        }
+        else if (arg == "--filter-cutoff" && i + 1 < argc) {
+            filterCutoff = std::max(0.0f, std::stof(argv[++i]));
+            foundArgs = true;
+        }
+        else if (arg == "--filter-beta" && i + 1 < argc) {
+            filterBeta = std::max(0.0f, std::stof(argv[++i]));
+            foundArgs = true;
+        }
+        else if (arg == "--dead-zone" && i + 1 < argc) {
+            deadZone = std::max(0.0f, std::stof(argv[++i]));
+            foundArgs = true;
+        }
         else if (arg == "--density" && i + 1 < argc) {
             spawnFrequency = std::stof(argv[++i]);
             foundArgs = true;
         }
         else if (arg == "--particles" && i + 1 < argc) {
-            maxParticles = std::stoi(argv[++i]);
+            try {
+                maxParticles = ParsePositiveInt(argv[++i]);
+            }
+            catch (const std::exception& e) {
+                std::cout << "Warning: Invalid --particles: " << e.what() << std::endl;
+            }
+            foundArgs = true;
+        }
+        else if (arg == "--no-batch") {
+            batchRendering = false;
+            foundArgs = true;
+        }
+        else if (arg == "--stats") {
+            showStats = true;
+            foundArgs = true;
+        }
+        else if (arg == "--no-persistent") {
+            persistentBuffers = false;
+            foundArgs = true;
+        }
+        else if (arg == "--bounding-window") {
+            boundingWindow = true;
+            foundArgs = true;
+        }
+        else if (arg == "--sim-rate" && i + 1 < argc) {
+            simulationRate = std::max(0.0f, std::stof(argv[++i]));
+            foundArgs = true;
+        }
+        else if (arg == "--no-input-thread") {
+            inputThread = false;
+            foundArgs = true;
+        }
+        else if (arg == "--no-native-overlay") {
+            nativeOverlay = false;
+            foundArgs = true;
+        }
+        else if (arg == "--x11-backend" && i + 1 < argc) {
+            try {
+                x11Backend = ParseX11Backend(argv[++i]);
+            }
+            catch (const std::exception& e) {
+                std::cout << "Warning: Invalid --x11-backend: " << e.what() << std::endl;
+            }
+            foundArgs = true;
+        }
+        else if (arg == "--record-trace" && i + 1 < argc) {
+            recordTrace = argv[++i];
+            foundArgs = true;
+        }
+        else if (arg == "--replay-trace" && i + 1 < argc) {
+            replayTrace = argv[++i];
+            foundArgs = true;
+        }
+        else if (arg == "--replay-step" && i + 1 < argc) {
+            try {
+                replayStep = ParsePositive(argv[++i]);
+            }
+            catch (const std::exception& e) {
+                std::cout << "Warning: Invalid --replay-step: " << e.what() << std::endl;
+            }
+            foundArgs = true;
+        }
+        else if (arg == "--headless") {
+            headless = true;
+            foundArgs = true;
+        }
+        else if (arg == "--resolution" && i + 1 < argc) {
+            try {
+                ParseResolution(argv[++i], headlessWidth, headlessHeight);
+            }
+            catch (const std::exception& e) {
+                std::cout << "Warning: Invalid --resolution: " << e.what() << std::endl;
+            }
+            foundArgs = true;
+        }
+        else if (arg == "--dump-frames" && i + 1 < argc) {
+            dumpFrames = argv[++i];
+            foundArgs = true;
+        }
+        else if (arg == "--dump-format" && i + 1 < argc) {
+            try {
+                dumpFormat = ParseDumpFormat(argv[++i]);
+            }
+            catch (const std::exception& e) {
+                std::cout << "Warning: Invalid --dump-format: " << e.what() << std::endl;
+            }
+            foundArgs = true;
+        }
+        else if (arg == "--capture-at" && i + 1 < argc) {
+            try {
+                captureAt = ParseTimes(argv[++i]);
+            }
+            catch (const std::exception& e) {
+                std::cout << "Warning: Invalid --capture-at: " << e.what() << std::endl;
+            }
+            foundArgs = true;
+        }
+        else if (arg == "--golden" && i + 1 < argc) {
+            goldenDir = argv[++i];
+            foundArgs = true;
+        }
+        else if (arg == "--golden-threshold" && i + 1 < argc) {
+            goldenThreshold = std::stof(argv[++i]);
             foundArgs = true;
         }
         else if (arg == "--config" && i + 1 < argc) {
@@ -200,8 +544,45 @@ void Config::PrintConfig() const
     std::cout << "Texture Path:     " << texturePath << std::endl;
     std::cout << "Fade Time:        " << fadeTime << " seconds" << std::endl;
     std::cout << "Fade Rate:        " << fadeRate << " per frame" << std::endl;
+    std::cout << "Fade Mode:        " << FadeModeName(fadeMode) << std::endl;
     std::cout << "Spawn Frequency:  " << spawnFrequency << " pixels" << std::endl;
     std::cout << "Max Particles:    " << maxParticles << std::endl;
+    std::cout << "Path Mode:        " << PathModeName(pathMode) << std::endl;
+    std::cout << "Cursor Filter:    " << filterCutoff << " Hz, beta " << filterBeta << ", dead zone " << deadZone << " pixels" << std::endl;
+    std::cout << "Batch Rendering:  " << (batchRendering ? "on" : "off") << std::endl;
+    std::cout << "Show Stats:       " << (showStats ? "on" : "off") << std::endl;
+    std::cout << "Persistent Bufs:  " << (persistentBuffers ? "on" : "off") << std::endl;
+    std::cout << "Bounding Window:  " << (boundingWindow ? "on" : "off") << std::endl;
+    std::cout << "Native Overlay:   " << (nativeOverlay ? "on" : "off") << std::endl;
+#ifndef _WIN32
+    std::cout << "X11 Backend:      " << X11BackendName(x11Backend) << std::endl;
+#endif
+    if (!replayTrace.empty()) {
+        std::cout << "Cursor Input:     replay " << replayTrace;
+        if (replayStep > 0) {
+            std::cout << " every " << replayStep << " seconds";
+        }
+        std::cout << std::endl;
+    }
+    else if (!recordTrace.empty()) {
+        std::cout << "Cursor Input:     live, recorded to " << recordTrace << std::endl;
+    }
+#ifndef _WIN32
+    std::cout << "Input Thread:     " << (inputThread ? "on" : "off") << std::endl;
+#endif
+    if (simulationRate > 0) {
+        std::cout << "Simulation:       own thread at " << simulationRate << " Hz" << std::endl;
+    }
+    if (headless) {
+        std::cout << "Headless:         " << headlessWidth << "x" << headlessHeight;
+        if (!dumpFrames.empty()) {
+            std::cout << ", " << (dumpFormat == DUMP_PNG ? "png" : "raw") << " frames to " << dumpFrames;
+        }
+        if (!goldenDir.empty()) {
+            std::cout << ", checked against " << goldenDir;
+        }
+        std::cout << std::endl;
+    }
     std::cout << "=================================\n" << std::endl;
 }
 
@@ -211,6 +592,35 @@ void Config::SetDefaults()
     texturePath = "cursortrail.png";
     fadeTime = 1.0f;
     fadeRate = 0.05f;
+    fadeMode = FADE_TIME;
     spawnFrequency = 6.0f;
     maxParticles = 2048;
+    pathMode = PATH_LINEAR;
+    filterCutoff = 0.0f;
+    filterBeta = 0.05f;
+    deadZone = 0.0f;
+    batchRendering = true;
+    showStats = false;
+    persistentBuffers = true;
+    boundingWindow = false;
+    nativeOverlay = true;
+    x11Backend = X11_SHM;
+    recordTrace.clear();
+    replayTrace.clear();
+    replayStep = 0.0f;
+    inputThread = true;
+    simulationRate = 0.0f;
+    headless = false;
+    headlessWidth = 1920;
+    headlessHeight = 1080;
+    dumpFrames.clear();
+    dumpFormat = DUMP_PNG;
+    captureAt.clear();
+    goldenDir.clear();
+    goldenThreshold = 0.1f;
+}
+
+float Config::ParticleLifetime() const
+{
+    return fadeTime / (fadeRate * FadeReferenceRate);
 }
\ No newline at end of file
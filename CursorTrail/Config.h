@@ -2,6 +2,31 @@
 #define CONFIG_H
 
 #include <string>
+#include <vector>
+
+// How particle opacity decreases over time
+enum FadeMode {
+    FADE_FRAME,     // subtract fadeRate on every rendered frame (depends on the frame rate)
+    FADE_TIME       // evaluate opacity from spawn time and lifetime (same speed at any frame rate)
+};
+
+// How the emitter connects consecutive cursor samples
+enum PathMode {
+    PATH_LINEAR,    // straight segments
+    PATH_SPLINE     // centripetal Catmull-Rom curve through the recent samples
+};
+
+// File format of frames dumped in headless mode
+enum DumpFormat {
+    DUMP_PNG,   // 8-bit RGBA PNG with uncompressed deflate blocks: fast to write, any viewer reads it
+    DUMP_RAW    // tightly packed RGBA rows, top row first, no header
+};
+
+// How the X11 overlay composites its frames
+enum X11Backend {
+    X11_SHM,        // blend on the CPU, push the changed tiles through MIT-SHM
+    X11_RENDER      // blend in the X server with XRender, only draw requests cross the socket
+};
 
 // Configuration structure for cursor trail customization
 struct Config
@@ -13,8 +38,38 @@ struct Config
     // Trail behavior
     float fadeTime;             // How long particles last (default: 1.0)
     float fadeRate;             // How fast particles fade per frame (default: 0.05)
+    FadeMode fadeMode;          // Per-frame or time-based fading (default: FADE_TIME)
     float spawnFrequency;       // Interpolation interval - lower = more dense trail (default: 6.0)
     int maxParticles;           // Maximum number of particles (default: 2048)
+    PathMode pathMode;          // Straight or curved path between cursor samples (default: PATH_LINEAR)
+    float filterCutoff;         // One Euro filter cutoff of a resting cursor in Hz, 0 = no smoothing (default: 0)
+    float filterBeta;           // Rise of that cutoff per pixel/second of cursor speed (default: 0.05)
+    float deadZone;             // Filtered moves shorter than this are ignored (pixels, default: 0)
+    
+    // Rendering
+    bool batchRendering;        // Draw the whole trail with one instanced draw call (default: true)
+    bool showStats;             // Print renderer statistics once per second (default: false)
+    bool persistentBuffers;     // Stream uploads through persistently mapped buffers when GL 4.4 is available (default: true)
+    bool boundingWindow;        // Shrink the overlay window to the trail bounding box (default: false)
+    bool nativeOverlay;         // Use the Win32 or X11 overlay instead of the OpenGL window when built (default: true)
+    X11Backend x11Backend;      // Compositing of the X11 overlay (default: X11_SHM)
+    
+    // Cursor input (command line only)
+    std::string recordTrace;    // Record the cursor to this trace file (default: none)
+    std::string replayTrace;    // Replay this trace file instead of the live cursor (default: none)
+    float replayStep;           // Fixed replay timestep in seconds, 0 = recorded timestamps (default: 0)
+    bool inputThread;           // Read the X11 pointer on its own thread instead of once per frame (default: true)
+    float simulationRate;       // Simulate on a thread of its own this many times per second, 0 = once per frame (default: 0)
+    
+    // Headless mode (command line only)
+    bool headless;              // Render offscreen without a window or display (default: false)
+    int headlessWidth;          // Offscreen framebuffer size (default: 1920x1080)
+    int headlessHeight;
+    std::string dumpFrames;     // Directory to write every headless frame to (default: none)
+    DumpFormat dumpFormat;      // Format of dumped frames (default: DUMP_PNG)
+    std::vector<float> captureAt;   // Trace times (seconds) of the frames to dump or check, empty = every frame
+    std::string goldenDir;      // Compare the captured frames with the golden images in this directory (default: none)
+    float goldenThreshold;      // Perceptual difference a pixel may have from its golden image, 0-1 (default: 0.1)
     
     // Default constructor with sensible defaults
     Config()
@@ -22,8 +77,27 @@ struct Config
         , texturePath("cursortrail.png")
         , fadeTime(1.0f)
         , fadeRate(0.05f)
+        , fadeMode(FADE_TIME)
         , spawnFrequency(6.0f)  // SPRITE_SIZE / 2.5
         , maxParticles(2048)
+        , pathMode(PATH_LINEAR)
+        , filterCutoff(0.0f)
+        , filterBeta(0.05f)
+        , deadZone(0.0f)
+        , batchRendering(true)
+        , showStats(false)
+        , persistentBuffers(true)
+        , boundingWindow(false)
+        , nativeOverlay(true)
+        , x11Backend(X11_SHM)
+        , replayStep(0.0f)
+        , inputThread(true)
+        , simulationRate(0.0f)
+        , headless(false)
+        , headlessWidth(1920)
+        , headlessHeight(1080)
+        , dumpFormat(DUMP_PNG)
+        , goldenThreshold(0.1f)
     {
     }
     
@@ -39,6 +113,12 @@ struct Config
     // Print current configuration
     void PrintConfig() const;
     
+    // Seconds a particle stays visible when fading by time. fadeRate is
+    // defined per frame at FadeReferenceRate frames per second, so the
+    // time-based fade matches the per-frame fade at that rate.
+    float ParticleLifetime() const;
+    static const float FadeReferenceRate;
+    
 private:
     void SetDefaults();
 };
@@ -0,0 +1,359 @@
+// Like the particle kernels, the blend loops use the glm SIMD layer only
+// for the architecture detection and the intrinsic headers.
+#ifndef GLM_FORCE_INTRINSICS
+#define GLM_FORCE_INTRINSICS
+#endif
+#include <glm/detail/setup.hpp>
+#include <glm/simd/common.h>
+
+#include "CpuCompositor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace
+{
+    // x / 255 rounded, for any x that fits in 16 bits with the rounding
+    // bias; the vector kernels use the same formula so every variant
+    // produces identical pixels
+    inline unsigned int Div255(unsigned int x)
+    {
+        return ((x + 128) * 257) >> 16;
+    }
+
+    // premultiplied source-over of s scaled by scale / 255 onto d. Both
+    // products are summed before the single rounding division, which keeps
+    // stacked sprites from drifting; the sum still fits in 16 bits
+    inline uint32_t BlendPixel(uint32_t d, uint32_t s, unsigned int scale)
+    {
+        unsigned int inverse = 255 - Div255((s >> 24) * scale);
+        uint32_t out = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            unsigned int sum = ((s >> shift) & 0xFF) * scale + ((d >> shift) & 0xFF) * inverse;
+            out |= std::min(Div255(sum), 255u) << shift;
+        }
+        return out;
+    }
+
+    void BlendScalar(uint32_t* dst, const uint32_t* src, size_t begin, size_t end, unsigned int scale)
+    {
+        for (size_t i = begin; i < end; i++) {
+            dst[i] = BlendPixel(dst[i], src[i], scale);
+        }
+    }
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    // four pixels; every channel is widened to 16 bits, the products fit
+    inline __m128i Div255x8(__m128i x)
+    {
+        return _mm_mulhi_epu16(_mm_add_epi16(x, _mm_set1_epi16(128)), _mm_set1_epi16(257));
+    }
+
+    inline __m128i Blend4(__m128i d, __m128i s, __m128i scale)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(255);
+        __m128i sourceLo = Div255x8(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), scale));
+        __m128i sourceHi = Div255x8(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), scale));
+        // alpha is the fourth channel of BGRA, broadcast it over its pixel
+        __m128i inverseLo = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(sourceLo, 0xFF), 0xFF));
+        __m128i inverseHi = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(sourceHi, 0xFF), 0xFF));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), scale), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inverseLo));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), scale), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inverseHi));
+        // packing saturates the rare 256 like the scalar clamp
+        return _mm_packus_epi16(Div255x8(lo), Div255x8(hi));
+    }
+#endif
+
+#if GLM_ARCH & GLM_ARCH_AVX2_BIT
+    // eight pixels; unpack and pack work per 128-bit lane, so the pixel order is kept
+    inline __m256i Div255x16(__m256i x)
+    {
+        return _mm256_mulhi_epu16(_mm256_add_epi16(x, _mm256_set1_epi16(128)), _mm256_set1_epi16(257));
+    }
+
+    inline __m256i Blend8(__m256i d, __m256i s, __m256i scale)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i full = _mm256_set1_epi16(255);
+        __m256i sourceLo = Div255x16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), scale));
+        __m256i sourceHi = Div255x16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), scale));
+        __m256i inverseLo = _mm256_sub_epi16(full, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sourceLo, 0xFF), 0xFF));
+        __m256i inverseHi = _mm256_sub_epi16(full, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sourceHi, 0xFF), 0xFF));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), scale), _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inverseLo));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), scale), _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inverseHi));
+        // packing saturates the rare 256 like the scalar clamp
+        return _mm256_packus_epi16(Div255x16(lo), Div255x16(hi));
+    }
+
+    const char* const ArchName = "AVX2";
+
+    void BlendRow(uint32_t* dst, const uint32_t* src, size_t count, unsigned int scale)
+    {
+        size_t i = 0;
+        __m256i scale16 = _mm256_set1_epi16(static_cast<short>(scale));
+        for (; i + 8 <= count; i += 8) {
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), Blend8(d, s, scale16));
+        }
+        // sprites are narrow, a four pixel step saves most of the scalar tail
+        if (i + 4 <= count) {
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), Blend4(d, s, _mm_set1_epi16(static_cast<short>(scale))));
+            i += 4;
+        }
+        BlendScalar(dst, src, i, count, scale);
+    }
+
+#elif GLM_ARCH & GLM_ARCH_SSE2_BIT
+
+    const char* const ArchName = "SSE2";
+
+    void BlendRow(uint32_t* dst, const uint32_t* src, size_t count, unsigned int scale)
+    {
+        size_t i = 0;
+        __m128i scale16 = _mm_set1_epi16(static_cast<short>(scale));
+        for (; i + 4 <= count; i += 4) {
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), Blend4(d, s, scale16));
+        }
+        BlendScalar(dst, src, i, count, scale);
+    }
+
+#else
+
+    const char* const ArchName = "scalar";
+
+    void BlendRow(uint32_t* dst, const uint32_t* src, size_t count, unsigned int scale)
+    {
+        BlendScalar(dst, src, 0, count, scale);
+    }
+
+#endif
+}
+
+CpuCompositor::CpuCompositor()
+    : imageWidth(0), imageHeight(0), spriteSize(0), pixels(nullptr), width(0), height(0), stride(0),
+      pool(new WorkerPool())
+{
+
+}
+
+const char* CpuCompositor::Arch()
+{
+    return ArchName;
+}
+
+void CpuCompositor::SetSprite(const unsigned char* rgba, int width, int height)
+{
+    this->image.assign(rgba, rgba + static_cast<size_t>(width) * height * 4);
+    this->imageWidth = width;
+    this->imageHeight = height;
+    this->spriteSize = 0;
+}
+
+const uint32_t* CpuCompositor::ResampledSprite(int size)
+{
+    this->prepare(std::max(1, size));
+    return this->spriteSize == 0 ? nullptr : this->sprite.data();
+}
+
+void CpuCompositor::SetTarget(void* pixels, int width, int height, int stride)
+{
+    this->pixels = static_cast<unsigned char*>(pixels);
+    this->width = width;
+    this->height = height;
+    this->stride = stride;
+}
+
+void CpuCompositor::Clear(const DamageRect& rect)
+{
+    DamageRect area = rect.Intersect(DamageRect(0, 0, this->width, this->height));
+    for (int y = area.y; y < area.y + area.height; y++) {
+        std::memset(this->pixels + static_cast<size_t>(y) * this->stride + area.x * 4, 0, area.width * 4);
+    }
+}
+
+unsigned int CpuCompositor::Draw(const ParticleStore& particles, FadeMode mode, float now, float spriteSize,
+                                 int originX, int originY, const DamageRect& clip)
+{
+    this->drawnTiles.clear();
+    int size = std::max(1, static_cast<int>(std::lround(spriteSize)));
+    this->prepare(size);
+    DamageRect area = clip.Intersect(DamageRect(0, 0, this->width, this->height));
+    unsigned int live = particles.LiveCount();
+    if (this->spriteSize == 0 || area.Empty() || live == 0) {
+        return 0;
+    }
+
+    // the particles are split into one chunk per thread, each chunk bins
+    // its sprites into its own counters so no two threads share any
+    unsigned int tilesX = (this->width + TileSize - 1) / TileSize;
+    unsigned int tiles = tilesX * ((this->height + TileSize - 1) / TileSize);
+    unsigned int chunks = std::max(1u, std::min(this->pool->Threads(), live / MinChunk));
+    unsigned int chunkLength = (live + chunks - 1) / chunks;
+    this->stamps.resize(live);
+    this->tileOffsets.assign(static_cast<size_t>(chunks) * tiles, 0);
+    this->chunkDrawn.assign(chunks, 0);
+
+    const float* xs = particles.Attribute(PARTICLE_X);
+    const float* ys = particles.Attribute(PARTICLE_Y);
+    auto forEachTile = [&](const Placement& stamp, auto visit) {
+        DamageRect rect = DamageRect(stamp.x, stamp.y, size, size).Intersect(area);
+        for (int ty = rect.y / TileSize; ty <= (rect.y + rect.height - 1) / TileSize; ty++) {
+            for (int tx = rect.x / TileSize; tx <= (rect.x + rect.width - 1) / TileSize; tx++) {
+                visit(ty * tilesX + tx);
+            }
+        }
+    };
+
+    // 1. sprite placement and tile counts per chunk
+    this->pool->Run(chunks, [&](unsigned int c) {
+        unsigned int* counts = &this->tileOffsets[static_cast<size_t>(c) * tiles];
+        for (unsigned int n = c * chunkLength; n < std::min(live, (c + 1) * chunkLength); n++) {
+            unsigned int i = (particles.Tail() + n) % particles.Capacity();
+            float alpha = std::min(1.0f, std::max(0.0f, particles.AlphaAt(i, mode, now)));
+            Placement& stamp = this->stamps[n];
+            // nearest whole pixel to the top-left corner of the centered sprite
+            stamp.x = static_cast<int>(std::floor(xs[i] - size * 0.5f + 0.5f)) - originX;
+            stamp.y = static_cast<int>(std::floor(ys[i] - size * 0.5f + 0.5f)) - originY;
+            stamp.scale = static_cast<unsigned int>(alpha * 255.0f + 0.5f);
+            if (stamp.scale == 0 || DamageRect(stamp.x, stamp.y, size, size).Intersect(area).Empty()) {
+                stamp.scale = 0;
+                continue;
+            }
+            forEachTile(stamp, [&](unsigned int tile) { counts[tile]++; });
+            this->chunkDrawn[c]++;
+        }
+    });
+
+    // 2. counts to write offsets: tile by tile, and inside a tile chunk by
+    // chunk, which keeps every tile's sprites in spawn order
+    this->tileStart.resize(tiles + 1);
+    unsigned int offset = 0;
+    for (unsigned int t = 0; t < tiles; t++) {
+        this->tileStart[t] = offset;
+        for (unsigned int c = 0; c < chunks; c++) {
+            unsigned int& entry = this->tileOffsets[static_cast<size_t>(c) * tiles + t];
+            unsigned int count = entry;
+            entry = offset;
+            offset += count;
+        }
+        if (offset > this->tileStart[t]) {
+            this->drawnTiles.push_back(DamageRect((t % tilesX) * TileSize, (t / tilesX) * TileSize, TileSize, TileSize).Intersect(area));
+            this->activeTiles.push_back(t);
+        }
+    }
+    this->tileStart[tiles] = offset;
+    this->binned.resize(offset);
+
+    // 3. sprite indices into the tile bins
+    this->pool->Run(chunks, [&](unsigned int c) {
+        unsigned int* offsets = &this->tileOffsets[static_cast<size_t>(c) * tiles];
+        for (unsigned int n = c * chunkLength; n < std::min(live, (c + 1) * chunkLength); n++) {
+            if (this->stamps[n].scale != 0) {
+                forEachTile(this->stamps[n], [&](unsigned int tile) { this->binned[offsets[tile]++] = n; });
+            }
+        }
+    });
+
+    // 4. every tile is blended by one thread, tiles without sprites are skipped
+    this->pool->Run(static_cast<unsigned int>(this->activeTiles.size()), [&](unsigned int k) {
+        unsigned int tile = this->activeTiles[k];
+        const DamageRect& rect = this->drawnTiles[k];
+        for (unsigned int j = this->tileStart[tile]; j < this->tileStart[tile + 1]; j++) {
+            const Placement& stamp = this->stamps[this->binned[j]];
+            this->stamp(stamp.x, stamp.y, stamp.scale, rect);
+        }
+    });
+    this->activeTiles.clear();
+
+    unsigned int total = 0;
+    for (unsigned int d : this->chunkDrawn) {
+        total += d;
+    }
+    return total;
+}
+
+void CpuCompositor::SetThreads(unsigned int threads)
+{
+    this->pool.reset(new WorkerPool(threads));
+}
+
+unsigned int CpuCompositor::Threads() const
+{
+    return this->pool->Threads();
+}
+
+void CpuCompositor::Stamp(int x, int y, int size, float alpha, const DamageRect& clip)
+{
+    this->prepare(std::max(1, size));
+    unsigned int scale = static_cast<unsigned int>(std::min(1.0f, std::max(0.0f, alpha)) * 255.0f + 0.5f);
+    if (this->spriteSize == 0 || scale == 0) {
+        return;
+    }
+    this->stamp(x, y, scale, clip.Intersect(DamageRect(0, 0, this->width, this->height)));
+}
+
+void CpuCompositor::prepare(int size)
+{
+    if (size == this->spriteSize || this->image.empty()) {
+        return;
+    }
+
+    // premultiply before filtering so transparent texels do not bleed their color
+    std::vector<float> premultiplied(this->image.size());
+    for (size_t i = 0; i < this->image.size(); i += 4) {
+        float a = this->image[i + 3] / 255.0f;
+        premultiplied[i + 0] = this->image[i + 0] * a;
+        premultiplied[i + 1] = this->image[i + 1] * a;
+        premultiplied[i + 2] = this->image[i + 2] * a;
+        premultiplied[i + 3] = static_cast<float>(this->image[i + 3]);
+    }
+
+    // bilinear samples at the sprite pixel centers, like GL_LINEAR on the trail texture
+    this->sprite.resize(static_cast<size_t>(size) * size);
+    for (int y = 0; y < size; y++) {
+        float v = std::min(std::max((y + 0.5f) * this->imageHeight / size - 0.5f, 0.0f), this->imageHeight - 1.0f);
+        int y0 = static_cast<int>(v);
+        int y1 = std::min(y0 + 1, this->imageHeight - 1);
+        float fy = v - y0;
+        for (int x = 0; x < size; x++) {
+            float u = std::min(std::max((x + 0.5f) * this->imageWidth / size - 0.5f, 0.0f), this->imageWidth - 1.0f);
+            int x0 = static_cast<int>(u);
+            int x1 = std::min(x0 + 1, this->imageWidth - 1);
+            float fx = u - x0;
+            const float* p00 = &premultiplied[(static_cast<size_t>(y0) * this->imageWidth + x0) * 4];
+            const float* p10 = &premultiplied[(static_cast<size_t>(y0) * this->imageWidth + x1) * 4];
+            const float* p01 = &premultiplied[(static_cast<size_t>(y1) * this->imageWidth + x0) * 4];
+            const float* p11 = &premultiplied[(static_cast<size_t>(y1) * this->imageWidth + x1) * 4];
+            unsigned int channel[4];
+            for (int c = 0; c < 4; c++) {
+                float top = p00[c] + (p10[c] - p00[c]) * fx;
+                float bottom = p01[c] + (p11[c] - p01[c]) * fx;
+                channel[c] = static_cast<unsigned int>(std::min(255.0f, top + (bottom - top) * fy + 0.5f));
+            }
+            // RGBA -> BGRA
+            this->sprite[static_cast<size_t>(y) * size + x] = channel[2] | channel[1] << 8 | channel[0] << 16 | channel[3] << 24;
+        }
+    }
+    this->spriteSize = size;
+}
+
+void CpuCompositor::stamp(int x, int y, unsigned int scale, const DamageRect& clip)
+{
+    DamageRect area = DamageRect(x, y, this->spriteSize, this->spriteSize).Intersect(clip);
+    if (area.Empty()) {
+        return;
+    }
+    for (int row = area.y; row < area.y + area.height; row++) {
+        uint32_t* dst = reinterpret_cast<uint32_t*>(this->pixels + static_cast<size_t>(row) * this->stride) + area.x;
+        const uint32_t* src = &this->sprite[static_cast<size_t>(row - y) * this->spriteSize + (area.x - x)];
+        BlendRow(dst, src, area.width, scale);
+    }
+}
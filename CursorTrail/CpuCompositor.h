@@ -0,0 +1,87 @@
+#ifndef CPU_COMPOSITOR_H
+#define CPU_COMPOSITOR_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "WorkerPool.h"
+#include "ParticleStore.h"
+#include "DamageTracker.h"
+#include "Config.h"
+
+// Software trail renderer for overlays that composite on the CPU. The
+// sprite is premultiplied and resampled once per sprite size, then each
+// particle is stamped into a premultiplied BGRA32 surface (the layout of
+// a 32-bit top-down DIB) with integer source-over kernels: SSE2 or AVX2
+// from the glm/simd architecture detection, scalar elsewhere. The
+// per-particle opacity scales the premultiplied sprite before blending.
+// Sprites are placed on whole pixels. Nothing here depends on the OS.
+//
+// The surface is split into TileSize square tiles. Each frame the sprites
+// are binned by the tiles their rectangle overlaps and a worker pool
+// blends whole tiles, so no two threads touch the same pixels and every
+// tile still receives its sprites in spawn order: the result does not
+// depend on the thread count. Tiles without sprites are skipped.
+class CpuCompositor
+{
+public:
+    static const int TileSize = 64;
+    // a particle chunk per thread is only worth it above this many particles
+    static const unsigned int MinChunk = 1024;
+
+    CpuCompositor();
+    // name of the instruction set the blend kernels were built for
+    static const char* Arch();
+    // copies a straight-alpha RGBA image, as loaded by stb_image
+    void         SetSprite(const unsigned char* rgba, int width, int height);
+    // the image premultiplied and resampled to size x size BGRA pixels,
+    // for renderers that blend elsewhere; null without an image
+    const uint32_t* ResampledSprite(int size);
+    // surface to draw into, stride in bytes; the memory is not owned
+    void         SetTarget(void* pixels, int width, int height, int stride);
+    // sets a rectangle of the surface to transparent black
+    void         Clear(const DamageRect& rect);
+    // stamps the live particles with sprites spriteSize wide centered on
+    // them. originX/Y are the particle coordinates of the surface top-left
+    // corner; nothing outside clip is written. Returns the sprites drawn
+    unsigned int Draw(const ParticleStore& particles, FadeMode mode, float now, float spriteSize,
+                      int originX, int originY, const DamageRect& clip);
+    // parts of the tiles that received sprites in the last Draw, clipped.
+    // Clearing them erases that frame's trail; the tiles of two frames
+    // together are the damage of the second one
+    const std::vector<DamageRect>& DrawnTiles() const { return this->drawnTiles; }
+    // threads blending tiles, 0 uses one per hardware thread (the default)
+    void         SetThreads(unsigned int threads);
+    unsigned int Threads() const;
+    // stamps one size x size sprite with its top-left corner at surface
+    // pixel (x, y) and opacity alpha (0..1)
+    void         Stamp(int x, int y, int size, float alpha, const DamageRect& clip);
+private:
+    // sprite placement of one particle, scale 0 when nothing is drawn
+    struct Placement
+    {
+        int          x, y;
+        unsigned int scale;
+    };
+
+    std::vector<unsigned char> image;   // straight-alpha RGBA source
+    int                   imageWidth, imageHeight;
+    std::vector<uint32_t> sprite;       // premultiplied BGRA, spriteSize x spriteSize
+    int                   spriteSize;   // 0 until the sprite is resampled
+    unsigned char*        pixels;
+    int                   width, height, stride;
+    std::unique_ptr<WorkerPool> pool;
+    // per-frame binning, kept to reuse the allocations
+    std::vector<Placement>    stamps;       // by live particle, oldest first
+    std::vector<unsigned int> tileOffsets;  // per chunk and tile: sprite counts, then write positions
+    std::vector<unsigned int> tileStart;    // first binned entry of every tile, plus the end
+    std::vector<unsigned int> binned;       // stamp indices grouped by tile
+    std::vector<unsigned int> activeTiles;
+    std::vector<unsigned int> chunkDrawn;   // sprites drawn per chunk
+    std::vector<DamageRect>   drawnTiles;
+    // resamples the image to size x size unless it already is
+    void prepare(int size);
+    void stamp(int x, int y, unsigned int scale, const DamageRect& clip);
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "CursorFilter.h"
+
+#include <cmath>
+
+
+namespace
+{
+    // cutoff of the speed estimate the position cutoff is derived from (Hz)
+    const double SpeedCutoff = 1.0;
+
+    // smoothing factor of an exponential low-pass filter with the given cutoff
+    double Smoothing(double cutoff, double dt)
+    {
+        double tau = 1.0 / (2.0 * 3.14159265358979 * cutoff);
+        return 1.0 / (1.0 + tau / dt);
+    }
+}
+
+CursorFilter::CursorFilter()
+{
+    this->Reset();
+}
+
+void CursorFilter::Reset()
+{
+    this->started = false;
+    this->time = 0.0;
+    this->rawX = this->rawY = 0.0;
+    this->x = this->y = 0.0;
+    this->speed = 0.0;
+    this->acceptedX = this->acceptedY = 0.0;
+}
+
+bool CursorFilter::Apply(double time, double& x, double& y, float minCutoff, float beta, float deadZone)
+{
+    if (!this->started) {
+        this->started = true;
+        this->time = time;
+        this->rawX = this->x = this->acceptedX = x;
+        this->rawY = this->y = this->acceptedY = y;
+        return true;
+    }
+
+    bool moved = x != this->rawX || y != this->rawY;
+    this->rawX = x;
+    this->rawY = y;
+    double dt = time - this->time;
+    this->time = time;
+
+    if (minCutoff > 0.0f && dt > 0.0) {
+        // One Euro filter: a low-passed speed raises the position cutoff
+        double dx = x - this->x;
+        double dy = y - this->y;
+        double speed = std::sqrt(dx * dx + dy * dy) / dt;
+        this->speed += Smoothing(SpeedCutoff, dt) * (speed - this->speed);
+        double smoothing = Smoothing(minCutoff + beta * this->speed, dt);
+        this->x += smoothing * dx;
+        this->y += smoothing * dy;
+    }
+    else {
+        this->x = x;
+        this->y = y;
+    }
+
+    double offsetX = this->x - this->acceptedX;
+    double offsetY = this->y - this->acceptedY;
+    if (offsetX * offsetX + offsetY * offsetY < static_cast<double>(deadZone) * deadZone) {
+        x = this->acceptedX;
+        y = this->acceptedY;
+        return !moved;
+    }
+    this->acceptedX = x = this->x;
+    this->acceptedY = y = this->y;
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef CURSOR_FILTER_H
+#define CURSOR_FILTER_H
+
+// Input filter in front of the trail emitter. A One Euro filter smooths
+// the cursor position: its cutoff frequency rises with the cursor speed,
+// so sensor jitter on a slow or parked mouse is averaged away while fast
+// motion passes with little lag. Filtered moves that stay within the dead
+// zone of the last accepted position are dropped, so a resting cursor
+// holds one position and spawns nothing.
+class CursorFilter
+{
+public:
+    CursorFilter();
+    // forgets the history, the next sample passes unfiltered
+    void Reset();
+    // filters the sample at the given time (seconds) in place. minCutoff
+    // is the cutoff at rest in Hz (0 turns smoothing off), beta how fast
+    // it rises per pixel per second. Returns false when the sample was a
+    // move that the filter suppressed; x and y then hold the last
+    // accepted position
+    bool Apply(double time, double& x, double& y, float minCutoff, float beta, float deadZone);
+private:
+    bool   started;
+    double time;
+    double rawX, rawY;          // last raw sample
+    double x, y;                // smoothed position
+    double speed;               // smoothed speed (pixels per second)
+    double acceptedX, acceptedY;
+};
+
+#endif
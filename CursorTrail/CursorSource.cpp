@@ -0,0 +1,155 @@
+#include "CursorSource.h"
+#include "Clock.h"
+#include "Config.h"
+
+#include <iostream>
+
+#ifdef CURSORTRAIL_GLFW
+#include <GLFW/glfw3.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+LiveCursorSource::LiveCursorSource(GLFWwindow* window)
+    : window(window), originX(0), originY(0)
+{
+}
+
+void LiveCursorSource::SetOrigin(int x, int y)
+{
+    this->originX = x;
+    this->originY = y;
+}
+
+bool LiveCursorSource::Next(CursorSample& sample)
+{
+    double xpos = this->last.x;
+    double ypos = this->last.y;
+
+    // Get global cursor position for proper system-wide cursor trail
+    // This fixes the issue on Windows 11 where glfwGetCursorPos returns
+    // window-relative coordinates instead of screen coordinates
+#ifdef _WIN32
+    POINT cursorPos;
+    if (GetCursorPos(&cursorPos)) {
+        xpos = static_cast<double>(cursorPos.x);
+        ypos = static_cast<double>(cursorPos.y);
+    }
+#ifdef CURSORTRAIL_GLFW
+    else if (this->window != nullptr) {
+        // Fallback to GLFW if Windows API fails
+        glfwGetCursorPos(this->window, &xpos, &ypos);
+        xpos += this->originX;
+        ypos += this->originY;
+    }
+#endif
+#elif defined(CURSORTRAIL_GLFW)
+    // On non-Windows systems, use GLFW (may need adjustment for Linux/macOS);
+    // the position is relative to the window, particles live in screen space
+    if (this->window != nullptr) {
+        glfwGetCursorPos(this->window, &xpos, &ypos);
+        xpos += this->originX;
+        ypos += this->originY;
+    }
+#endif
+
+    // an unreadable cursor keeps its last position
+    this->last = CursorSample(Clock::Seconds(), xpos, ypos);
+    sample = this->last;
+    return true;
+}
+
+
+RecordingCursorSource::RecordingCursorSource(std::unique_ptr<CursorSource> source)
+    : source(std::move(source))
+{
+}
+
+bool RecordingCursorSource::Open(const std::string& path)
+{
+    return this->writer.Open(path);
+}
+
+void RecordingCursorSource::SetOrigin(int x, int y)
+{
+    this->source->SetOrigin(x, y);
+}
+
+bool RecordingCursorSource::Next(CursorSample& sample)
+{
+    if (!this->source->Next(sample)) {
+        return false;
+    }
+    // the simulation sees the quantized sample a replay will produce
+    sample = this->writer.Append(sample);
+    return true;
+}
+
+bool RecordingCursorSource::Pending() const
+{
+    return this->source->Pending();
+}
+
+unsigned long long RecordingCursorSource::TakeDropped()
+{
+    return this->source->TakeDropped();
+}
+
+bool RecordingCursorSource::Wait(int timeoutMs)
+{
+    return this->source->Wait(timeoutMs);
+}
+
+void RecordingCursorSource::Interrupt()
+{
+    this->source->Interrupt();
+}
+
+
+ReplayCursorSource::ReplayCursorSource(double step)
+    : step(step), index(0)
+{
+}
+
+bool ReplayCursorSource::Open(const std::string& path)
+{
+    this->index = 0;
+    return this->reader.Open(path);
+}
+
+bool ReplayCursorSource::Next(CursorSample& sample)
+{
+    if (!this->reader.Next(sample)) {
+        return false;
+    }
+    if (this->step > 0.0) {
+        sample.time = this->index * this->step;
+    }
+    this->index++;
+    return true;
+}
+
+
+std::unique_ptr<CursorSource> CreateCursorSource(std::unique_ptr<CursorSource> live)
+{
+    if (!g_config.replayTrace.empty()) {
+        std::unique_ptr<ReplayCursorSource> replay(new ReplayCursorSource(g_config.replayStep));
+        if (!replay->Open(g_config.replayTrace)) {
+            return nullptr;
+        }
+        std::cout << "Replaying cursor trace " << g_config.replayTrace << std::endl;
+        return replay;
+    }
+    if (!g_config.recordTrace.empty()) {
+        std::unique_ptr<RecordingCursorSource> recording(new RecordingCursorSource(std::move(live)));
+        if (!recording->Open(g_config.recordTrace)) {
+            return nullptr;
+        }
+        std::cout << "Recording cursor trace to " << g_config.recordTrace << std::endl;
+        return recording;
+    }
+    return live;
+}
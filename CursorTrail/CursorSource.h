@@ -0,0 +1,111 @@
+#ifndef CURSOR_SOURCE_H
+#define CURSOR_SOURCE_H
+
+#include <memory>
+#include <string>
+
+#include "CursorTrace.h"
+
+struct GLFWwindow;
+
+// Where the simulation reads the cursor from. Every Update consumes one
+// sample, so a recorded trace replays the exact sequence of positions
+// and timestamps the simulation saw when it was recorded.
+class CursorSource
+{
+public:
+    virtual ~CursorSource() { }
+    // reads the cursor for the next simulation step, false once the source is exhausted
+    virtual bool Next(CursorSample& sample) = 0;
+    // true while samples taken since the last frame are still queued;
+    // sources that sample once per frame never have any
+    virtual bool Pending() const { return false; }
+    // samples lost since the last call; only sources that queue samples
+    // on another thread lose any, to a full queue
+    virtual unsigned long long TakeDropped() { return 0; }
+    // blocks until a sample is queued, Interrupt() is called or timeoutMs
+    // pass (-1: no timeout). False right away from sources that cannot
+    // wait because they read the cursor when asked
+    virtual bool Wait(int /*timeoutMs*/) { return false; }
+    // ends a Wait() on another thread
+    virtual void Interrupt() { }
+    // screen position of the window's top-left corner, for sources that
+    // read the cursor relative to the window
+    virtual void SetOrigin(int /*x*/, int /*y*/) { }
+};
+
+// The system cursor, timestamped with the system clock
+class LiveCursorSource : public CursorSource
+{
+public:
+    // window is used where the global cursor position is not available
+    // (every platform but Windows); the overlay passes none
+    LiveCursorSource(GLFWwindow* window = nullptr);
+    bool Next(CursorSample& sample) override;
+    void SetOrigin(int x, int y) override;
+private:
+    GLFWwindow*  window;
+    int          originX, originY;
+    CursorSample last;
+};
+
+// Passes another source through and records it to a trace file
+class RecordingCursorSource : public CursorSource
+{
+public:
+    RecordingCursorSource(std::unique_ptr<CursorSource> source);
+    bool Open(const std::string& path);
+    bool Next(CursorSample& sample) override;
+    bool Pending() const override;
+    unsigned long long TakeDropped() override;
+    bool Wait(int timeoutMs) override;
+    void Interrupt() override;
+    void SetOrigin(int x, int y) override;
+private:
+    std::unique_ptr<CursorSource> source;
+    CursorTraceWriter             writer;
+};
+
+// Plays a trace file back. With a step the samples are spaced step
+// seconds apart instead of using the recorded timestamps.
+class ReplayCursorSource : public CursorSource
+{
+public:
+    ReplayCursorSource(double step = 0.0);
+    bool Open(const std::string& path);
+    bool Next(CursorSample& sample) override;
+private:
+    CursorTraceReader reader;
+    double            step;
+    unsigned int      index;
+};
+
+// Feeds the samples of one frame to update: every sample still queued,
+// or a single one from sources that sample once per frame. queued counts
+// the queued samples consumed, dropped the ones the source lost since the
+// last frame. False once the source is exhausted
+template <typename Update>
+bool ReadFrameSamples(CursorSource& source, unsigned long long& queued, unsigned long long& dropped, Update update)
+{
+    dropped += source.TakeDropped();
+    CursorSample sample;
+    if (!source.Pending()) {
+        if (!source.Next(sample)) {
+            return false;
+        }
+        update(sample);
+        return true;
+    }
+    while (source.Pending() && source.Next(sample)) {
+        queued++;
+        update(sample);
+    }
+    return true;
+}
+
+// Source selected by the configuration: live wrapped by a recorder with
+// recordTrace, or a replay of replayTrace. Null when a trace file cannot
+// be opened.
+std::unique_ptr<CursorSource> CreateCursorSource(std::unique_ptr<CursorSource> live);
+
+#endif
@@ -0,0 +1,259 @@
+#include "CursorTrace.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char     TraceMagic[4] = { 'C', 'T', 'R', 'C' };
+static const uint32_t TraceVersion = 1;
+static const size_t   TraceHeaderSize = 16;
+// positions are stored in fixed point with this many steps per pixel
+static const double   PositionScale = 16.0;
+// times are stored in microseconds
+static const double   TimeScale = 1000000.0;
+
+static uint64_t ZigZag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t UnZigZag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static void StoreU32(unsigned char* out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+static uint32_t LoadU32(const unsigned char* in)
+{
+    return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+        static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+
+CursorTraceWriter::CursorTraceWriter()
+    : count(0), startTime(0.0), lastTime(0), lastX(0), lastY(0)
+{
+}
+
+CursorTraceWriter::~CursorTraceWriter()
+{
+    this->Close();
+}
+
+bool CursorTraceWriter::Open(const std::string& path)
+{
+    this->file.open(path, std::ios::binary | std::ios::trunc);
+    if (!this->file.is_open()) {
+        std::cout << "ERROR::CURSOR_TRACE: Failed to create trace file: " << path << std::endl;
+        return false;
+    }
+    // the sample count is filled in by Close()
+    unsigned char header[TraceHeaderSize] = { };
+    std::memcpy(header, TraceMagic, sizeof(TraceMagic));
+    StoreU32(header + 4, TraceVersion);
+    this->file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    this->count = 0;
+    return true;
+}
+
+CursorSample CursorTraceWriter::Append(const CursorSample& sample)
+{
+    if (this->count == 0) {
+        this->startTime = sample.time;
+    }
+    int64_t time = static_cast<int64_t>(std::llround((sample.time - this->startTime) * TimeScale));
+    int64_t x = static_cast<int64_t>(std::llround(sample.x * PositionScale));
+    int64_t y = static_cast<int64_t>(std::llround(sample.y * PositionScale));
+    // timestamps never go backwards, the delta is unsigned
+    if (this->count == 0 || time < this->lastTime) {
+        time = this->count == 0 ? 0 : this->lastTime;
+    }
+
+    if (this->file.is_open()) {
+        this->writeVarint(static_cast<uint64_t>(time - this->lastTime));
+        this->writeVarint(ZigZag(x - this->lastX));
+        this->writeVarint(ZigZag(y - this->lastY));
+        this->count++;
+    }
+    this->lastTime = time;
+    this->lastX = x;
+    this->lastY = y;
+
+    return CursorSample(time / TimeScale, x / PositionScale, y / PositionScale);
+}
+
+void CursorTraceWriter::Close()
+{
+    if (!this->file.is_open()) {
+        return;
+    }
+    unsigned char countBytes[4];
+    StoreU32(countBytes, this->count);
+    this->file.seekp(8);
+    this->file.write(reinterpret_cast<const char*>(countBytes), sizeof(countBytes));
+    this->file.close();
+    std::cout << "Cursor trace: wrote " << this->count << " samples" << std::endl;
+}
+
+void CursorTraceWriter::writeVarint(uint64_t value)
+{
+    unsigned char bytes[10];
+    int length = 0;
+    do {
+        unsigned char byte = static_cast<unsigned char>(value & 0x7f);
+        value >>= 7;
+        bytes[length++] = value != 0 ? (byte | 0x80) : byte;
+    } while (value != 0);
+    this->file.write(reinterpret_cast<const char*>(bytes), length);
+}
+
+
+CursorTraceReader::CursorTraceReader()
+    : data(nullptr), size(0), position(0), count(0), read(0), lastTime(0), lastX(0), lastY(0)
+#ifdef _WIN32
+    , fileHandle(nullptr), mappingHandle(nullptr)
+#endif
+{
+}
+
+CursorTraceReader::~CursorTraceReader()
+{
+    this->Close();
+}
+
+bool CursorTraceReader::Open(const std::string& path)
+{
+    this->Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+        std::cout << "ERROR::CURSOR_TRACE: Failed to open trace file: " << path << std::endl;
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        return false;
+    }
+    this->fileHandle = file;
+    this->size = static_cast<size_t>(fileSize.QuadPart);
+    if (this->size >= TraceHeaderSize) {
+        this->mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (this->mappingHandle != nullptr) {
+            this->data = static_cast<const unsigned char*>(MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (file < 0 || fstat(file, &info) != 0) {
+        std::cout << "ERROR::CURSOR_TRACE: Failed to open trace file: " << path << std::endl;
+        if (file >= 0) {
+            close(file);
+        }
+        return false;
+    }
+    this->size = static_cast<size_t>(info.st_size);
+    if (this->size >= TraceHeaderSize) {
+        void* mapping = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping != MAP_FAILED) {
+            this->data = static_cast<const unsigned char*>(mapping);
+            // replay walks the samples front to back
+            madvise(mapping, this->size, MADV_SEQUENTIAL);
+        }
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(file);
+#endif
+
+    if (this->data == nullptr || std::memcmp(this->data, TraceMagic, sizeof(TraceMagic)) != 0 ||
+        LoadU32(this->data + 4) != TraceVersion) {
+        std::cout << "ERROR::CURSOR_TRACE: Not a version " << TraceVersion << " cursor trace: " << path << std::endl;
+        this->Close();
+        return false;
+    }
+
+    this->count = LoadU32(this->data + 8);
+    this->position = TraceHeaderSize;
+    this->read = 0;
+    this->lastTime = 0;
+    this->lastX = 0;
+    this->lastY = 0;
+    return true;
+}
+
+void CursorTraceReader::Close()
+{
+#ifdef _WIN32
+    if (this->data != nullptr) {
+        UnmapViewOfFile(this->data);
+    }
+    if (this->mappingHandle != nullptr) {
+        CloseHandle(this->mappingHandle);
+        this->mappingHandle = nullptr;
+    }
+    if (this->fileHandle != nullptr) {
+        CloseHandle(this->fileHandle);
+        this->fileHandle = nullptr;
+    }
+#else
+    if (this->data != nullptr) {
+        munmap(const_cast<unsigned char*>(this->data), this->size);
+    }
+#endif
+    this->data = nullptr;
+    this->size = 0;
+    this->count = 0;
+}
+
+bool CursorTraceReader::Next(CursorSample& sample)
+{
+    // a recording that was never closed has no count and is read to its end
+    if (this->data == nullptr || (this->count != 0 && this->read >= this->count)) {
+        return false;
+    }
+    uint64_t time, x, y;
+    if (!this->readVarint(time) || !this->readVarint(x) || !this->readVarint(y)) {
+        return false;
+    }
+    this->lastTime += static_cast<int64_t>(time);
+    this->lastX += UnZigZag(x);
+    this->lastY += UnZigZag(y);
+    this->read++;
+
+    sample.time = this->lastTime / TimeScale;
+    sample.x = this->lastX / PositionScale;
+    sample.y = this->lastY / PositionScale;
+    return true;
+}
+
+bool CursorTraceReader::readVarint(uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (this->position >= this->size) {
+            return false;
+        }
+        unsigned char byte = this->data[this->position++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,74 @@
+#ifndef CURSOR_TRACE_H
+#define CURSOR_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// One cursor position read by the simulation
+struct CursorSample
+{
+    double time;    // seconds
+    double x, y;    // screen position in pixels
+
+    CursorSample() : time(0.0), x(0.0), y(0.0) { }
+    CursorSample(double time, double x, double y) : time(time), x(x), y(y) { }
+};
+
+// Binary cursor trace: a 16 byte header followed by one record per sample.
+//   header:  "CTRC", uint32 version, uint32 sample count, uint32 reserved
+//            (little endian)
+//   record:  three LEB128 varints - microseconds since the previous
+//            sample, then the zigzag encoded x and y deltas in 1/16 pixels
+// A resting or slowly moving cursor costs 3 bytes per sample.
+
+// Writes samples to a trace file. Samples are quantized to the trace
+// precision; Append() returns the quantized sample, which is exactly what
+// a replay of the file produces.
+class CursorTraceWriter
+{
+public:
+    CursorTraceWriter();
+    ~CursorTraceWriter();
+    bool         Open(const std::string& path);
+    // appends a sample, times relative to the first one
+    CursorSample Append(const CursorSample& sample);
+    // writes the sample count into the header and closes the file
+    void         Close();
+private:
+    std::ofstream file;
+    uint32_t      count;
+    double        startTime;
+    int64_t       lastTime, lastX, lastY;
+    void          writeVarint(uint64_t value);
+};
+
+// Reads a trace straight from a read-only memory mapping of the file;
+// samples are decoded on demand and never copied.
+class CursorTraceReader
+{
+public:
+    CursorTraceReader();
+    ~CursorTraceReader();
+    bool     Open(const std::string& path);
+    void     Close();
+    // decodes the next sample, false at the end of the trace
+    bool     Next(CursorSample& sample);
+    // number of samples the header announces, 0 if the recording was not closed
+    uint32_t Count() const { return this->count; }
+private:
+    const unsigned char* data;
+    size_t               size;
+    size_t               position;
+    uint32_t             count;
+    uint32_t             read;
+    int64_t              lastTime, lastX, lastY;
+#ifdef _WIN32
+    void*                fileHandle;
+    void*                mappingHandle;
+#endif
+    bool                 readVarint(uint64_t& value);
+};
+
+#endif
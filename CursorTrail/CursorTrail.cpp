@@ -1,19 +1,48 @@
 ﻿#include <glad/glad.h>
-#include <GLFW/glfw3.h>
 
 #include "Game.h"
 #include "ResourceManager.h"
 #include "Config.h"
+#include "Stats.h"
+#include "BoundingWindow.h"
+#include "GLStateCache.h"
+#include "CursorSource.h"
+#include "TrailSimulation.h"
+
+#ifdef CURSORTRAIL_GLFW
+#include <GLFW/glfw3.h>
+#include "Presenter.h"
+#endif
+
+#ifdef CURSORTRAIL_HEADLESS
+#include "HeadlessContext.h"
+#include "FrameDump.h"
+#include "ImageCompare.h"
+#endif
 
 #ifdef _WIN32
 #include "WindowsOverlay.h"
 #endif
 
+#ifdef CURSORTRAIL_X11
+#include "X11Overlay.h"
+#include "X11Input.h"
+#endif
+
 #include <iostream>
+#include <memory>
+#include <vector>
 
+#ifdef CURSORTRAIL_GLFW
 // GLFW function declarations
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
+#endif
+
+#ifdef CURSORTRAIL_HEADLESS
+static int RunHeadless();
+static bool CheckGolden(unsigned int index, double time, int width, int height, const std::vector<unsigned char>& pixels);
+#endif
 
 Game gameObject;
 
@@ -33,22 +62,50 @@ int main(int argc, char* argv[])
     
     // Print current configuration
     g_config.PrintConfig();
+
+    if (g_config.headless) {
+#ifdef CURSORTRAIL_HEADLESS
+        return RunHeadless();
+#else
+        std::cout << "This build has no headless mode (EGL was not found)" << std::endl;
+        return -1;
+#endif
+    }
 #ifdef _WIN32
     // Use Windows-specific overlay implementation for guaranteed top-level transparent overlay
     std::cout << "Starting Windows overlay mode for guaranteed transparency and top-level display..." << std::endl;
     
     WindowsOverlay overlay;
-    if (!overlay.Initialize()) {
+    if (!g_config.nativeOverlay) {
+        std::cout << "Native overlay disabled, using OpenGL mode." << std::endl;
+    } else if (!overlay.Initialize()) {
         std::cerr << "Failed to initialize Windows overlay. Falling back to OpenGL mode." << std::endl;
         // Fall through to OpenGL implementation
     } else {
         std::cout << "Windows overlay initialized successfully. Press Ctrl+C to exit." << std::endl;
         
+        // The overlay reads the global cursor, or a trace when replaying
+        std::unique_ptr<CursorSource> input = CreateCursorSource(std::unique_ptr<CursorSource>(new LiveCursorSource()));
+        if (!input) {
+            overlay.Cleanup();
+            return -1;
+        }
+        CursorSample sample;
+        
         // Main loop for Windows overlay
         MSG msg = {};
         auto lastUpdate = GetTickCount64();
+        auto lastStatsReport = lastUpdate;
+        // the empty frame after the trail faded out has been presented
+        bool presentedEmpty = false;
         
         while (true) {
+            // Wait for the next frame, or while idle until the cursor moves
+            bool idle = overlay.IsIdle() && presentedEmpty;
+            auto sinceUpdate = GetTickCount64() - lastUpdate;
+            overlay.WaitForActivity(idle, sinceUpdate >= 16 ? 0 : static_cast<DWORD>(16 - sinceUpdate));
+            g_stats.Wakeup();
+            
             // Process Windows messages
             while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
                 if (msg.message == WM_QUIT) {
@@ -58,16 +115,27 @@ int main(int argc, char* argv[])
                 DispatchMessage(&msg);
             }
             
-            // Update and render at ~60fps
+            // Update and render at ~60fps, right away when woken from idle
             auto currentTime = GetTickCount64();
-            if (currentTime - lastUpdate >= 16) { // ~60fps
-                overlay.Update();
-                overlay.Render();
+            if (currentTime - lastUpdate >= 16 || idle) { // ~60fps
+                // A replay ends with its trace
+                if (!input->Next(sample)) {
+                    goto cleanup;
+                }
+                overlay.Update(sample);
+                // Nothing changes on screen while idle: skip redrawing the layered window
+                if (!overlay.IsIdle() || !presentedEmpty) {
+                    overlay.Render();
+                    g_stats.EndFrame();
+                    presentedEmpty = overlay.IsIdle();
+                }
                 lastUpdate = currentTime;
             }
             
-            // Small sleep to prevent 100% CPU usage
-            Sleep(1);
+            if (g_config.showStats && currentTime - lastStatsReport >= 1000) {
+                g_stats.Report((currentTime - lastStatsReport) / 1000.0);
+                lastStatsReport = currentTime;
+            }
         }
         
     cleanup:
@@ -76,6 +144,114 @@ int main(int argc, char* argv[])
     }
 #endif
 
+#ifdef CURSORTRAIL_X11
+    // Linux counterpart of the Windows overlay: CPU-composited ARGB window, click-through by XShape
+    if (g_config.nativeOverlay) {
+        std::cout << "Starting X11 overlay mode..." << std::endl;
+
+        X11Overlay overlay;
+        if (!overlay.Initialize()) {
+            std::cerr << "Failed to initialize X11 overlay. Falling back to OpenGL mode." << std::endl;
+        } else {
+            std::cout << "X11 overlay initialized successfully. Press Ctrl+C to exit." << std::endl;
+
+            // The overlay reads the pointer from the X server, on the input
+            // thread or once per frame, or a trace when replaying
+            std::unique_ptr<X11InputSource> inputThread = StartX11InputSource();
+            // the idle loop sleeps until the input thread queues a sample
+            QueuedCursorSource* queued = inputThread.get();
+            std::unique_ptr<CursorSource> live = std::move(inputThread);
+            // X11CursorSource shares the overlay's connection; only the input
+            // thread source and replays may move to a simulation thread
+            bool threadSafe = live || !g_config.replayTrace.empty();
+            if (!live) {
+                live.reset(new X11CursorSource(overlay.GetDisplay()));
+            }
+            std::unique_ptr<CursorSource> input = CreateCursorSource(std::move(live));
+            if (!input) {
+                overlay.Cleanup();
+                return -1;
+            }
+
+            // With a simulation rate the trail is simulated on a thread of
+            // its own and this loop only draws the snapshots it publishes
+            TrailSimulation simulation;
+            bool threaded = g_config.simulationRate > 0 && threadSafe;
+            if (threaded) {
+                simulation.Start(std::move(input), g_config.simulationRate);
+            }
+            else if (g_config.simulationRate > 0) {
+                std::cout << "Simulation thread needs the input thread or a replay, simulating once per frame" << std::endl;
+            }
+
+            double lastUpdate = Clock::Seconds();
+            double lastStatsReport = lastUpdate;
+            // the empty frame after the trail faded out has been presented
+            bool presentedEmpty = false;
+
+            while (true) {
+                if (!threaded && queued && overlay.IsIdle() && presentedEmpty && queued->ArmWake()) {
+                    // Nothing to draw and nothing queued: sleep until the input
+                    // thread sees the pointer move, or the next stats report
+                    int waitMs = -1;
+                    if (g_config.showStats) {
+                        double untilReport = 1000.0 - (Clock::Seconds() - lastStatsReport) * 1000.0;
+                        waitMs = untilReport > 0.0 ? static_cast<int>(untilReport) + 1 : 0;
+                    }
+                    overlay.WaitForActivity(waitMs, queued->WakeFd());
+                    queued->DisarmWake();
+                }
+                else {
+                    // Wait for the next frame at ~60fps
+                    double sinceUpdate = (Clock::Seconds() - lastUpdate) * 1000.0;
+                    overlay.WaitForActivity(sinceUpdate >= 16.0 ? 0 : static_cast<int>(16.0 - sinceUpdate));
+                }
+                g_stats.Wakeup();
+
+                double currentTime = Clock::Seconds();
+                if (currentTime - lastUpdate >= 0.016) {
+                    if (threaded) {
+                        // Draw the newest trail the simulation published, never wait for it
+                        TrailSnapshot* snapshot = simulation.Latest();
+                        if (snapshot) {
+                            overlay.Show(*snapshot);
+                        }
+                        else if (simulation.Finished()) {
+                            break;
+                        }
+                    }
+                    // Simulate every position the input thread saw since the
+                    // last frame; a replay ends with its trace
+                    else if (!ReadFrameSamples(*input, g_stats.frame.cursorSamples, g_stats.frame.cursorSamplesDropped,
+                                               [&overlay](const CursorSample& sample) { overlay.Update(sample); })) {
+                        break;
+                    }
+                    // Nothing changes on screen while idle: skip compositing and pushing frames
+                    if (!overlay.IsIdle() || !presentedEmpty) {
+                        overlay.Render();
+                        g_stats.EndFrame();
+                        presentedEmpty = overlay.IsIdle();
+                    }
+                    lastUpdate = currentTime;
+                }
+
+                if (g_config.showStats && currentTime - lastStatsReport >= 1.0) {
+                    g_stats.Report(currentTime - lastStatsReport);
+                    lastStatsReport = currentTime;
+                }
+            }
+
+            simulation.Stop();
+            overlay.Cleanup();
+            return 0;
+        }
+    }
+#endif
+
+#ifndef CURSORTRAIL_GLFW
+    std::cout << "This build has no window mode (GLFW was not found), run it with --headless" << std::endl;
+    return -1;
+#else
     // OpenGL implementation (Windows fallback and other platforms)
     std::cout << "Starting OpenGL mode..." << std::endl;
     
@@ -98,6 +274,16 @@ int main(int argc, char* argv[])
     gameObject.Width = mode->width;
     gameObject.Height = mode->height;
 
+    // in bounding-window mode the window only covers the trail and follows it
+    BoundingWindow trailWindow;
+    if (g_config.boundingWindow) {
+        trailWindow.SetScreen(DamageRect(0, 0, mode->width, mode->height));
+        gameObject.OriginX = trailWindow.Rect().x;
+        gameObject.OriginY = trailWindow.Rect().y;
+        gameObject.Width = trailWindow.Rect().width;
+        gameObject.Height = trailWindow.Rect().height;
+    }
+
     #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     #endif
@@ -111,6 +297,10 @@ int main(int argc, char* argv[])
         return -1;
     }
     
+    if (g_config.boundingWindow) {
+        glfwSetWindowPos(window, gameObject.OriginX, gameObject.OriginY);
+    }
+    
     glfwMakeContextCurrent(window);
 
     // Enable vsync to reduce CPU usage
@@ -132,8 +322,8 @@ int main(int argc, char* argv[])
     // OpenGL configuration
     // --------------------
     glViewport(0, 0, gameObject.Width, gameObject.Height);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    g_glState.SetBlend(true);
+    g_glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
     // Set clear color to transparent for proper overlay transparency
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
@@ -142,33 +332,254 @@ int main(int argc, char* argv[])
     // ---------------
     gameObject.Init();
 
+    // cursor input, live or from a trace
+    // glfwGetCursorPos only follows the pointer over our own window; on X11
+    // the input thread reads the global pointer instead
+    std::unique_ptr<CursorSource> live;
+#ifdef CURSORTRAIL_X11
+    live = StartX11InputSource();
+#endif
+    // glfwGetCursorPos has to stay on this thread; only the input thread
+    // source and replays may move to a simulation thread
+    bool threadSafe = live || !g_config.replayTrace.empty();
+    if (!live) {
+        live.reset(new LiveCursorSource(window));
+    }
+    std::unique_ptr<CursorSource> input = CreateCursorSource(std::move(live));
+    if (!input) {
+        glfwTerminate();
+        return -1;
+    }
+    input->SetOrigin(gameObject.OriginX, gameObject.OriginY);
+
+    // with a simulation rate the trail is simulated on a thread of its own
+    // and this loop only draws the snapshots it publishes
+    TrailSimulation simulation;
+    bool threaded = g_config.simulationRate > 0 && threadSafe;
+    if (threaded) {
+        simulation.Start(std::move(input), g_config.simulationRate);
+    }
+    else if (g_config.simulationRate > 0) {
+        std::cout << "Simulation thread needs the input thread or a replay, simulating once per frame" << std::endl;
+    }
+
+    // frames are presented with the trail damage so compositors only redo that part
+    Presenter presenter(window);
+
+    double lastStatsReport = glfwGetTime();
+
+    // The global cursor produces no events for a pass-through window, so an
+    // idle loop still has to look at it once per display refresh
+    double idleWait = 1.0 / (mode->refreshRate > 0 ? mode->refreshRate : 60);
+    // the empty frame after the trail faded out has been presented
+    bool presentedEmpty = false;
+
     while (!glfwWindowShouldClose(window))
     {
-        glfwPollEvents();
+        if (gameObject.IsIdle()) {
+            glfwWaitEventsTimeout(idleWait);
+        } else {
+            glfwPollEvents();
+        }
+        g_stats.Wakeup();
 
         // update game state
         // -----------------
-        gameObject.Update(window);
+        if (threaded) {
+            // draw the newest trail the simulation published, never wait for it
+            TrailSnapshot* snapshot = simulation.Latest();
+            if (snapshot) {
+                gameObject.Show(*snapshot);
+            }
+            else if (simulation.Finished()) {
+                break;
+            }
+        }
+        // simulate every position queued since the last frame; a replay ends with its trace
+        else if (!ReadFrameSamples(*input, g_stats.frame.cursorSamples, g_stats.frame.cursorSamplesDropped,
+                                   [](const CursorSample& sample) { gameObject.Update(sample); })) {
+            break;
+        }
+
+        // keep the bounding window around the trail
+        if (g_config.boundingWindow) {
+            float bounds[4];
+            bool any = gameObject.particles.Bounds(g_config.fadeMode, gameObject.currentTime, bounds);
+            if (trailWindow.Update(any, bounds, g_config.spriteSize)) {
+                const DamageRect& rect = trailWindow.Rect();
+                glfwSetWindowPos(window, rect.x, rect.y);
+                glfwSetWindowSize(window, rect.width, rect.height);
+                gameObject.SetSurface(rect.x, rect.y, rect.width, rect.height);
+                // the simulation thread only reads sources that report screen coordinates
+                if (!threaded) {
+                    input->SetOrigin(rect.x, rect.y);
+                }
+            }
+        }
 
         // render
         // ------
-        glClear(GL_COLOR_BUFFER_BIT);
-        gameObject.Render();
+        // nothing changes on screen while idle: skip clearing and presenting
+        if (!gameObject.IsIdle() || !presentedEmpty) {
+            // the back buffer keeps older frames, only their damage since then is repainted
+            gameObject.Render(presenter.BufferAge());
+
+            presenter.Present(gameObject.damage.Damage(), gameObject.Height);
+            g_stats.EndFrame();
+            presentedEmpty = gameObject.IsIdle();
+        }
 
-        glfwSwapBuffers(window);
+        // renderer statistics
+        // -------------------
+        if (g_config.showStats) {
+            double now = glfwGetTime();
+            if (now - lastStatsReport >= 1.0) {
+                g_stats.Report(now - lastStatsReport);
+                lastStatsReport = now;
+            }
+        }
     }
 
+    simulation.Stop();
+
     // delete all resources as loaded using the resource manager
     // ---------------------------------------------------------
     ResourceManager::Clear();
 
     glfwTerminate();
     return 0;
+#endif
 }
 
+#ifdef CURSORTRAIL_GLFW
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
-}
\ No newline at end of file
+}
+#endif
+
+#ifdef CURSORTRAIL_HEADLESS
+// Renders a replayed cursor trace into an offscreen framebuffer as fast as
+// possible, optionally writing every frame out
+static int RunHeadless()
+{
+    if (g_config.replayTrace.empty()) {
+        std::cout << "Headless mode has no cursor, give it a trace with --replay-trace" << std::endl;
+        return -1;
+    }
+
+    HeadlessContext context;
+    if (!context.Create(g_config.headlessWidth, g_config.headlessHeight)) {
+        return -1;
+    }
+
+    // OpenGL configuration
+    // --------------------
+    glViewport(0, 0, context.Width(), context.Height());
+    g_glState.SetBlend(true);
+    g_glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    gameObject.Width = context.Width();
+    gameObject.Height = context.Height();
+    gameObject.Init();
+
+    std::unique_ptr<CursorSource> input = CreateCursorSource(std::unique_ptr<CursorSource>(new LiveCursorSource()));
+    if (!input) {
+        ResourceManager::Clear();
+        return -1;
+    }
+
+    FrameDump dump(g_config.dumpFrames, g_config.dumpFormat);
+    std::vector<unsigned char> pixels;
+    CursorSample sample;
+    unsigned int frames = 0;
+    // frames picked by --capture-at, every frame without it
+    bool captureAll = g_config.captureAt.empty();
+    size_t nextCapture = 0;
+    unsigned int captured = 0, goldenFailures = 0;
+    double start = Clock::Seconds();
+    double lastStatsReport = start;
+
+    while (input->Next(sample)) {
+        g_stats.Wakeup();
+        gameObject.Update(sample);
+
+        // the framebuffer keeps the previous frame, only its damage is repainted
+        gameObject.Render(frames == 0 ? 0 : 1);
+        g_stats.EndFrame();
+        frames++;
+
+        bool capture = captureAll;
+        while (nextCapture < g_config.captureAt.size() && sample.time >= g_config.captureAt[nextCapture]) {
+            capture = true;
+            nextCapture++;
+        }
+        if (capture && (!g_config.dumpFrames.empty() || !g_config.goldenDir.empty())) {
+            context.ReadPixels(pixels);
+            if (!g_config.dumpFrames.empty() && !dump.Write(context.Width(), context.Height(), pixels)) {
+                break;
+            }
+            if (!g_config.goldenDir.empty() && !CheckGolden(captured, sample.time, context.Width(), context.Height(), pixels)) {
+                goldenFailures++;
+            }
+            captured++;
+        }
+
+        if (g_config.showStats) {
+            double now = Clock::Seconds();
+            if (now - lastStatsReport >= 1.0) {
+                g_stats.Report(now - lastStatsReport);
+                lastStatsReport = now;
+            }
+        }
+    }
+    glFinish();
+    double elapsed = Clock::Seconds() - start;
+
+    std::cout << "Headless: rendered " << frames << " frames in " << elapsed << " seconds ("
+              << (elapsed > 0.0 ? frames / elapsed : 0.0) << " fps)";
+    if (dump.Frames() > 0) {
+        std::cout << ", wrote " << dump.Frames() << " frames to " << g_config.dumpFrames;
+    }
+    std::cout << std::endl;
+    if (!g_config.goldenDir.empty()) {
+        std::cout << "Golden images: " << (captured - goldenFailures) << " of " << captured << " frames match" << std::endl;
+    }
+
+    // delete all resources while the context is still current
+    ResourceManager::Clear();
+    return goldenFailures > 0 || (!g_config.goldenDir.empty() && captured == 0) ? 1 : 0;
+}
+
+// Compares the index-th captured frame with its golden image; a mismatch
+// leaves a diff image next to the dumped frames
+static bool CheckGolden(unsigned int index, double time, int width, int height, const std::vector<unsigned char>& pixels)
+{
+    std::string name = FrameDump::FileName(index, DUMP_PNG);
+    std::vector<unsigned char> golden;
+    int goldenWidth, goldenHeight;
+    if (!FrameDump::ReadPng(g_config.goldenDir + "/" + name, goldenWidth, goldenHeight, golden)) {
+        return false;
+    }
+    if (goldenWidth != width || goldenHeight != height) {
+        std::cout << "Golden " << name << ": " << goldenWidth << "x" << goldenHeight << " does not match the "
+                  << width << "x" << height << " frame" << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> diff;
+    ImageDiff result = ImageCompare::Compare(golden, pixels, width, height, g_config.goldenThreshold, &diff);
+    if (result.Passed()) {
+        return true;
+    }
+    std::string diffName = FrameDump::FileName(index, DUMP_PNG, "diff");
+    std::string diffPath = g_config.dumpFrames.empty() ? diffName : g_config.dumpFrames + "/" + diffName;
+    FrameDump::WritePng(diffPath, width, height, diff);
+    std::cout << "Golden " << name << " at " << time << " s: " << result.mismatched << " of " << result.total
+              << " pixels differ (max difference " << result.maxDelta << "), see " << diffPath << std::endl;
+    return false;
+}
+#endif
\ No newline at end of file
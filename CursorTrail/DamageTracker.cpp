@@ -0,0 +1,87 @@
+#include "DamageTracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+DamageRect DamageRect::Union(const DamageRect& other) const
+{
+    if (this->Empty()) {
+        return other;
+    }
+    if (other.Empty()) {
+        return *this;
+    }
+    int left = std::min(this->x, other.x);
+    int top = std::min(this->y, other.y);
+    int right = std::max(this->x + this->width, other.x + other.width);
+    int bottom = std::max(this->y + this->height, other.y + other.height);
+    return DamageRect(left, top, right - left, bottom - top);
+}
+
+DamageRect DamageRect::Intersect(const DamageRect& other) const
+{
+    int left = std::max(this->x, other.x);
+    int top = std::max(this->y, other.y);
+    int right = std::min(this->x + this->width, other.x + other.width);
+    int bottom = std::min(this->y + this->height, other.y + other.height);
+    if (right <= left || bottom <= top) {
+        return DamageRect();
+    }
+    return DamageRect(left, top, right - left, bottom - top);
+}
+
+DamageTracker::DamageTracker() : width(0), height(0), originX(0), originY(0), frames(0)
+{
+}
+
+void DamageTracker::Resize(int width, int height, int originX, int originY)
+{
+    this->width = width;
+    this->height = height;
+    this->originX = originX;
+    this->originY = originY;
+    this->bounds = DamageRect();
+    this->frames = 0;
+}
+
+void DamageTracker::Update(const ParticleStore& particles, FadeMode mode, float now, float spriteSize)
+{
+    DamageRect previous = this->bounds;
+
+    // sprites are centered on the particles, a sprite size of margin covers
+    // them with room for rounding and filtering
+    float box[4];
+    if (particles.Bounds(mode, now, box)) {
+        int left = static_cast<int>(std::floor(box[0] - spriteSize)) - this->originX;
+        int top = static_cast<int>(std::floor(box[1] - spriteSize)) - this->originY;
+        int right = static_cast<int>(std::ceil(box[2] + spriteSize)) - this->originX;
+        int bottom = static_cast<int>(std::ceil(box[3] + spriteSize)) - this->originY;
+        this->bounds = DamageRect(left, top, right - left, bottom - top).Intersect(this->Surface());
+    }
+    else {
+        this->bounds = DamageRect();
+    }
+
+    for (int i = HistoryLength - 1; i > 0; i--) {
+        this->history[i] = this->history[i - 1];
+    }
+    // what was drawn last frame has to be erased, what is drawn now painted
+    this->history[0] = previous.Union(this->bounds);
+    if (this->frames <= HistoryLength) {
+        this->frames++;
+    }
+}
+
+DamageRect DamageTracker::DamageForAge(int bufferAge) const
+{
+    // the buffer must hold a frame drawn since the last resize
+    if (bufferAge <= 0 || bufferAge >= this->frames) {
+        return this->Surface();
+    }
+    DamageRect damage;
+    for (int i = 0; i < bufferAge; i++) {
+        damage = damage.Union(this->history[i]);
+    }
+    return damage;
+}
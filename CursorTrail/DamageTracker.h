@@ -0,0 +1,54 @@
+#ifndef DAMAGE_TRACKER_H
+#define DAMAGE_TRACKER_H
+
+#include "ParticleStore.h"
+#include "Config.h"
+
+// Rectangle in surface pixels, origin at the top-left corner
+struct DamageRect
+{
+    int x, y, width, height;
+
+    DamageRect() : x(0), y(0), width(0), height(0) { }
+    DamageRect(int x, int y, int width, int height) : x(x), y(y), width(width), height(height) { }
+    bool       Empty() const { return this->width <= 0 || this->height <= 0; }
+    // smallest rectangle covering both
+    DamageRect Union(const DamageRect& other) const;
+    // part of this rectangle inside other
+    DamageRect Intersect(const DamageRect& other) const;
+};
+
+// Tracks the part of the surface the trail changes every frame: the
+// union of the previous and the current bounding box of the live
+// particles, inflated by the sprite size. Renderers clear and draw only
+// inside it and hand it on to the presentation layer, so the rest of a
+// large, mostly transparent surface is never touched.
+// A back buffer that was last drawn N frames ago (its buffer age) misses
+// the damage of the N-1 frames in between, so a short history is kept.
+class DamageTracker
+{
+public:
+    // frames of damage history, older back buffers are repainted as a whole
+    static const int HistoryLength = 4;
+
+    DamageTracker();
+    // sets the surface size and the screen position of its top-left
+    // corner; the next frames repaint the whole surface
+    void       Resize(int width, int height, int originX = 0, int originY = 0);
+    // computes the damage of a new frame from the live particles
+    void       Update(const ParticleStore& particles, FadeMode mode, float now, float spriteSize);
+    // area changed since the previous frame
+    const DamageRect& Damage() const { return this->history[0]; }
+    // area to repaint in a back buffer holding the frame from bufferAge
+    // frames ago; 0 means the content is unknown and repaints everything
+    DamageRect DamageForAge(int bufferAge) const;
+    DamageRect Surface() const { return DamageRect(0, 0, this->width, this->height); }
+private:
+    int        width, height;
+    int        originX, originY;        // particle coordinates of the surface origin
+    DamageRect bounds;                  // trail bounds of the current frame
+    DamageRect history[HistoryLength];  // damage of the latest frames, newest first
+    int        frames;                  // valid history entries
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "FrameDump.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include <stb/stb_image.h>
+
+namespace
+{
+    // stored deflate blocks hold at most this many bytes
+    const size_t StoredBlockSize = 65535;
+
+    uint32_t Crc32(uint32_t crc, const unsigned char* data, size_t length)
+    {
+        static uint32_t table[256];
+        static bool tableReady = false;
+        if (!tableReady) {
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            tableReady = true;
+        }
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++) {
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    void PutU32(std::vector<unsigned char>& out, uint32_t value)
+    {
+        out.push_back(static_cast<unsigned char>(value >> 24));
+        out.push_back(static_cast<unsigned char>(value >> 16));
+        out.push_back(static_cast<unsigned char>(value >> 8));
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    void WriteChunk(std::ofstream& file, const char type[4], const std::vector<unsigned char>& data)
+    {
+        std::vector<unsigned char> chunk;
+        PutU32(chunk, static_cast<uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        // the CRC covers the type and the data
+        PutU32(chunk, Crc32(0, chunk.data() + 4, chunk.size() - 4));
+        file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+    }
+}
+
+FrameDump::FrameDump(const std::string& directory, DumpFormat format)
+    : directory(directory), format(format), frames(0)
+{
+}
+
+std::string FrameDump::FileName(unsigned int index, DumpFormat format, const char* prefix)
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s_%05u.%s", prefix, index, format == DUMP_PNG ? "png" : "rgba");
+    return name;
+}
+
+bool FrameDump::Write(int width, int height, const std::vector<unsigned char>& pixels)
+{
+    std::string name = FileName(this->frames, this->format);
+    std::string path = this->directory.empty() ? name : this->directory + "/" + name;
+    this->frames++;
+    return this->format == DUMP_PNG ? WritePng(path, width, height, pixels) : WriteRaw(path, width, height, pixels);
+}
+
+bool FrameDump::WriteRaw(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cout << "ERROR::FRAME_DUMP: Failed to write " << path << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(width) * height * 4);
+    return true;
+}
+
+bool FrameDump::ReadPng(const std::string& path, int& width, int& height, std::vector<unsigned char>& pixels)
+{
+    int channels;
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (data == nullptr) {
+        std::cout << "ERROR::FRAME_DUMP: Failed to read " << path << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+    pixels.assign(data, data + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(data);
+    return true;
+}
+
+bool FrameDump::WritePng(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cout << "ERROR::FRAME_DUMP: Failed to write " << path << std::endl;
+        return false;
+    }
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    // 8-bit RGBA, no interlacing
+    std::vector<unsigned char> header;
+    PutU32(header, static_cast<uint32_t>(width));
+    PutU32(header, static_cast<uint32_t>(height));
+    header.push_back(8);
+    header.push_back(6);
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    WriteChunk(file, "IHDR", header);
+
+    // every row starts with filter type 0 (none)
+    size_t row = static_cast<size_t>(width) * 4;
+    std::vector<unsigned char> raw;
+    raw.reserve((row + 1) * height);
+    for (int y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels.begin() + y * row, pixels.begin() + (y + 1) * row);
+    }
+
+    // zlib stream of stored deflate blocks
+    std::vector<unsigned char> data;
+    data.reserve(raw.size() + raw.size() / StoredBlockSize * 5 + 16);
+    data.push_back(0x78);
+    data.push_back(0x01);
+    uint32_t adlerA = 1, adlerB = 0;
+    size_t offset = 0;
+    do {
+        size_t length = std::min(StoredBlockSize, raw.size() - offset);
+        bool last = offset + length == raw.size();
+        data.push_back(last ? 1 : 0);
+        data.push_back(static_cast<unsigned char>(length));
+        data.push_back(static_cast<unsigned char>(length >> 8));
+        data.push_back(static_cast<unsigned char>(~length));
+        data.push_back(static_cast<unsigned char>(~length >> 8));
+        data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + length);
+        // 5552 bytes are the most the sums take before they can overflow
+        for (size_t start = offset; start < offset + length; start += 5552) {
+            size_t end = std::min(start + 5552, offset + length);
+            for (size_t i = start; i < end; i++) {
+                adlerA += raw[i];
+                adlerB += adlerA;
+            }
+            adlerA %= 65521;
+            adlerB %= 65521;
+        }
+        offset += length;
+    } while (offset < raw.size());
+    PutU32(data, (adlerB << 16) | adlerA);
+    WriteChunk(file, "IDAT", data);
+
+    WriteChunk(file, "IEND", std::vector<unsigned char>());
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef FRAME_DUMP_H
+#define FRAME_DUMP_H
+
+#include <string>
+#include <vector>
+
+#include "Config.h"
+
+// Writes rendered frames to numbered files (frame_00000.png, ...) in a directory
+class FrameDump
+{
+public:
+    FrameDump(const std::string& directory, DumpFormat format);
+    // writes pixels (RGBA rows, top row first) as the next frame
+    bool Write(int width, int height, const std::vector<unsigned char>& pixels);
+    unsigned int Frames() const { return this->frames; }
+    // file name of the index-th frame, prefix replaces "frame"
+    static std::string FileName(unsigned int index, DumpFormat format, const char* prefix = "frame");
+    // writes a single image to path
+    static bool WritePng(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels);
+    static bool WriteRaw(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels);
+    // reads a PNG as RGBA rows, top row first
+    static bool ReadPng(const std::string& path, int& width, int& height, std::vector<unsigned char>& pixels);
+private:
+    std::string  directory;
+    DumpFormat   format;
+    unsigned int frames;
+};
+
+#endif
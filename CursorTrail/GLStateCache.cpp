@@ -0,0 +1,124 @@
+#include "GLStateCache.h"
+#include "Stats.h"
+
+// Global state cache for the context of the main window
+GLStateCache g_glState;
+
+namespace
+{
+    // no GL object or enum has this value, it marks unknown state
+    const unsigned int Unknown = ~0u;
+}
+
+GLStateCache::GLStateCache()
+{
+    this->Invalidate();
+}
+
+void GLStateCache::UseProgram(unsigned int program)
+{
+    if (this->change(this->program, program)) {
+        glUseProgram(program);
+    }
+}
+
+void GLStateCache::ActiveTexture(unsigned int unit)
+{
+    if (this->change(this->activeUnit, unit - GL_TEXTURE0)) {
+        glActiveTexture(unit);
+    }
+}
+
+void GLStateCache::BindTexture2D(unsigned int texture)
+{
+    // units beyond the tracked ones (or an unknown unit) are not cached
+    if (this->activeUnit >= TextureUnits) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        g_stats.frame.stateCallsIssued++;
+        return;
+    }
+    if (this->change(this->textures[this->activeUnit], texture)) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+}
+
+void GLStateCache::BindVertexArray(unsigned int vertexArray)
+{
+    if (this->change(this->vertexArray, vertexArray)) {
+        glBindVertexArray(vertexArray);
+    }
+}
+
+void GLStateCache::SetBlend(bool enabled)
+{
+    if (this->change(this->blend, enabled ? 1 : 0)) {
+        if (enabled) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+    }
+}
+
+void GLStateCache::SetScissorTest(bool enabled)
+{
+    if (this->change(this->scissorTest, enabled ? 1 : 0)) {
+        if (enabled) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+void GLStateCache::BlendFunc(unsigned int source, unsigned int destination)
+{
+    if (this->blendSource == source && this->blendDestination == destination) {
+        g_stats.frame.stateCallsSkipped++;
+        return;
+    }
+    this->blendSource = source;
+    this->blendDestination = destination;
+    glBlendFunc(source, destination);
+    g_stats.frame.stateCallsIssued++;
+}
+
+void GLStateCache::ForgetProgram(unsigned int program)
+{
+    if (this->program == program) {
+        this->program = Unknown;
+    }
+}
+
+void GLStateCache::ForgetTexture(unsigned int texture)
+{
+    for (unsigned int i = 0; i < TextureUnits; i++) {
+        if (this->textures[i] == texture) {
+            this->textures[i] = Unknown;
+        }
+    }
+}
+
+void GLStateCache::ForgetVertexArray(unsigned int vertexArray)
+{
+    if (this->vertexArray == vertexArray) {
+        this->vertexArray = Unknown;
+    }
+}
+
+void GLStateCache::Invalidate()
+{
+    this->program = Unknown;
+    this->activeUnit = Unknown;
+    for (unsigned int i = 0; i < TextureUnits; i++) {
+        this->textures[i] = Unknown;
+    }
+    this->vertexArray = Unknown;
+    this->blend = Unknown;
+    this->scissorTest = Unknown;
+    this->blendSource = Unknown;
+    this->blendDestination = Unknown;
+}
+
+bool GLStateCache::change(unsigned int& cached, unsigned int value)
+{
+    if (cached == value) {
+        g_stats.frame.stateCallsSkipped++;
+        return false;
+    }
+    cached = value;
+    g_stats.frame.stateCallsIssued++;
+    return true;
+}
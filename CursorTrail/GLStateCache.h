@@ -0,0 +1,47 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <glad/glad.h>
+
+
+// Shadow copy of the GL binding state the renderers touch every frame.
+// Binds and enables go through here and are only forwarded to GL when
+// they change something; issued and skipped calls are counted in the
+// frame statistics. All code sharing the context must use the cache for
+// the state it tracks, or call Invalidate() after changing it directly.
+class GLStateCache
+{
+public:
+    // highest texture unit tracked
+    static const unsigned int TextureUnits = 8;
+
+    GLStateCache();
+    void UseProgram(unsigned int program);
+    void ActiveTexture(unsigned int unit);     // GL_TEXTURE0 + n
+    void BindTexture2D(unsigned int texture);  // on the active unit
+    void BindVertexArray(unsigned int vertexArray);
+    void SetBlend(bool enabled);
+    void SetScissorTest(bool enabled);
+    void BlendFunc(unsigned int source, unsigned int destination);
+    // deleting a bound object resets the binding to 0 in GL
+    void ForgetProgram(unsigned int program);
+    void ForgetTexture(unsigned int texture);
+    void ForgetVertexArray(unsigned int vertexArray);
+    // forgets everything, the next calls are all issued
+    void Invalidate();
+private:
+    unsigned int program;
+    unsigned int activeUnit;                   // index, not the GL_TEXTURE0 based enum
+    unsigned int textures[TextureUnits];
+    unsigned int vertexArray;
+    unsigned int blend;                        // 0 disabled, 1 enabled
+    unsigned int scissorTest;
+    unsigned int blendSource, blendDestination;
+    // counts the call and reports whether it has to reach GL
+    bool         change(unsigned int& cached, unsigned int value);
+};
+
+// Global state cache for the context of the main window
+extern GLStateCache g_glState;
+
+#endif
@@ -1,149 +1,227 @@
 #include "Game.h"
 #include "SpriteRenderer.h"
+#include "SpriteBatchRenderer.h"
+#include "TrailRingBuffer.h"
+#include "StreamBuffer.h"
 #include "ResourceManager.h"
+#include "Stats.h"
+#include "GLStateCache.h"
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
-#ifdef _WIN32
-#include <windows.h>
-#endif
 
-
-Game::Game() : State(GAME_ACTIVE), currentIndex(0), parts(nullptr)
+Game::Game() : State(GAME_ACTIVE), pendingWrites(0), OriginX(0), OriginY(0), currentTime(0.0f),
+    cursorX(std::numeric_limits<double>::quiet_NaN()), cursorY(std::numeric_limits<double>::quiet_NaN()),
+    cursorMoved(true), headParked(false), simulated(false)
 {
 }
 
 Game::~Game()
 {
-    delete[] parts;
 }
 
 SpriteRenderer* Renderer;
+SpriteBatchRenderer* BatchRenderer;
+TrailRingBuffer* RingBuffer;
+StreamBuffer* Stream;
 
 void Game::Init()
 {
-    // Initialize dynamic trail parts array based on configuration
-    parts = new TrailPart[g_config.maxParticles];
-    for (int i = 0; i < g_config.maxParticles; i++) {
-        parts[i] = TrailPart(0.0f, 0.0f, 0.0f);
-    }
+    // Initialize the particle buffer based on configuration
+    particles.Resize(g_config.maxParticles);
     
     // load shaders
-    ResourceManager::LoadShader("sprite.vs", "sprite.frag", nullptr, "sprite");
+    this->spriteShader = ResourceManager::LoadShader("sprite.vs", "sprite.frag", nullptr, "sprite");
     // configure shaders
-    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(this->Width),
-        static_cast<float>(this->Height), 0.0f, -1.0f, 1.0f);
-    ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
-    ResourceManager::GetShader("sprite").SetMatrix4("projection", projection);
+    ResourceManager::GetShader(this->spriteShader).Use().SetInteger("image", 0);
+    this->instancedShader = ResourceManager::LoadShader("sprite_instanced.vs", "sprite.frag", nullptr, "sprite_instanced");
+    ResourceManager::GetShader(this->instancedShader).Use().SetInteger("image", 0);
+    this->SetSurface(this->OriginX, this->OriginY, this->Width, this->Height);
     // set render-specific controls
-
-    Shader shader;
-    shader = ResourceManager::GetShader("sprite");
-
-    Renderer = new SpriteRenderer(shader);
+    // (initializing again replaces the renderers of the previous Init)
+    delete Renderer;
+    delete BatchRenderer;
+    delete RingBuffer;
+    delete Stream;
+
+    Renderer = new SpriteRenderer(this->spriteShader);
+
+    // a frame never uploads more than one instance per particle
+    Stream = new StreamBuffer(g_config.maxParticles * sizeof(SpriteInstance), g_config.persistentBuffers);
+    BatchRenderer = new SpriteBatchRenderer(this->instancedShader, Stream);
+    RingBuffer = new TrailRingBuffer(g_config.maxParticles, Stream);
     // Load texture from config
-    ResourceManager::LoadTexture(g_config.texturePath.c_str(), true, "trail");
+    this->trailTexture = ResourceManager::LoadTexture(g_config.texturePath.c_str(), true, "trail");
     
     std::cout << "Game initialized with " << g_config.maxParticles << " max particles, texture: " << g_config.texturePath << std::endl;
 }
 
+void Game::SetSurface(int x, int y, unsigned int width, unsigned int height)
+{
+    this->OriginX = x;
+    this->OriginY = y;
+    this->Width = width;
+    this->Height = height;
+
+    glm::mat4 projection = glm::ortho(static_cast<float>(x), static_cast<float>(x + static_cast<int>(width)),
+        static_cast<float>(y + static_cast<int>(height)), static_cast<float>(y), -1.0f, 1.0f);
+    ResourceManager::GetShader(this->spriteShader).Use().SetMatrix4("projection", projection);
+    ResourceManager::GetShader(this->instancedShader).Use().SetMatrix4("projection", projection);
+    glViewport(0, 0, width, height);
+
+    // the surface content is gone, repaint all of it
+    this->damage.Resize(width, height, x, y);
+}
+
 const float fadeTime = 1.0;
 
-void Game::Update(GLFWwindow* window)
+void Game::Update(const CursorSample& sample)
 {
-    double xpos, ypos;
-    
-    // Get global cursor position for proper system-wide cursor trail
-    // This fixes the issue on Windows 11 where glfwGetCursorPos returns
-    // window-relative coordinates instead of screen coordinates
-#ifdef _WIN32
-    POINT cursorPos;
-    if (GetCursorPos(&cursorPos)) {
-        xpos = static_cast<double>(cursorPos.x);
-        ypos = static_cast<double>(cursorPos.y);
-    } else {
-        // Fallback to GLFW if Windows API fails
-        glfwGetCursorPos(window, &xpos, &ypos);
+    // the sample clock drives the simulation, replays run on recorded time
+    this->clock.SetTime(sample.time);
+    // keep particle timestamps small so they stay precise as floats
+    float shift;
+    if (this->clock.Rebase(shift)) {
+        this->particles.ShiftSpawnTimes(shift);
+        // every live slot changed, mirror the live window again
+        this->pendingWrites = this->particles.LiveCount();
+        this->emitter.ShiftTime(shift);
+    }
+    this->currentTime = this->clock.Now();
+    float lifetime = g_config.ParticleLifetime();
+
+    double xpos = sample.x;
+    double ypos = sample.y;
+    // smooth out sensor jitter; moves within the dead zone keep the last position
+    if (!this->filter.Apply(sample.time, xpos, ypos, g_config.filterCutoff, g_config.filterBeta, g_config.deadZone)) {
+        g_stats.frame.spawnsSuppressed++;
     }
-#else
-    // On non-Windows systems, use GLFW (may need adjustment for Linux/macOS)
-    glfwGetCursorPos(window, &xpos, &ypos);
-#endif
 
-    TrailPart currentTrail = TrailPart(xpos, ypos, g_config.fadeTime);
+    // a resting cursor spawns nothing, the trail fades out and the game goes idle
+    this->cursorMoved = xpos != this->cursorX || ypos != this->cursorY;
+    this->cursorX = xpos;
+    this->cursorY = ypos;
+
+    // spawn particles every spawnFrequency pixels along the path, each with
+    // the time the cursor passed it; a resting cursor only advances the time
+    unsigned int spawned = this->emitter.Move(this->particles, static_cast<float>(xpos), static_cast<float>(ypos),
+                                              this->currentTime, g_config.pathMode, g_config.spawnFrequency, g_config.fadeTime, lifetime);
+    g_stats.frame.particlesSpawned += spawned;
+    this->pendingWrites = std::min(this->pendingWrites + spawned, this->particles.Capacity());
+    // the refreshed head sits right before the new particles
+    if (this->emitter.HeadRefreshed()) {
+        this->pendingWrites = std::min(std::max(this->pendingWrites, spawned + 1), this->particles.Capacity());
+    }
+    this->headParked = this->emitter.Parked();
+}
 
-    // Calculate previous index BEFORE adding current trail
-    int prevIndex;
-    if (this->currentIndex != 0) {
-        prevIndex = this->currentIndex - 1;
+void Game::Show(TrailSnapshot& snapshot)
+{
+    this->particles.Swap(snapshot.particles);
+    this->currentTime = snapshot.time;
+    this->cursorMoved = snapshot.cursor.x != this->cursorX || snapshot.cursor.y != this->cursorY;
+    this->cursorX = snapshot.cursor.x;
+    this->cursorY = snapshot.cursor.y;
+    this->headParked = snapshot.parked;
+    this->simulated = true;
+
+    // mirror the slots spawned since the last snapshot shown; a rebase
+    // moved every live spawn time
+    if (snapshot.totals.rebases != this->shown.rebases) {
+        this->pendingWrites = this->particles.LiveCount();
     }
     else {
-        prevIndex = g_config.maxParticles - 1;
-    }
-
-    // Add the current cursor position to trail
-    this->AddPart(currentTrail);
-
-    // interpolate trail
-
-    TrailPart previousTrail = this->parts[prevIndex];
-
-    glm::vec2 pos1 = glm::vec2(previousTrail.x, previousTrail.y);
-    glm::vec2 pos2 = glm::vec2(currentTrail.x, currentTrail.y);
-
-    glm::vec2 diff = pos2 - pos1;
-    float distance = glm::length(diff);
-    
-    // Avoid division by zero
-    if (distance > 0.0f) {
-        glm::vec2 direction = diff / distance;
-
-        float interval = g_config.spawnFrequency;
-        float stopAt = distance;
-
-        for (float d = interval; d < stopAt; d += interval) {
-            glm::vec2 ivec = pos1 + (direction * d);
-            this->AddPart(TrailPart(ivec.x, ivec.y, g_config.fadeTime));
+        unsigned long long written = snapshot.totals.written - this->shown.written;
+        this->pendingWrites = static_cast<unsigned int>(std::min<unsigned long long>(this->pendingWrites + written, this->particles.Capacity()));
+        // a head refreshed since then sits right before the particles written after it
+        if (snapshot.totals.refreshes != this->shown.refreshes) {
+            unsigned long long dirty = std::max<unsigned long long>(this->pendingWrites, snapshot.totals.sinceRefresh + 1);
+            this->pendingWrites = static_cast<unsigned int>(std::min<unsigned long long>(dirty, this->particles.Capacity()));
         }
     }
+    this->shown = snapshot.totals;
 }
 
-void Game::AddPart(TrailPart part) {
-
-    this->parts[this->currentIndex] = part;
-
-    this->currentIndex++;
-    if (this->currentIndex == g_config.maxParticles) {
-        this->currentIndex = 0;
-    }
-
+bool Game::IsIdle() const
+{
+    // a parked head stays under the resting cursor without changing
+    return !this->cursorMoved && this->particles.LiveCount() <= (this->headParked ? 1u : 0u);
 }
 
-void Game::Render()
+void Game::Render(int bufferAge)
 {
 
-    Texture2D tex;
-    tex = ResourceManager::GetTexture("trail");
+    Texture2D& tex = ResourceManager::GetTexture(this->trailTexture);
 
-    for (int i = 0; i < g_config.maxParticles; i++) {
+    bool timedFade = g_config.fadeMode == FADE_TIME;
 
-        float newTime = this->parts[i].time - g_config.fadeRate;
-        if (newTime < 0) {
-            newTime = 0;
+    if (!timedFade && !this->simulated) {
+        this->particles.Fade(g_config.fadeRate);
+    }
+    // only the live window is drawn, a resting cursor leaves it nearly empty
+    this->particles.Expire(g_config.fadeMode, this->currentTime);
+    unsigned int first[2], count[2];
+    unsigned int spans = this->particles.LiveSpans(first, count);
+
+    // clear and draw only where the trail was or is now
+    this->damage.Update(this->particles, g_config.fadeMode, this->currentTime, g_config.spriteSize);
+    DamageRect region = this->damage.DamageForAge(bufferAge);
+    g_stats.frame.pixelsRepainted += static_cast<unsigned long long>(region.width) * region.height;
+    g_glState.SetScissorTest(true);
+    glScissor(region.x, this->Height - region.y - region.height, region.width, region.height);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (g_config.batchRendering && timedFade) {
+        // instance data never changes after spawning: upload only the new
+        // slots into the GPU mirror of the ring and draw its live window
+        RingBuffer->Sync(this->particles, this->pendingWrites, g_config.spriteSize);
+        this->pendingWrites = 0;
+
+        BatchRenderer->SetFade(true, this->currentTime);
+        for (unsigned int s = 0; s < spans; s++) {
+            BatchRenderer->DrawInstances(tex, RingBuffer->GetBuffer(), first[s], count[s]);
+        }
+    }
+    else {
+        if (g_config.batchRendering) {
+            BatchRenderer->SetFade(false, this->currentTime);
+            BatchRenderer->Begin();
         }
 
-        this->parts[i].time = newTime;
-
-        TrailPart part = this->parts[i];
-
-
-        float alpha = part.time;
+        const float* xs = this->particles.Attribute(PARTICLE_X);
+        const float* ys = this->particles.Attribute(PARTICLE_Y);
+        for (unsigned int s = 0; s < spans; s++) {
+            for (unsigned int i = first[s]; i < first[s] + count[s]; i++) {
+
+                // opacity follows from the particle age in FADE_TIME mode, nothing is written back
+                float alpha = this->particles.AlphaAt(i, g_config.fadeMode, this->currentTime);
+
+                glm::vec2 position = glm::vec2(xs[i]-(g_config.spriteSize/2.0), ys[i]-(g_config.spriteSize/2.0));
+
+                if (g_config.batchRendering) {
+                    // faded out particles contribute nothing, keep them out of the instance upload
+                    if (alpha > 0.0f) {
+                        BatchRenderer->Add(position, g_config.spriteSize, alpha);
+                    }
+                    continue;
+                }
+
+                Renderer->DrawSprite(
+                    tex,
+                    position,
+                    glm::vec2(g_config.spriteSize, g_config.spriteSize),
+                    0,
+                    alpha);
+            }
+        }
 
-        Renderer->DrawSprite(
-            tex,
-            glm::vec2(part.x-(g_config.spriteSize/2.0), part.y-(g_config.spriteSize/2.0)),
-            glm::vec2(g_config.spriteSize, g_config.spriteSize),
-            0,
-            alpha);
+        if (g_config.batchRendering) {
+            BatchRenderer->Flush(tex);
+        }
     }
 
+    g_glState.SetScissorTest(false);
+    Stream->EndFrame();
+
 }
\ No newline at end of file
@@ -2,9 +2,16 @@
 #define GAME_H
 
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include "TrailPart.h"
+#include "ParticleStore.h"
+#include "TrailEmitter.h"
+#include "CursorFilter.h"
+#include "TrailSimulation.h"
 #include "Config.h"
+#include "Clock.h"
+#include "DamageTracker.h"
+#include "ResourceManager.h"
+#include "CursorTrace.h"
 
 // Represents the current state of the game
 enum GameState {
@@ -21,19 +28,42 @@ class Game
 public:
     // game state
     GameState               State;
-    TrailPart*              parts;      // Dynamic array based on config
-    int                     currentIndex;
+    ParticleStore           particles;  // Circular particle buffer sized from config
+    TrailEmitter            emitter;    // spawns particles along the cursor path
+    CursorFilter            filter;     // smooths the cursor samples before the emitter
+    unsigned int            pendingWrites;  // slots written since the last GPU ring buffer sync
     unsigned int            Width, Height;
+    int                     OriginX, OriginY;   // screen position of the window's top-left corner
+    Clock                   clock;
+    float                   currentTime;    // Clock time of the current frame
+    double                  cursorX, cursorY;   // cursor position seen by the last Update
+    bool                    cursorMoved;    // cursor position changed in the last Update
+    bool                    headParked;     // the newest particle is the refreshed head under a resting cursor
+    bool                    simulated;      // the trail comes from Show, already faded
+    TrailTotals             shown;          // totals of the last snapshot shown
+    DamageTracker           damage;     // surface area changed by the trail each frame
+    ShaderHandle            spriteShader, instancedShader;  // resolved once by Init
+    TextureHandle           trailTexture;
     
     // constructor/destructor
     Game();
     ~Game();
     // initialize game state (load all shaders/textures/levels)
     void Init();
-    // game loop
-    void Update(GLFWwindow* window);
-    void Render();
-    void AddPart(TrailPart part);
+    // moves the drawing surface to the given screen rectangle; particles
+    // keep screen coordinates and are translated by the projection
+    void SetSurface(int x, int y, unsigned int width, unsigned int height);
+    // game loop, advances the simulation to the sample's time and cursor
+    void Update(const CursorSample& sample);
+    // takes the trail of a simulation thread snapshot instead of running
+    // Update; the snapshot gets the previous trail in exchange
+    void Show(TrailSnapshot& snapshot);
+    // clears and draws the damaged part of a back buffer drawn bufferAge
+    // frames ago (0: unknown content, the whole surface is repainted)
+    void Render(int bufferAge = 0);
+    // true once the trail has faded out and the cursor rests: nothing
+    // would be drawn, so the main loop can stop rendering and presenting
+    bool IsIdle() const;
 };
 
 #endif
\ No newline at end of file
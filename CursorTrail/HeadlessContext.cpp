@@ -0,0 +1,162 @@
+#include "HeadlessContext.h"
+#include "Stats.h"
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    // core profile versions to try, the newest the driver accepts wins
+    const int ContextVersions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 3, 3 } };
+
+    bool HasExtension(const char* extensions, const char* name)
+    {
+        if (extensions == nullptr) {
+            return false;
+        }
+        size_t length = std::strlen(name);
+        for (const char* p = std::strstr(extensions, name); p != nullptr; p = std::strstr(p + length, name)) {
+            bool starts = p == extensions || p[-1] == ' ';
+            bool ends = p[length] == '\0' || p[length] == ' ';
+            if (starts && ends) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+HeadlessContext::HeadlessContext()
+    : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT), framebuffer(0), colorBuffer(0), width(0), height(0)
+{
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    this->Destroy();
+}
+
+bool HeadlessContext::Create(int width, int height)
+{
+    // the surfaceless platform needs neither a GPU nor a display server
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay display = EGL_NO_DISPLAY;
+    if (getPlatformDisplay != nullptr && HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::cout << "ERROR::HEADLESS: Failed to initialize EGL" << std::endl;
+        return false;
+    }
+    this->display = display;
+
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!HasExtension(extensions, "EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API)) {
+        std::cout << "ERROR::HEADLESS: EGL " << major << "." << minor << " has no surfaceless desktop OpenGL" << std::endl;
+        this->Destroy();
+        return false;
+    }
+
+    // rendering goes to our own framebuffer, the context needs no config
+    // where EGL_KHR_no_config_context is available
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    if (!HasExtension(extensions, "EGL_KHR_no_config_context")) {
+        EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLint found = 0;
+        if (!eglChooseConfig(display, configAttribs, &config, 1, &found) || found == 0) {
+            std::cout << "ERROR::HEADLESS: No EGL config for desktop OpenGL" << std::endl;
+            this->Destroy();
+            return false;
+        }
+    }
+    for (const int* version : ContextVersions) {
+        EGLint contextAttribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, version[0],
+            EGL_CONTEXT_MINOR_VERSION, version[1],
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        this->context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+        if (this->context != EGL_NO_CONTEXT) {
+            break;
+        }
+    }
+    if (this->context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, this->context)) {
+        std::cout << "ERROR::HEADLESS: Failed to create an OpenGL 3.3+ core context" << std::endl;
+        this->Destroy();
+        return false;
+    }
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        this->Destroy();
+        return false;
+    }
+
+    this->width = width;
+    this->height = height;
+    glGenFramebuffers(1, &this->framebuffer);
+    glGenRenderbuffers(1, &this->colorBuffer);
+    g_stats.glObjects += 2;
+    glBindRenderbuffer(GL_RENDERBUFFER, this->colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->colorBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "ERROR::HEADLESS: Framebuffer of " << width << "x" << height << " is incomplete" << std::endl;
+        this->Destroy();
+        return false;
+    }
+
+    std::cout << "Headless: " << glGetString(GL_RENDERER) << ", OpenGL " << glGetString(GL_VERSION)
+              << ", " << width << "x" << height << " framebuffer" << std::endl;
+    return true;
+}
+
+void HeadlessContext::Destroy()
+{
+    if (this->context != EGL_NO_CONTEXT) {
+        if (this->framebuffer != 0) {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDeleteFramebuffers(1, &this->framebuffer);
+            glDeleteRenderbuffers(1, &this->colorBuffer);
+            g_stats.glObjects -= 2;
+            this->framebuffer = 0;
+            this->colorBuffer = 0;
+        }
+        eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(this->display, this->context);
+        this->context = EGL_NO_CONTEXT;
+    }
+    if (this->display != EGL_NO_DISPLAY) {
+        eglTerminate(this->display);
+        this->display = EGL_NO_DISPLAY;
+    }
+}
+
+void HeadlessContext::ReadPixels(std::vector<unsigned char>& pixels)
+{
+    size_t row = static_cast<size_t>(this->width) * 4;
+    pixels.resize(row * this->height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, this->width, this->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    // GL rows start at the bottom
+    std::vector<unsigned char> swap(row);
+    for (int y = 0; y < this->height / 2; y++) {
+        unsigned char* top = pixels.data() + y * row;
+        unsigned char* bottom = pixels.data() + (this->height - 1 - y) * row;
+        std::memcpy(swap.data(), top, row);
+        std::memcpy(top, bottom, row);
+        std::memcpy(bottom, swap.data(), row);
+    }
+}
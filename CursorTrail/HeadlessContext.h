@@ -0,0 +1,31 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <vector>
+
+// OpenGL context without a window or display server: a surfaceless EGL
+// context (Mesa, works on llvmpipe without a GPU) rendering into a
+// framebuffer object of a fixed size. Used to run and benchmark the
+// renderer on build machines and in containers.
+class HeadlessContext
+{
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+    // creates the context and a width x height RGBA8 framebuffer, makes
+    // both current and loads the GL functions
+    bool Create(int width, int height);
+    void Destroy();
+    // reads the framebuffer as tightly packed RGBA rows, top row first
+    void ReadPixels(std::vector<unsigned char>& pixels);
+    int  Width() const { return this->width; }
+    int  Height() const { return this->height; }
+private:
+    void*        display;
+    void*        context;
+    unsigned int framebuffer;
+    unsigned int colorBuffer;
+    int          width, height;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "ImageCompare.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+    // largest possible YIQ distance, between black and white
+    const double MaxYiqDelta = 35215.0;
+
+    double Luma(double r, double g, double b)
+    {
+        return r * 0.29889531 + g * 0.58662247 + b * 0.11448223;
+    }
+
+    // squared YIQ distance of two opaque colors
+    double YiqDelta(const double a[3], const double b[3])
+    {
+        double y = Luma(a[0], a[1], a[2]) - Luma(b[0], b[1], b[2]);
+        double i = (a[0] * 0.59597799 - a[1] * 0.27417610 - a[2] * 0.32180189) -
+                   (b[0] * 0.59597799 - b[1] * 0.27417610 - b[2] * 0.32180189);
+        double q = (a[0] * 0.21147017 - a[1] * 0.52261711 + a[2] * 0.31114694) -
+                   (b[0] * 0.21147017 - b[1] * 0.52261711 + b[2] * 0.31114694);
+        return 0.5053 * y * y + 0.299 * i * i + 0.1957 * q * q;
+    }
+
+    // the pixel composited over a background gray level
+    void Over(const unsigned char* pixel, double background, double out[3])
+    {
+        double alpha = pixel[3] / 255.0;
+        for (int c = 0; c < 3; c++) {
+            out[c] = pixel[c] * alpha + background * (1.0 - alpha);
+        }
+    }
+}
+
+ImageDiff ImageCompare::Compare(const std::vector<unsigned char>& expected, const std::vector<unsigned char>& actual,
+                                int width, int height, double threshold, std::vector<unsigned char>* diff)
+{
+    ImageDiff result;
+    result.total = static_cast<unsigned int>(width) * height;
+    if (diff != nullptr) {
+        diff->resize(static_cast<size_t>(result.total) * 4);
+    }
+
+    double limit = MaxYiqDelta * threshold * threshold;
+    for (unsigned int p = 0; p < result.total; p++) {
+        const unsigned char* a = &expected[p * 4];
+        const unsigned char* b = &actual[p * 4];
+
+        double delta = 0.0;
+        if (a[0] != b[0] || a[1] != b[1] || a[2] != b[2] || a[3] != b[3]) {
+            const double backgrounds[2] = { 0.0, 255.0 };
+            for (double background : backgrounds) {
+                double overA[3], overB[3];
+                Over(a, background, overA);
+                Over(b, background, overB);
+                delta = std::max(delta, YiqDelta(overA, overB));
+            }
+        }
+        result.maxDelta = std::max(result.maxDelta, std::sqrt(delta / MaxYiqDelta));
+        bool mismatch = delta > limit;
+        if (mismatch) {
+            result.mismatched++;
+        }
+
+        if (diff != nullptr) {
+            unsigned char* out = &(*diff)[p * 4];
+            if (mismatch) {
+                out[0] = 255;
+                out[1] = 0;
+                out[2] = 0;
+            }
+            else {
+                // the reference over white, faded so the red stands out
+                double over[3];
+                Over(a, 255.0, over);
+                unsigned char gray = static_cast<unsigned char>(255.0 - (255.0 - Luma(over[0], over[1], over[2])) * 0.1);
+                out[0] = gray;
+                out[1] = gray;
+                out[2] = gray;
+            }
+            out[3] = 255;
+        }
+    }
+    return result;
+}
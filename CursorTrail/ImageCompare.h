@@ -0,0 +1,32 @@
+#ifndef IMAGE_COMPARE_H
+#define IMAGE_COMPARE_H
+
+#include <vector>
+
+// Result of comparing two images
+struct ImageDiff
+{
+    unsigned int mismatched;    // pixels whose difference exceeds the threshold
+    unsigned int total;         // pixels compared
+    double       maxDelta;      // largest perceptual difference found, 0..1
+
+    ImageDiff() : mismatched(0), total(0), maxDelta(0.0) { }
+    bool Passed() const { return this->mismatched == 0; }
+};
+
+// Perceptual comparison of RGBA frames for golden-image checks. Pixels
+// are compared by their YIQ color distance (as in pixelmatch), so small
+// rasterization and rounding differences pass while visible changes do
+// not. The trail is drawn over an unknown desktop: every pixel is
+// composited over black and over white and the larger distance counts.
+class ImageCompare
+{
+public:
+    // compares two width x height RGBA images; with diff, also produces
+    // an RGBA image that shows the reference faded to gray and the
+    // mismatching pixels in red
+    static ImageDiff Compare(const std::vector<unsigned char>& expected, const std::vector<unsigned char>& actual,
+                             int width, int height, double threshold, std::vector<unsigned char>* diff = nullptr);
+};
+
+#endif
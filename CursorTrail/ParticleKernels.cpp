@@ -0,0 +1,488 @@
+// The kernels use the glm SIMD layer directly. Only the architecture
+// detection and the intrinsic wrappers are included here, no glm types,
+// so forcing intrinsics does not change any layout shared with other
+// translation units.
+#ifndef GLM_FORCE_INTRINSICS
+#define GLM_FORCE_INTRINSICS
+#endif
+#include <glm/detail/setup.hpp>
+#include <glm/simd/common.h>
+
+#include "ParticleKernels.h"
+
+#include <limits>
+
+
+namespace
+{
+    inline bool IsAlive(const float* alpha, const float* spawnTime, const float* lifetime, size_t i, bool timedFade, float now)
+    {
+        if (timedFade) {
+            return now - spawnTime[i] < lifetime[i];
+        }
+        return alpha[i] > 0.0f;
+    }
+
+    // scalar loops, used for the tails of the vector loops and on other architectures
+    void FadeScalar(float* alpha, size_t begin, size_t end, float rate)
+    {
+        for (size_t i = begin; i < end; i++) {
+            float value = alpha[i] - rate;
+            alpha[i] = value > 0.0f ? value : 0.0f;
+        }
+    }
+
+    void ShiftScalar(float* time, size_t begin, size_t end, float shift)
+    {
+        for (size_t i = begin; i < end; i++) {
+            time[i] -= shift;
+        }
+    }
+
+    void CubicScalar(const float coefficients[4], const float* u, float* out, size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++) {
+            out[i] = ((coefficients[0] * u[i] + coefficients[1]) * u[i] + coefficients[2]) * u[i] + coefficients[3];
+        }
+    }
+
+    size_t CountScalar(const float* alpha, const float* spawnTime, const float* lifetime,
+                       size_t begin, size_t end, bool timedFade, float now)
+    {
+        size_t alive = 0;
+        for (size_t i = begin; i < end; i++) {
+            if (IsAlive(alpha, spawnTime, lifetime, i, timedFade, now)) {
+                alive++;
+            }
+        }
+        return alive;
+    }
+
+    void BoundsScalar(const float* x, const float* y, const float* alpha, const float* spawnTime,
+                      const float* lifetime, size_t begin, size_t end, bool timedFade, float now, float bounds[4])
+    {
+        for (size_t i = begin; i < end; i++) {
+            if (!IsAlive(alpha, spawnTime, lifetime, i, timedFade, now)) {
+                continue;
+            }
+            if (x[i] < bounds[0]) bounds[0] = x[i];
+            if (y[i] < bounds[1]) bounds[1] = y[i];
+            if (x[i] > bounds[2]) bounds[2] = x[i];
+            if (y[i] > bounds[3]) bounds[3] = y[i];
+        }
+    }
+}
+
+#if GLM_ARCH & GLM_ARCH_AVX2_BIT
+
+namespace
+{
+    const size_t Width = 8;
+
+    inline __m256 AliveMask8(const float* alpha, const float* spawnTime, const float* lifetime, size_t i, bool timedFade, __m256 now)
+    {
+        if (timedFade) {
+            __m256 age = _mm256_sub_ps(now, _mm256_loadu_ps(spawnTime + i));
+            return _mm256_cmp_ps(age, _mm256_loadu_ps(lifetime + i), _CMP_LT_OQ);
+        }
+        return _mm256_cmp_ps(_mm256_loadu_ps(alpha + i), _mm256_setzero_ps(), _CMP_GT_OQ);
+    }
+
+    inline float HorizontalMin8(__m256 v)
+    {
+        __m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+        m = _mm_min_ss(m, _mm_shuffle_ps(m, m, 1));
+        return _mm_cvtss_f32(m);
+    }
+
+    inline float HorizontalMax8(__m256 v)
+    {
+        __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+        m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+        return _mm_cvtss_f32(m);
+    }
+}
+
+const char* ParticleKernelArch()
+{
+    return "AVX2";
+}
+
+void FadeKernel(float* alpha, size_t count, float rate)
+{
+    size_t vectorEnd = count - count % Width;
+    __m256 r = _mm256_set1_ps(rate);
+    __m256 zero = _mm256_setzero_ps();
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        __m256 value = _mm256_sub_ps(_mm256_loadu_ps(alpha + i), r);
+        _mm256_storeu_ps(alpha + i, _mm256_max_ps(value, zero));
+    }
+    FadeScalar(alpha, vectorEnd, count, rate);
+}
+
+void ShiftKernel(float* time, size_t count, float shift)
+{
+    size_t vectorEnd = count - count % Width;
+    __m256 s = _mm256_set1_ps(shift);
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        _mm256_storeu_ps(time + i, _mm256_sub_ps(_mm256_loadu_ps(time + i), s));
+    }
+    ShiftScalar(time, vectorEnd, count, shift);
+}
+
+void CubicKernel(const float coefficients[4], const float* u, float* out, size_t count)
+{
+    size_t vectorEnd = count - count % Width;
+    __m256 c0 = _mm256_set1_ps(coefficients[0]);
+    __m256 c1 = _mm256_set1_ps(coefficients[1]);
+    __m256 c2 = _mm256_set1_ps(coefficients[2]);
+    __m256 c3 = _mm256_set1_ps(coefficients[3]);
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        __m256 t = _mm256_loadu_ps(u + i);
+        __m256 value = _mm256_add_ps(_mm256_mul_ps(c0, t), c1);
+        value = _mm256_add_ps(_mm256_mul_ps(value, t), c2);
+        value = _mm256_add_ps(_mm256_mul_ps(value, t), c3);
+        _mm256_storeu_ps(out + i, value);
+    }
+    CubicScalar(coefficients, u, out, vectorEnd, count);
+}
+
+size_t CountAliveKernel(const float* alpha, const float* spawnTime, const float* lifetime,
+                        size_t count, bool timedFade, float now)
+{
+    size_t vectorEnd = count - count % Width;
+    __m256 t = _mm256_set1_ps(now);
+    // live lanes are all ones (-1 as integer), subtracting the mask counts them per lane
+    __m256i lanes = _mm256_setzero_si256();
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        __m256 mask = AliveMask8(alpha, spawnTime, lifetime, i, timedFade, t);
+        lanes = _mm256_sub_epi32(lanes, _mm256_castps_si256(mask));
+    }
+    alignas(32) int sums[Width];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sums), lanes);
+    size_t alive = 0;
+    for (size_t lane = 0; lane < Width; lane++) {
+        alive += static_cast<size_t>(sums[lane]);
+    }
+    return alive + CountScalar(alpha, spawnTime, lifetime, vectorEnd, count, timedFade, now);
+}
+
+bool BoundsKernel(const float* x, const float* y, const float* alpha, const float* spawnTime,
+                  const float* lifetime, size_t count, bool timedFade, float now, float bounds[4])
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    size_t vectorEnd = count - count % Width;
+    __m256 t = _mm256_set1_ps(now);
+    __m256 posInf = _mm256_set1_ps(inf);
+    __m256 negInf = _mm256_set1_ps(-inf);
+    __m256 minX = posInf, minY = posInf, maxX = negInf, maxY = negInf;
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        __m256 mask = AliveMask8(alpha, spawnTime, lifetime, i, timedFade, t);
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        minX = _mm256_min_ps(minX, _mm256_blendv_ps(posInf, vx, mask));
+        minY = _mm256_min_ps(minY, _mm256_blendv_ps(posInf, vy, mask));
+        maxX = _mm256_max_ps(maxX, _mm256_blendv_ps(negInf, vx, mask));
+        maxY = _mm256_max_ps(maxY, _mm256_blendv_ps(negInf, vy, mask));
+    }
+    float result[4] = { HorizontalMin8(minX), HorizontalMin8(minY), HorizontalMax8(maxX), HorizontalMax8(maxY) };
+    BoundsScalar(x, y, alpha, spawnTime, lifetime, vectorEnd, count, timedFade, now, result);
+    if (result[0] > result[2]) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        bounds[i] = result[i];
+    }
+    return true;
+}
+
+#elif GLM_ARCH & GLM_ARCH_SSE2_BIT
+
+namespace
+{
+    const size_t Width = 4;
+
+    inline glm_vec4 AliveMask4(const float* alpha, const float* spawnTime, const float* lifetime, size_t i, bool timedFade, glm_vec4 now)
+    {
+        if (timedFade) {
+            glm_vec4 age = glm_vec4_sub(now, _mm_loadu_ps(spawnTime + i));
+            return _mm_cmplt_ps(age, _mm_loadu_ps(lifetime + i));
+        }
+        return _mm_cmpgt_ps(_mm_loadu_ps(alpha + i), _mm_setzero_ps());
+    }
+
+    // mask ? a : b without SSE4.1 blendv
+    inline glm_vec4 Select4(glm_vec4 mask, glm_vec4 a, glm_vec4 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    inline float HorizontalMin4(glm_vec4 v)
+    {
+        v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_min_ss(v, _mm_shuffle_ps(v, v, 1));
+        return _mm_cvtss_f32(v);
+    }
+
+    inline float HorizontalMax4(glm_vec4 v)
+    {
+        v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+        return _mm_cvtss_f32(v);
+    }
+}
+
+const char* ParticleKernelArch()
+{
+    return "SSE2";
+}
+
+void FadeKernel(float* alpha, size_t count, float rate)
+{
+    size_t vectorEnd = count - count % Width;
+    glm_vec4 r = _mm_set1_ps(rate);
+    glm_vec4 zero = _mm_setzero_ps();
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        glm_vec4 value = glm_vec4_sub(_mm_loadu_ps(alpha + i), r);
+        _mm_storeu_ps(alpha + i, _mm_max_ps(value, zero));
+    }
+    FadeScalar(alpha, vectorEnd, count, rate);
+}
+
+void ShiftKernel(float* time, size_t count, float shift)
+{
+    size_t vectorEnd = count - count % Width;
+    glm_vec4 s = _mm_set1_ps(shift);
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        _mm_storeu_ps(time + i, glm_vec4_sub(_mm_loadu_ps(time + i), s));
+    }
+    ShiftScalar(time, vectorEnd, count, shift);
+}
+
+void CubicKernel(const float coefficients[4], const float* u, float* out, size_t count)
+{
+    size_t vectorEnd = count - count % Width;
+    glm_vec4 c0 = _mm_set1_ps(coefficients[0]);
+    glm_vec4 c1 = _mm_set1_ps(coefficients[1]);
+    glm_vec4 c2 = _mm_set1_ps(coefficients[2]);
+    glm_vec4 c3 = _mm_set1_ps(coefficients[3]);
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        glm_vec4 t = _mm_loadu_ps(u + i);
+        glm_vec4 value = glm_vec4_add(glm_vec4_mul(c0, t), c1);
+        value = glm_vec4_add(glm_vec4_mul(value, t), c2);
+        value = glm_vec4_add(glm_vec4_mul(value, t), c3);
+        _mm_storeu_ps(out + i, value);
+    }
+    CubicScalar(coefficients, u, out, vectorEnd, count);
+}
+
+size_t CountAliveKernel(const float* alpha, const float* spawnTime, const float* lifetime,
+                        size_t count, bool timedFade, float now)
+{
+    size_t vectorEnd = count - count % Width;
+    glm_vec4 t = _mm_set1_ps(now);
+    // live lanes are all ones (-1 as integer), subtracting the mask counts them per lane
+    glm_ivec4 lanes = _mm_setzero_si128();
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        glm_vec4 mask = AliveMask4(alpha, spawnTime, lifetime, i, timedFade, t);
+        lanes = _mm_sub_epi32(lanes, _mm_castps_si128(mask));
+    }
+    alignas(16) int sums[Width];
+    _mm_store_si128(reinterpret_cast<glm_ivec4*>(sums), lanes);
+    size_t alive = static_cast<size_t>(sums[0]) + sums[1] + sums[2] + sums[3];
+    return alive + CountScalar(alpha, spawnTime, lifetime, vectorEnd, count, timedFade, now);
+}
+
+bool BoundsKernel(const float* x, const float* y, const float* alpha, const float* spawnTime,
+                  const float* lifetime, size_t count, bool timedFade, float now, float bounds[4])
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    size_t vectorEnd = count - count % Width;
+    glm_vec4 t = _mm_set1_ps(now);
+    glm_vec4 posInf = _mm_set1_ps(inf);
+    glm_vec4 negInf = _mm_set1_ps(-inf);
+    glm_vec4 minX = posInf, minY = posInf, maxX = negInf, maxY = negInf;
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        glm_vec4 mask = AliveMask4(alpha, spawnTime, lifetime, i, timedFade, t);
+        glm_vec4 vx = _mm_loadu_ps(x + i);
+        glm_vec4 vy = _mm_loadu_ps(y + i);
+        minX = _mm_min_ps(minX, Select4(mask, vx, posInf));
+        minY = _mm_min_ps(minY, Select4(mask, vy, posInf));
+        maxX = _mm_max_ps(maxX, Select4(mask, vx, negInf));
+        maxY = _mm_max_ps(maxY, Select4(mask, vy, negInf));
+    }
+    float result[4] = { HorizontalMin4(minX), HorizontalMin4(minY), HorizontalMax4(maxX), HorizontalMax4(maxY) };
+    BoundsScalar(x, y, alpha, spawnTime, lifetime, vectorEnd, count, timedFade, now, result);
+    if (result[0] > result[2]) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        bounds[i] = result[i];
+    }
+    return true;
+}
+
+#elif GLM_ARCH & GLM_ARCH_NEON_BIT
+
+namespace
+{
+    const size_t Width = 4;
+
+    inline uint32x4_t AliveMask4(const float* alpha, const float* spawnTime, const float* lifetime, size_t i, bool timedFade, float32x4_t now)
+    {
+        if (timedFade) {
+            float32x4_t age = vsubq_f32(now, vld1q_f32(spawnTime + i));
+            return vcltq_f32(age, vld1q_f32(lifetime + i));
+        }
+        return vcgtq_f32(vld1q_f32(alpha + i), vdupq_n_f32(0.0f));
+    }
+
+    inline float HorizontalMin4(float32x4_t v)
+    {
+        float32x2_t m = vpmin_f32(vget_low_f32(v), vget_high_f32(v));
+        m = vpmin_f32(m, m);
+        return vget_lane_f32(m, 0);
+    }
+
+    inline float HorizontalMax4(float32x4_t v)
+    {
+        float32x2_t m = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+        m = vpmax_f32(m, m);
+        return vget_lane_f32(m, 0);
+    }
+}
+
+const char* ParticleKernelArch()
+{
+    return "NEON";
+}
+
+void FadeKernel(float* alpha, size_t count, float rate)
+{
+    size_t vectorEnd = count - count % Width;
+    float32x4_t r = vdupq_n_f32(rate);
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        float32x4_t value = vsubq_f32(vld1q_f32(alpha + i), r);
+        vst1q_f32(alpha + i, vmaxq_f32(value, zero));
+    }
+    FadeScalar(alpha, vectorEnd, count, rate);
+}
+
+void ShiftKernel(float* time, size_t count, float shift)
+{
+    size_t vectorEnd = count - count % Width;
+    float32x4_t s = vdupq_n_f32(shift);
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        vst1q_f32(time + i, vsubq_f32(vld1q_f32(time + i), s));
+    }
+    ShiftScalar(time, vectorEnd, count, shift);
+}
+
+void CubicKernel(const float coefficients[4], const float* u, float* out, size_t count)
+{
+    size_t vectorEnd = count - count % Width;
+    float32x4_t c1 = vdupq_n_f32(coefficients[1]);
+    float32x4_t c2 = vdupq_n_f32(coefficients[2]);
+    float32x4_t c3 = vdupq_n_f32(coefficients[3]);
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        float32x4_t t = vld1q_f32(u + i);
+        float32x4_t value = vmlaq_n_f32(c1, t, coefficients[0]);
+        value = vmlaq_f32(c2, value, t);
+        value = vmlaq_f32(c3, value, t);
+        vst1q_f32(out + i, value);
+    }
+    CubicScalar(coefficients, u, out, vectorEnd, count);
+}
+
+size_t CountAliveKernel(const float* alpha, const float* spawnTime, const float* lifetime,
+                        size_t count, bool timedFade, float now)
+{
+    size_t vectorEnd = count - count % Width;
+    float32x4_t t = vdupq_n_f32(now);
+    uint32x4_t lanes = vdupq_n_u32(0);
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        uint32x4_t mask = AliveMask4(alpha, spawnTime, lifetime, i, timedFade, t);
+        lanes = vsubq_u32(lanes, mask);
+    }
+    uint32_t sums[Width];
+    vst1q_u32(sums, lanes);
+    size_t alive = static_cast<size_t>(sums[0]) + sums[1] + sums[2] + sums[3];
+    return alive + CountScalar(alpha, spawnTime, lifetime, vectorEnd, count, timedFade, now);
+}
+
+bool BoundsKernel(const float* x, const float* y, const float* alpha, const float* spawnTime,
+                  const float* lifetime, size_t count, bool timedFade, float now, float bounds[4])
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    size_t vectorEnd = count - count % Width;
+    float32x4_t t = vdupq_n_f32(now);
+    float32x4_t posInf = vdupq_n_f32(inf);
+    float32x4_t negInf = vdupq_n_f32(-inf);
+    float32x4_t minX = posInf, minY = posInf, maxX = negInf, maxY = negInf;
+    for (size_t i = 0; i < vectorEnd; i += Width) {
+        uint32x4_t mask = AliveMask4(alpha, spawnTime, lifetime, i, timedFade, t);
+        float32x4_t vx = vld1q_f32(x + i);
+        float32x4_t vy = vld1q_f32(y + i);
+        minX = vminq_f32(minX, vbslq_f32(mask, vx, posInf));
+        minY = vminq_f32(minY, vbslq_f32(mask, vy, posInf));
+        maxX = vmaxq_f32(maxX, vbslq_f32(mask, vx, negInf));
+        maxY = vmaxq_f32(maxY, vbslq_f32(mask, vy, negInf));
+    }
+    float result[4] = { HorizontalMin4(minX), HorizontalMin4(minY), HorizontalMax4(maxX), HorizontalMax4(maxY) };
+    BoundsScalar(x, y, alpha, spawnTime, lifetime, vectorEnd, count, timedFade, now, result);
+    if (result[0] > result[2]) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        bounds[i] = result[i];
+    }
+    return true;
+}
+
+#else
+
+const char* ParticleKernelArch()
+{
+    return "scalar";
+}
+
+void FadeKernel(float* alpha, size_t count, float rate)
+{
+    FadeScalar(alpha, 0, count, rate);
+}
+
+void ShiftKernel(float* time, size_t count, float shift)
+{
+    ShiftScalar(time, 0, count, shift);
+}
+
+void CubicKernel(const float coefficients[4], const float* u, float* out, size_t count)
+{
+    CubicScalar(coefficients, u, out, 0, count);
+}
+
+size_t CountAliveKernel(const float* alpha, const float* spawnTime, const float* lifetime,
+                        size_t count, bool timedFade, float now)
+{
+    return CountScalar(alpha, spawnTime, lifetime, 0, count, timedFade, now);
+}
+
+bool BoundsKernel(const float* x, const float* y, const float* alpha, const float* spawnTime,
+                  const float* lifetime, size_t count, bool timedFade, float now, float bounds[4])
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    float result[4] = { inf, inf, -inf, -inf };
+    BoundsScalar(x, y, alpha, spawnTime, lifetime, 0, count, timedFade, now, result);
+    if (result[0] > result[2]) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        bounds[i] = result[i];
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef PARTICLE_KERNELS_H
+#define PARTICLE_KERNELS_H
+
+#include <cstddef>
+
+// Vectorized loops over the structure-of-arrays particle attributes kept
+// by ParticleStore. Each kernel has an SSE2, AVX2 and NEON variant picked
+// at compile time from the glm/simd architecture detection, plus a scalar
+// fallback. All pointers may be unaligned and count may be any value.
+//
+// A particle is alive while
+//   timedFade == false: alpha > 0
+//   timedFade == true:  now - spawnTime < lifetime
+
+// name of the instruction set the kernels were built for
+const char*  ParticleKernelArch();
+// alpha[i] = max(alpha[i] - rate, 0)
+void         FadeKernel(float* alpha, size_t count, float rate);
+// subtracts shift from every timestamp
+void         ShiftKernel(float* time, size_t count, float shift);
+// out[i] = ((c[0] * u[i] + c[1]) * u[i] + c[2]) * u[i] + c[3], one coordinate
+// of a cubic curve evaluated at a batch of parameters
+void         CubicKernel(const float coefficients[4], const float* u, float* out, size_t count);
+// number of live particles
+size_t       CountAliveKernel(const float* alpha, const float* spawnTime, const float* lifetime,
+                              size_t count, bool timedFade, float now);
+// bounding box {minX, minY, maxX, maxY} of the live particle centers;
+// returns false and leaves bounds untouched when none is alive
+bool         BoundsKernel(const float* x, const float* y, const float* alpha, const float* spawnTime,
+                          const float* lifetime, size_t count, bool timedFade, float now, float bounds[4]);
+
+#endif
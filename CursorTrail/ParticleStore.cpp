@@ -0,0 +1,250 @@
+#include "ParticleStore.h"
+#include "ParticleKernels.h"
+
+#include <cstring>
+#include <utility>
+#include <new>
+
+
+ParticleStore::ParticleStore() : capacity(0), stride(0), head(0), tail(0), live(0)
+{
+    for (int i = 0; i < PARTICLE_ATTRIBUTE_COUNT; i++) {
+        this->attributes[i] = nullptr;
+    }
+}
+
+ParticleStore::~ParticleStore()
+{
+    this->release();
+}
+
+void ParticleStore::Resize(unsigned int capacity)
+{
+    this->release();
+    this->capacity = capacity;
+    this->stride = (capacity + Padding - 1) / Padding * Padding;
+    this->head = 0;
+    this->tail = 0;
+    this->live = 0;
+    for (int i = 0; i < PARTICLE_ATTRIBUTE_COUNT; i++) {
+        void* memory = ::operator new[](this->stride * sizeof(float), std::align_val_t(Alignment));
+        // all zero: no opacity and no lifetime, the particle is dead in both fade modes
+        std::memset(memory, 0, this->stride * sizeof(float));
+        this->attributes[i] = static_cast<float*>(memory);
+    }
+}
+
+void ParticleStore::Add(const TrailPart& part)
+{
+    unsigned int i = this->head;
+    this->attributes[PARTICLE_X][i] = part.x;
+    this->attributes[PARTICLE_Y][i] = part.y;
+    this->attributes[PARTICLE_ALPHA][i] = part.time;
+    this->attributes[PARTICLE_SPAWN_TIME][i] = part.spawnTime;
+    this->attributes[PARTICLE_LIFETIME][i] = part.lifetime;
+
+    this->head++;
+    if (this->head == this->capacity) {
+        this->head = 0;
+    }
+    // a full ring overwrites its oldest particle
+    if (this->live == this->capacity) {
+        this->tail = this->head;
+    }
+    else {
+        this->live++;
+    }
+}
+
+unsigned int ParticleStore::Append(unsigned int count, unsigned int first[2], unsigned int spanCount[2])
+{
+    if (count > this->capacity) {
+        count = this->capacity;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    unsigned int spans = 1;
+    first[0] = this->head;
+    if (this->head + count <= this->capacity) {
+        spanCount[0] = count;
+    }
+    else {
+        spanCount[0] = this->capacity - this->head;
+        first[1] = 0;
+        spanCount[1] = count - spanCount[0];
+        spans = 2;
+    }
+
+    this->head += count;
+    if (this->head >= this->capacity) {
+        this->head -= this->capacity;
+    }
+    if (this->live + count >= this->capacity) {
+        this->live = this->capacity;
+        this->tail = this->head;
+    }
+    else {
+        this->live += count;
+    }
+    return spans;
+}
+
+unsigned int ParticleStore::LiveSpans(unsigned int first[2], unsigned int count[2]) const
+{
+    if (this->live == 0) {
+        return 0;
+    }
+    first[0] = this->tail;
+    if (this->tail + this->live <= this->capacity) {
+        count[0] = this->live;
+        return 1;
+    }
+    count[0] = this->capacity - this->tail;
+    first[1] = 0;
+    count[1] = this->live - count[0];
+    return 2;
+}
+
+void ParticleStore::Expire(FadeMode mode, float now)
+{
+    while (this->live > 0 && !this->isAlive(this->tail, mode, now)) {
+        this->tail++;
+        if (this->tail == this->capacity) {
+            this->tail = 0;
+        }
+        this->live--;
+    }
+}
+
+TrailPart ParticleStore::Get(unsigned int index) const
+{
+    return TrailPart(
+        this->attributes[PARTICLE_X][index],
+        this->attributes[PARTICLE_Y][index],
+        this->attributes[PARTICLE_ALPHA][index],
+        this->attributes[PARTICLE_SPAWN_TIME][index],
+        this->attributes[PARTICLE_LIFETIME][index]);
+}
+
+float ParticleStore::AlphaAt(unsigned int index, FadeMode mode, float now) const
+{
+    if (mode == FADE_FRAME) {
+        return this->attributes[PARTICLE_ALPHA][index];
+    }
+    return this->Get(index).AlphaAt(now);
+}
+
+void ParticleStore::Fade(float rate)
+{
+    unsigned int first[2], count[2];
+    unsigned int spans = this->LiveSpans(first, count);
+    for (unsigned int s = 0; s < spans; s++) {
+        FadeKernel(this->attributes[PARTICLE_ALPHA] + first[s], count[s], rate);
+    }
+}
+
+void ParticleStore::ShiftSpawnTimes(float shift)
+{
+    // slots outside the window are never read again before being overwritten
+    unsigned int first[2], count[2];
+    unsigned int spans = this->LiveSpans(first, count);
+    for (unsigned int s = 0; s < spans; s++) {
+        ShiftKernel(this->attributes[PARTICLE_SPAWN_TIME] + first[s], count[s], shift);
+    }
+}
+
+unsigned int ParticleStore::CountAlive(FadeMode mode, float now) const
+{
+    unsigned int first[2], count[2];
+    unsigned int spans = this->LiveSpans(first, count);
+    size_t alive = 0;
+    for (unsigned int s = 0; s < spans; s++) {
+        alive += CountAliveKernel(
+            this->attributes[PARTICLE_ALPHA] + first[s], this->attributes[PARTICLE_SPAWN_TIME] + first[s],
+            this->attributes[PARTICLE_LIFETIME] + first[s], count[s], mode == FADE_TIME, now);
+    }
+    return static_cast<unsigned int>(alive);
+}
+
+bool ParticleStore::Bounds(FadeMode mode, float now, float bounds[4]) const
+{
+    unsigned int first[2], count[2];
+    unsigned int spans = this->LiveSpans(first, count);
+    bool any = false;
+    for (unsigned int s = 0; s < spans; s++) {
+        float span[4];
+        if (!BoundsKernel(
+                this->attributes[PARTICLE_X] + first[s], this->attributes[PARTICLE_Y] + first[s],
+                this->attributes[PARTICLE_ALPHA] + first[s], this->attributes[PARTICLE_SPAWN_TIME] + first[s],
+                this->attributes[PARTICLE_LIFETIME] + first[s], count[s], mode == FADE_TIME, now, span)) {
+            continue;
+        }
+        if (!any) {
+            for (int i = 0; i < 4; i++) {
+                bounds[i] = span[i];
+            }
+            any = true;
+            continue;
+        }
+        if (span[0] < bounds[0]) bounds[0] = span[0];
+        if (span[1] < bounds[1]) bounds[1] = span[1];
+        if (span[2] > bounds[2]) bounds[2] = span[2];
+        if (span[3] > bounds[3]) bounds[3] = span[3];
+    }
+    return any;
+}
+
+void ParticleStore::CopyFrom(const ParticleStore& other)
+{
+    if (this->capacity != other.capacity) {
+        this->Resize(other.capacity);
+    }
+    this->head = other.head;
+    this->tail = other.tail;
+    this->live = other.live;
+    unsigned int first[2], count[2];
+    unsigned int spans = other.LiveSpans(first, count);
+    for (unsigned int s = 0; s < spans; s++) {
+        for (int i = 0; i < PARTICLE_ATTRIBUTE_COUNT; i++) {
+            std::memcpy(this->attributes[i] + first[s], other.attributes[i] + first[s], count[s] * sizeof(float));
+        }
+    }
+}
+
+void ParticleStore::Swap(ParticleStore& other)
+{
+    for (int i = 0; i < PARTICLE_ATTRIBUTE_COUNT; i++) {
+        std::swap(this->attributes[i], other.attributes[i]);
+    }
+    std::swap(this->capacity, other.capacity);
+    std::swap(this->stride, other.stride);
+    std::swap(this->head, other.head);
+    std::swap(this->tail, other.tail);
+    std::swap(this->live, other.live);
+}
+
+bool ParticleStore::isAlive(unsigned int index, FadeMode mode, float now) const
+{
+    // same test as the kernels
+    if (mode == FADE_TIME) {
+        return now - this->attributes[PARTICLE_SPAWN_TIME][index] < this->attributes[PARTICLE_LIFETIME][index];
+    }
+    return this->attributes[PARTICLE_ALPHA][index] > 0.0f;
+}
+
+void ParticleStore::release()
+{
+    for (int i = 0; i < PARTICLE_ATTRIBUTE_COUNT; i++) {
+        if (this->attributes[i] != nullptr) {
+            ::operator delete[](this->attributes[i], std::align_val_t(Alignment));
+            this->attributes[i] = nullptr;
+        }
+    }
+    this->capacity = 0;
+    this->stride = 0;
+    this->head = 0;
+    this->tail = 0;
+    this->live = 0;
+}
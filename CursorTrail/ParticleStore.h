@@ -0,0 +1,88 @@
+#ifndef PARTICLE_STORE_H
+#define PARTICLE_STORE_H
+
+#include "TrailPart.h"
+#include "Config.h"
+
+// Attributes stored per particle, one array each
+enum ParticleAttribute {
+    PARTICLE_X,
+    PARTICLE_Y,
+    PARTICLE_ALPHA,         // opacity (TrailPart::time)
+    PARTICLE_SPAWN_TIME,
+    PARTICLE_LIFETIME,
+    PARTICLE_ATTRIBUTE_COUNT
+};
+
+// Circular particle buffer stored as a structure of arrays. Every
+// attribute lives in its own aligned array so the per-frame passes
+// (fading, liveness counting, bounding boxes) run as SIMD kernels over
+// contiguous floats. New attributes only need a ParticleAttribute entry.
+// Particles are written in order at Head(), overwriting the oldest slot.
+// All particles fade the same way, so they die in the order they were
+// written and the live ones always form one window [Tail(), Head()) that
+// may wrap around the end of the arrays. The per-frame passes only touch
+// that window.
+class ParticleStore
+{
+public:
+    // alignment of every attribute array in bytes
+    static const unsigned int Alignment = 32;
+    // capacity is padded to a multiple of this with dead slots
+    static const unsigned int Padding = 8;
+
+    ParticleStore();
+    ~ParticleStore();
+    // allocates storage for capacity particles, all dead
+    void         Resize(unsigned int capacity);
+    unsigned int Capacity() const { return this->capacity; }
+    // next slot to be written
+    unsigned int Head() const { return this->head; }
+    // oldest slot of the live window
+    unsigned int Tail() const { return this->tail; }
+    // number of slots in the live window
+    unsigned int LiveCount() const { return this->live; }
+    // splits the live window into at most two contiguous slot ranges,
+    // oldest first; returns the number of ranges
+    unsigned int LiveSpans(unsigned int first[2], unsigned int count[2]) const;
+    // drops particles that have faded out from the old end of the window
+    void         Expire(FadeMode mode, float now);
+    // writes a particle at Head() and advances it
+    void         Add(const TrailPart& part);
+    // advances Head() over count slots at once and returns the slot
+    // ranges to fill through Attribute(), at most two, oldest first.
+    // count is clamped to the capacity; like Add() it overwrites the
+    // oldest particles of a full ring
+    unsigned int Append(unsigned int count, unsigned int first[2], unsigned int spanCount[2]);
+    TrailPart    Get(unsigned int index) const;
+    float*       Attribute(ParticleAttribute attribute) { return this->attributes[attribute]; }
+    const float* Attribute(ParticleAttribute attribute) const { return this->attributes[attribute]; }
+    // opacity of a particle at the given Clock time
+    float        AlphaAt(unsigned int index, FadeMode mode, float now) const;
+    // per-frame fade: subtracts rate from every live opacity
+    void         Fade(float rate);
+    // moves every live spawn time back by shift seconds (Clock rebase)
+    void         ShiftSpawnTimes(float shift);
+    // number of live particles in the window
+    unsigned int CountAlive(FadeMode mode, float now) const;
+    // bounding box {minX, minY, maxX, maxY} of the live particle centers, false if none is alive
+    bool         Bounds(FadeMode mode, float now, float bounds[4]) const;
+    // copies the live window of other into the same slots, resizing to its
+    // capacity first when it differs; slots outside the window are not copied
+    void         CopyFrom(const ParticleStore& other);
+    // exchanges the contents of two stores without copying
+    void         Swap(ParticleStore& other);
+    ParticleStore(const ParticleStore&) = delete;
+    ParticleStore& operator=(const ParticleStore&) = delete;
+private:
+    float*       attributes[PARTICLE_ATTRIBUTE_COUNT];
+    unsigned int capacity;
+    unsigned int stride;    // allocated length of every array, capacity rounded up to Padding
+    unsigned int head;
+    unsigned int tail;
+    unsigned int live;
+    bool isAlive(unsigned int index, FadeMode mode, float now) const;
+    void release();
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "Presenter.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+// Native access from glfw3native.h, declared with opaque handle types so
+// the X11 and EGL headers stay out of the build
+extern "C" {
+    void*         glfwGetEGLDisplay(void);
+    void*         glfwGetEGLSurface(GLFWwindow* window);
+    void*         glfwGetX11Display(void);
+    unsigned long glfwGetGLXWindow(GLFWwindow* window);
+}
+#endif
+
+namespace
+{
+    // tokens from eglext.h and glxext.h
+    const int EGL_EXTENSIONS_TOKEN = 0x3055;
+    const int EGL_BUFFER_AGE_EXT = 0x313D;
+    const int GLX_EXTENSIONS_TOKEN = 0x3;
+    const int GLX_BACK_BUFFER_AGE_EXT = 0x20F4;
+
+    bool HasExtension(const char* extensions, const char* name)
+    {
+        if (extensions == nullptr) {
+            return false;
+        }
+        size_t length = std::strlen(name);
+        for (const char* p = std::strstr(extensions, name); p != nullptr; p = std::strstr(p + length, name)) {
+            bool starts = p == extensions || p[-1] == ' ';
+            bool ends = p[length] == '\0' || p[length] == ' ';
+            if (starts && ends) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+Presenter::Presenter(GLFWwindow* window)
+    : window(window), eglDisplay(nullptr), eglSurface(nullptr), eglQuerySurface(nullptr), eglSwapWithDamage(nullptr),
+      glxDisplay(nullptr), glxDrawable(0), glxQueryDrawable(nullptr)
+{
+    int api = glfwGetWindowAttrib(window, GLFW_CONTEXT_CREATION_API);
+    if (api == GLFW_EGL_CONTEXT_API) {
+        this->lookupEgl();
+    }
+    else {
+        // native contexts are GLX on X11 and EGL on Wayland
+        this->lookupGlx();
+        if (this->glxQueryDrawable == nullptr) {
+            this->lookupEgl();
+        }
+    }
+
+    std::cout << "Presenter: buffer age " << (this->eglQuerySurface || this->glxQueryDrawable ? "supported" : "unsupported")
+              << ", swap with damage " << (this->eglSwapWithDamage ? "supported" : "unsupported") << std::endl;
+}
+
+int Presenter::BufferAge()
+{
+    if (this->eglQuerySurface != nullptr) {
+        int age = 0;
+        if (this->eglQuerySurface(this->eglDisplay, this->eglSurface, EGL_BUFFER_AGE_EXT, &age)) {
+            return age;
+        }
+        return 0;
+    }
+    if (this->glxQueryDrawable != nullptr) {
+        unsigned int age = 0;
+        this->glxQueryDrawable(this->glxDisplay, this->glxDrawable, GLX_BACK_BUFFER_AGE_EXT, &age);
+        return static_cast<int>(age);
+    }
+    return 0;
+}
+
+void Presenter::Present(const DamageRect& damage, int surfaceHeight)
+{
+    // an empty rectangle list would mean the whole surface
+    if (this->eglSwapWithDamage != nullptr && !damage.Empty()) {
+        // EGL rectangles have their origin at the bottom-left
+        int rect[4] = { damage.x, surfaceHeight - damage.y - damage.height, damage.width, damage.height };
+        this->eglSwapWithDamage(this->eglDisplay, this->eglSurface, rect, 1);
+        return;
+    }
+    glfwSwapBuffers(this->window);
+}
+
+void Presenter::lookupEgl()
+{
+#ifdef __linux__
+    this->eglDisplay = glfwGetEGLDisplay();
+    this->eglSurface = glfwGetEGLSurface(this->window);
+    if (this->eglDisplay == nullptr || this->eglSurface == nullptr) {
+        return;
+    }
+
+    // EGL functions resolve through eglGetProcAddress behind glfwGetProcAddress
+    typedef const char* (*EglQueryStringProc)(void* display, int name);
+    EglQueryStringProc queryString = reinterpret_cast<EglQueryStringProc>(glfwGetProcAddress("eglQueryString"));
+    if (queryString == nullptr) {
+        return;
+    }
+    const char* extensions = queryString(this->eglDisplay, EGL_EXTENSIONS_TOKEN);
+
+    if (HasExtension(extensions, "EGL_EXT_buffer_age")) {
+        this->eglQuerySurface = reinterpret_cast<EglQuerySurfaceProc>(glfwGetProcAddress("eglQuerySurface"));
+    }
+    if (HasExtension(extensions, "EGL_KHR_swap_buffers_with_damage")) {
+        this->eglSwapWithDamage = reinterpret_cast<EglSwapWithDamageProc>(glfwGetProcAddress("eglSwapBuffersWithDamageKHR"));
+    }
+    else if (HasExtension(extensions, "EGL_EXT_swap_buffers_with_damage")) {
+        this->eglSwapWithDamage = reinterpret_cast<EglSwapWithDamageProc>(glfwGetProcAddress("eglSwapBuffersWithDamageEXT"));
+    }
+#endif
+}
+
+void Presenter::lookupGlx()
+{
+#ifdef __linux__
+    this->glxDisplay = glfwGetX11Display();
+    this->glxDrawable = glfwGetGLXWindow(this->window);
+    if (this->glxDisplay == nullptr || this->glxDrawable == 0) {
+        return;
+    }
+
+    // GLX functions resolve through glXGetProcAddress behind glfwGetProcAddress;
+    // the extension string of the default screen is used
+    typedef const char* (*GlxQueryExtensionsStringProc)(void* display, int screen);
+    GlxQueryExtensionsStringProc queryExtensions =
+        reinterpret_cast<GlxQueryExtensionsStringProc>(glfwGetProcAddress("glXQueryExtensionsString"));
+    if (queryExtensions == nullptr) {
+        return;
+    }
+    if (HasExtension(queryExtensions(this->glxDisplay, 0), "GLX_EXT_buffer_age")) {
+        this->glxQueryDrawable = reinterpret_cast<GlxQueryDrawableProc>(glfwGetProcAddress("glXQueryDrawable"));
+    }
+#endif
+}
@@ -0,0 +1,40 @@
+#ifndef PRESENTER_H
+#define PRESENTER_H
+
+#include <GLFW/glfw3.h>
+
+#include "DamageTracker.h"
+
+// Presents frames of a GLFW window and tells the compositor which part
+// changed. Where the platform supports it the back buffer age is queried
+// (EGL_EXT_buffer_age, GLX_EXT_buffer_age) so renderers can repaint only
+// the damage since that frame, and the damage is passed on with the swap
+// (EGL_KHR/EXT_swap_buffers_with_damage). Otherwise BufferAge() reports
+// unknown content and Present() falls back to glfwSwapBuffers.
+class Presenter
+{
+public:
+    // looks up the extensions of the window's context, which must be current
+    Presenter(GLFWwindow* window);
+    // age of the back buffer in frames, 0 if unknown
+    int  BufferAge();
+    // swaps buffers, damage is in surface pixels with the origin at the top-left
+    void Present(const DamageRect& damage, int surfaceHeight);
+private:
+    typedef unsigned int (*EglQuerySurfaceProc)(void* display, void* surface, int attribute, int* value);
+    typedef unsigned int (*EglSwapWithDamageProc)(void* display, void* surface, const int* rects, int count);
+    typedef void (*GlxQueryDrawableProc)(void* display, unsigned long drawable, int attribute, unsigned int* value);
+
+    GLFWwindow*           window;
+    void*                 eglDisplay;
+    void*                 eglSurface;
+    EglQuerySurfaceProc   eglQuerySurface;
+    EglSwapWithDamageProc eglSwapWithDamage;
+    void*                 glxDisplay;
+    unsigned long         glxDrawable;
+    GlxQueryDrawableProc  glxQueryDrawable;
+    void lookupEgl();
+    void lookupGlx();
+};
+
+#endif
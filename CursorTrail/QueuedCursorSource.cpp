@@ -0,0 +1,114 @@
+#include "QueuedCursorSource.h"
+#include "Clock.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+
+QueuedCursorSource::QueuedCursorSource(size_t capacity)
+    : queue(capacity), dropped(0), taken(0), armed(false)
+{
+    this->wakePipe[0] = -1;
+    this->wakePipe[1] = -1;
+    // neither side may block on the pipe: a full pipe already wakes the
+    // consumer, an empty one is drained
+    if (pipe(this->wakePipe) == 0) {
+        for (int fd : this->wakePipe) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+    }
+}
+
+QueuedCursorSource::~QueuedCursorSource()
+{
+    for (int fd : this->wakePipe) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool QueuedCursorSource::Queue(const CursorSample& sample)
+{
+    if (!this->queue.Push(sample)) {
+        this->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    // pairs with the fence in ArmWake(): either the consumer sees the
+    // sample before it sleeps or the producer sees it armed
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->armed.load(std::memory_order_relaxed) && this->armed.exchange(false)) {
+        this->wake();
+    }
+    return true;
+}
+
+bool QueuedCursorSource::Next(CursorSample& sample)
+{
+    if (this->queue.Pop(sample)) {
+        this->last = sample;
+        return true;
+    }
+    // the cursor rests where it was last seen
+    this->last.time = Clock::Seconds();
+    sample = this->last;
+    return true;
+}
+
+bool QueuedCursorSource::Pending() const
+{
+    return !this->queue.Empty();
+}
+
+unsigned long long QueuedCursorSource::TakeDropped()
+{
+    unsigned long long dropped = this->dropped.load(std::memory_order_relaxed);
+    unsigned long long lost = dropped - this->taken;
+    this->taken = dropped;
+    return lost;
+}
+
+bool QueuedCursorSource::ArmWake()
+{
+    this->armed.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!this->queue.Empty()) {
+        this->armed.store(false, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void QueuedCursorSource::DisarmWake()
+{
+    this->armed.store(false, std::memory_order_relaxed);
+    char drain[64];
+    while (read(this->wakePipe[0], drain, sizeof(drain)) > 0) {
+    }
+}
+
+bool QueuedCursorSource::Wait(int timeoutMs)
+{
+    if (this->ArmWake()) {
+        pollfd fd = {};
+        fd.fd = this->wakePipe[0];
+        fd.events = POLLIN;
+        poll(&fd, 1, timeoutMs);
+        this->DisarmWake();
+    }
+    return true;
+}
+
+void QueuedCursorSource::Interrupt()
+{
+    this->wake();
+}
+
+void QueuedCursorSource::wake()
+{
+    char wake = 0;
+    if (write(this->wakePipe[1], &wake, 1) < 0) {
+        // a full pipe wakes the consumer all the same
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef QUEUED_CURSOR_SOURCE_H
+#define QUEUED_CURSOR_SOURCE_H
+
+#include <atomic>
+#include <cstddef>
+#include "CursorSource.h"
+#include "SpscQueue.h"
+
+// Cursor samples taken on a producer thread and handed to the simulation
+// through a bounded SPSC queue. The producer never waits: a sample that
+// finds the queue full is dropped and counted, and the consumer learns
+// about it through TakeDropped(). The consumer can sleep until the next
+// sample is queued, with Wait() or by polling WakeFd() between ArmWake()
+// and DisarmWake(); the producer only touches the pipe behind WakeFd()
+// while a consumer is waiting. POSIX only.
+class QueuedCursorSource : public CursorSource
+{
+public:
+    // about four seconds of motion at a 250 Hz report rate, 128 ms at 8 kHz
+    static const size_t DefaultCapacity = 1024;
+
+    explicit QueuedCursorSource(size_t capacity = DefaultCapacity);
+    ~QueuedCursorSource();
+
+    // producer side: queues a sample, false when the queue was full and it was dropped
+    bool Queue(const CursorSample& sample);
+    // samples dropped since the source was created
+    unsigned long long Dropped() const { return this->dropped.load(std::memory_order_relaxed); }
+
+    // consumer side: the oldest queued sample, or the last position at the
+    // current time when nothing was queued
+    bool Next(CursorSample& sample) override;
+    bool Pending() const override;
+    unsigned long long TakeDropped() override;
+    bool Wait(int timeoutMs) override;
+    void Interrupt() override;
+    // readable once a sample is queued after a successful ArmWake()
+    int  WakeFd() const { return this->wakePipe[0]; }
+    // asks the producer to signal WakeFd() with its next sample; false
+    // when one is queued already and there is nothing to wait for
+    bool ArmWake();
+    // takes the request back and empties the pipe
+    void DisarmWake();
+    QueuedCursorSource(const QueuedCursorSource&) = delete;
+    QueuedCursorSource& operator=(const QueuedCursorSource&) = delete;
+private:
+    SpscQueue<CursorSample>         queue;
+    CursorSample                    last;       // last sample returned by Next
+    std::atomic<unsigned long long> dropped;    // samples lost to a full queue
+    unsigned long long              taken;      // of those, reported by TakeDropped
+    std::atomic<bool>               armed;      // a consumer waits on the pipe
+    int                             wakePipe[2];
+    void wake();
+};
+
+#endif
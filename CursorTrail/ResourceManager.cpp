@@ -7,40 +7,61 @@
 #include "stb/stb_image.h"
 
 // Instantiate static variables
-std::map<std::string, Texture2D>    ResourceManager::Textures;
-std::map<std::string, Shader>       ResourceManager::Shaders;
+std::vector<Texture2D>                          ResourceManager::Textures;
+std::vector<Shader>                             ResourceManager::Shaders;
+std::unordered_map<std::string, unsigned int>   ResourceManager::textureNames;
+std::unordered_map<std::string, unsigned int>   ResourceManager::shaderNames;
 
 
-Shader ResourceManager::LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name)
+ShaderHandle ResourceManager::LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, const std::string& name)
 {
-    Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
-    return Shaders[name];
+    Shader shader = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
+    auto found = shaderNames.find(name);
+    if (found != shaderNames.end())
+    {
+        Shaders[found->second] = std::move(shader);
+        return ShaderHandle(found->second);
+    }
+    unsigned int index = static_cast<unsigned int>(Shaders.size());
+    Shaders.push_back(std::move(shader));
+    shaderNames[name] = index;
+    return ShaderHandle(index);
 }
 
-Shader ResourceManager::GetShader(std::string name)
+ShaderHandle ResourceManager::FindShader(const std::string& name)
 {
-    return Shaders[name];
+    auto found = shaderNames.find(name);
+    return found != shaderNames.end() ? ShaderHandle(found->second) : ShaderHandle();
 }
 
-Texture2D ResourceManager::LoadTexture(const char* file, bool alpha, std::string name)
+TextureHandle ResourceManager::LoadTexture(const char* file, bool alpha, const std::string& name)
 {
-    Textures[name] = loadTextureFromFile(file, alpha);
-    return Textures[name];
+    Texture2D texture = loadTextureFromFile(file, alpha);
+    auto found = textureNames.find(name);
+    if (found != textureNames.end())
+    {
+        Textures[found->second] = std::move(texture);
+        return TextureHandle(found->second);
+    }
+    unsigned int index = static_cast<unsigned int>(Textures.size());
+    Textures.push_back(std::move(texture));
+    textureNames[name] = index;
+    return TextureHandle(index);
 }
 
-Texture2D ResourceManager::GetTexture(std::string name)
+TextureHandle ResourceManager::FindTexture(const std::string& name)
 {
-    return Textures[name];
+    auto found = textureNames.find(name);
+    return found != textureNames.end() ? TextureHandle(found->second) : TextureHandle();
 }
 
 void ResourceManager::Clear()
 {
-    // (properly) delete all shaders	
-    for (auto iter : Shaders)
-        glDeleteProgram(iter.second.ID);
-    // (properly) delete all textures
-    for (auto iter : Textures)
-        glDeleteTextures(1, &iter.second.ID);
+    // (properly) delete all shaders and textures, their destructors release the GL objects
+    Shaders.clear();
+    shaderNames.clear();
+    Textures.clear();
+    textureNames.clear();
 }
 
 Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile)
@@ -99,6 +120,16 @@ Texture2D ResourceManager::loadTextureFromFile(const char* file, bool alpha)
     // load image
     int width, height, nrChannels;
     unsigned char* data = stbi_load(file, &width, &height, &nrChannels, 0);
+    if (data == nullptr)
+    {
+        // a missing image leaves a single white texel, the trail stays visible
+        std::cout << "ERROR::TEXTURE: Failed to load " << file << ": " << stbi_failure_reason() << std::endl;
+        unsigned char white[4] = { 255, 255, 255, 255 };
+        texture.Internal_Format = GL_RGBA;
+        texture.Image_Format = GL_RGBA;
+        texture.Generate(1, 1, white);
+        return texture;
+    }
     // now generate texture
     texture.Generate(width, height, data);
     // and finally free image data
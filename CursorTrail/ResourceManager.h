@@ -1,8 +1,9 @@
 #ifndef RESOURCE_MANAGER_H
 #define RESOURCE_MANAGER_H
 
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <glad/glad.h>
 
@@ -10,34 +11,58 @@
 #include "Shader.h"
 
 
+// Typed index of a resource stored by the ResourceManager. Handles are
+// resolved once at load time; lookups through them are plain array
+// accesses, cheap enough for every frame.
+template <typename T>
+struct ResourceHandle
+{
+    static const unsigned int Invalid = ~0u;
+    unsigned int Index;
+    ResourceHandle() : Index(Invalid) { }
+    explicit ResourceHandle(unsigned int index) : Index(index) { }
+    bool Valid() const { return this->Index != Invalid; }
+};
+
+typedef ResourceHandle<Shader>    ShaderHandle;
+typedef ResourceHandle<Texture2D> TextureHandle;
+
 // A static singleton ResourceManager class that hosts several
 // functions to load Textures and Shaders. Each loaded texture
-// and/or shader is also stored for future reference by string
-// handles. All functions and resources are static and no 
+// and/or shader is stored in a flat array and referenced by a
+// typed handle; names are only used to look handles up when
+// loading. All functions and resources are static and no 
 // public constructor is defined.
 class ResourceManager
 {
 public:
-    // resource storage
-    static std::map<std::string, Shader>    Shaders;
-    static std::map<std::string, Texture2D> Textures;
-    // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader
-    static Shader    LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name);
-    // retrieves a stored sader
-    static Shader    GetShader(std::string name);
-    // loads (and generates) a texture from file
-    static Texture2D LoadTexture(const char* file, bool alpha, std::string name);
+    // resource storage, indexed by handle
+    static std::vector<Shader>    Shaders;
+    static std::vector<Texture2D> Textures;
+    // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader. Loading an existing name replaces that shader and keeps its handle
+    static ShaderHandle  LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, const std::string& name);
+    // retrieves a stored shader
+    static Shader&       GetShader(ShaderHandle handle) { return Shaders[handle.Index]; }
+    // handle of a shader by name, invalid if none was loaded under it
+    static ShaderHandle  FindShader(const std::string& name);
+    // loads (and generates) a texture from file, replacing an existing one of the same name
+    static TextureHandle LoadTexture(const char* file, bool alpha, const std::string& name);
     // retrieves a stored texture
-    static Texture2D GetTexture(std::string name);
-    // properly de-allocates all loaded resources
-    static void      Clear();
+    static Texture2D&    GetTexture(TextureHandle handle) { return Textures[handle.Index]; }
+    // handle of a texture by name, invalid if none was loaded under it
+    static TextureHandle FindTexture(const std::string& name);
+    // properly de-allocates all loaded resources; all handles become invalid
+    static void          Clear();
 private:
     // private constructor, that is we do not want any actual resource manager objects. Its members and functions should be publicly available (static).
     ResourceManager() { }
+    // handle indices by name
+    static std::unordered_map<std::string, unsigned int> shaderNames;
+    static std::unordered_map<std::string, unsigned int> textureNames;
     // loads and generates a shader from file
     static Shader    loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile = nullptr);
     // loads a single texture from file
     static Texture2D loadTextureFromFile(const char* file, bool alpha);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,10 +1,35 @@
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Stats.h"
 
 #include <iostream>
 
+Shader::~Shader()
+{
+    this->release();
+}
+
+Shader::Shader(Shader&& other) noexcept
+    : ID(other.ID), uniforms(std::move(other.uniforms))
+{
+    other.ID = 0;
+}
+
+Shader& Shader::operator=(Shader&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->release();
+        this->ID = other.ID;
+        this->uniforms = std::move(other.uniforms);
+        other.ID = 0;
+    }
+    return *this;
+}
+
 Shader& Shader::Use()
 {
-    glUseProgram(this->ID);
+    g_glState.UseProgram(this->ID);
     return *this;
 }
 
@@ -30,13 +55,16 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource, const
         checkCompileErrors(gShader, "GEOMETRY");
     }
     // shader program
+    this->release();
     this->ID = glCreateProgram();
+    g_stats.glObjects++;
     glAttachShader(this->ID, sVertex);
     glAttachShader(this->ID, sFragment);
     if (geometrySource != nullptr)
         glAttachShader(this->ID, gShader);
     glLinkProgram(this->ID);
     checkCompileErrors(this->ID, "PROGRAM");
+    this->cacheUniforms();
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(sVertex);
     glDeleteShader(sFragment);
@@ -48,57 +76,123 @@ void Shader::SetFloat(const char* name, float value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform1f(glGetUniformLocation(this->ID, name), value);
+    glUniform1f(this->location(name), value);
 }
 void Shader::SetInteger(const char* name, int value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform1i(glGetUniformLocation(this->ID, name), value);
+    glUniform1i(this->location(name), value);
 }
 void Shader::SetVector2f(const char* name, float x, float y, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), x, y);
+    glUniform2f(this->location(name), x, y);
 }
 void Shader::SetVector2f(const char* name, const glm::vec2& value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), value.x, value.y);
+    glUniform2f(this->location(name), value.x, value.y);
 }
 void Shader::SetVector3f(const char* name, float x, float y, float z, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+    glUniform3f(this->location(name), x, y, z);
 }
 void Shader::SetVector3f(const char* name, const glm::vec3& value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+    glUniform3f(this->location(name), value.x, value.y, value.z);
 }
 void Shader::SetVector4f(const char* name, float x, float y, float z, float w, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), x, y, z, w);
+    glUniform4f(this->location(name), x, y, z, w);
 }
 void Shader::SetVector4f(const char* name, const glm::vec4& value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+    glUniform4f(this->location(name), value.x, value.y, value.z, value.w);
 }
 void Shader::SetMatrix4(const char* name, const glm::mat4& matrix, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, false, glm::value_ptr(matrix));
+    glUniformMatrix4fv(this->location(name), 1, false, glm::value_ptr(matrix));
 }
 
+void Shader::Set(Uniform<float> uniform, float value)
+{
+    glUniform1f(uniform.Location, value);
+}
+void Shader::Set(Uniform<int> uniform, int value)
+{
+    glUniform1i(uniform.Location, value);
+}
+void Shader::Set(Uniform<bool> uniform, bool value)
+{
+    glUniform1i(uniform.Location, value ? 1 : 0);
+}
+void Shader::Set(Uniform<glm::vec2> uniform, const glm::vec2& value)
+{
+    glUniform2f(uniform.Location, value.x, value.y);
+}
+void Shader::Set(Uniform<glm::vec3> uniform, const glm::vec3& value)
+{
+    glUniform3f(uniform.Location, value.x, value.y, value.z);
+}
+void Shader::Set(Uniform<glm::vec4> uniform, const glm::vec4& value)
+{
+    glUniform4f(uniform.Location, value.x, value.y, value.z, value.w);
+}
+void Shader::Set(Uniform<glm::mat4> uniform, const glm::mat4& value)
+{
+    glUniformMatrix4fv(uniform.Location, 1, false, glm::value_ptr(value));
+}
+
+int Shader::location(const char* name) const
+{
+    std::map<std::string, int>::const_iterator it = this->uniforms.find(name);
+    return it != this->uniforms.end() ? it->second : -1;
+}
+
+void Shader::cacheUniforms()
+{
+    this->uniforms.clear();
+    int count = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &count);
+    for (int i = 0; i < count; i++)
+    {
+        char name[256];
+        int length = 0, size = 0;
+        unsigned int type = 0;
+        glGetActiveUniform(this->ID, i, sizeof(name), &length, &size, &type, name);
+        // arrays are reported as "name[0]", also make them reachable by their base name
+        std::string uniform(name, length);
+        int location = glGetUniformLocation(this->ID, uniform.c_str());
+        this->uniforms[uniform] = location;
+        size_t bracket = uniform.find('[');
+        if (bracket != std::string::npos)
+            this->uniforms[uniform.substr(0, bracket)] = location;
+    }
+}
+
+void Shader::release()
+{
+    if (this->ID == 0)
+        return;
+    g_glState.ForgetProgram(this->ID);
+    glDeleteProgram(this->ID);
+    g_stats.glObjects--;
+    this->ID = 0;
+    this->uniforms.clear();
+}
 
 void Shader::checkCompileErrors(unsigned int object, std::string type)
 {
@@ -1,6 +1,7 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <map>
 #include <string>
 
 #include <glad/glad.h>
@@ -8,21 +9,51 @@
 #include <glm/gtc/type_ptr.hpp>
 
 
+// Location of a uniform resolved when its program was linked, typed by
+// the value it takes. Invalid (-1) handles are ignored by GL.
+template <typename T>
+struct Uniform
+{
+    int Location;
+    Uniform() : Location(-1) { }
+    explicit Uniform(int location) : Location(location) { }
+    bool Valid() const { return this->Location >= 0; }
+};
+
 // General purpsoe shader object. Compiles from file, generates
 // compile/link-time error messages and hosts several utility 
-// functions for easy management.
+// functions for easy management. Owns its program: it is created by
+// Compile(), deleted with the object, and can only be moved.
 class Shader
 {
 public:
     // state
     unsigned int ID;
-    // constructor
-    Shader() { }
+    // constructor (no GL object yet)
+    Shader() : ID(0) { }
+    // destructor (deletes the program)
+    ~Shader();
+    // move-only
+    Shader(Shader&& other) noexcept;
+    Shader& operator=(Shader&& other) noexcept;
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
     // sets the current shader as active
     Shader& Use();
     // compiles the shader from given source code
     void    Compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource = nullptr); // note: geometry source code is optional 
-    // utility functions
+    // looks up a uniform location cached at link time
+    template <typename T>
+    Uniform<T> GetUniform(const char* name) const { return Uniform<T>(this->location(name)); }
+    // typed setters for cached uniforms, the shader must be in use
+    void    Set(Uniform<float> uniform, float value);
+    void    Set(Uniform<int> uniform, int value);
+    void    Set(Uniform<bool> uniform, bool value);
+    void    Set(Uniform<glm::vec2> uniform, const glm::vec2& value);
+    void    Set(Uniform<glm::vec3> uniform, const glm::vec3& value);
+    void    Set(Uniform<glm::vec4> uniform, const glm::vec4& value);
+    void    Set(Uniform<glm::mat4> uniform, const glm::mat4& value);
+    // utility functions (by name, looked up in the cache)
     void    SetFloat(const char* name, float value, bool useShader = false);
     void    SetInteger(const char* name, int value, bool useShader = false);
     void    SetVector2f(const char* name, float x, float y, bool useShader = false);
@@ -33,6 +64,14 @@ public:
     void    SetVector4f(const char* name, const glm::vec4& value, bool useShader = false);
     void    SetMatrix4(const char* name, const glm::mat4& matrix, bool useShader = false);
 private:
+    // uniform locations by name, filled after linking
+    std::map<std::string, int> uniforms;
+    // cached location of a uniform, -1 if the program has no such active uniform
+    int     location(const char* name) const;
+    // queries the locations of all active uniforms
+    void    cacheUniforms();
+    // deletes the program, if any
+    void    release();
     // checks if compilation or linking failed and if so, print the error logs
     void    checkCompileErrors(unsigned int object, std::string type);
 };
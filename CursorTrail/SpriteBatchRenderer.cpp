@@ -0,0 +1,129 @@
+#include "SpriteBatchRenderer.h"
+#include "Stats.h"
+#include "GLStateCache.h"
+
+#include <cstddef>
+#include <cstring>
+
+
+SpriteBatchRenderer::SpriteBatchRenderer(ShaderHandle shader, StreamBuffer* stream)
+    : shader(shader), quadVAO(0), quadVBO(0), stream(stream)
+{
+    Shader& program = ResourceManager::GetShader(this->shader);
+    this->gpuFadeUniform = program.GetUniform<bool>("gpuFade");
+    this->timeUniform = program.GetUniform<float>("time");
+    this->initRenderData();
+}
+
+SpriteBatchRenderer::~SpriteBatchRenderer()
+{
+    g_glState.ForgetVertexArray(this->quadVAO);
+    glDeleteVertexArrays(1, &this->quadVAO);
+    glDeleteBuffers(1, &this->quadVBO);
+    g_stats.glObjects -= 2;
+}
+
+void SpriteBatchRenderer::Begin()
+{
+    this->instances.clear();
+}
+
+void SpriteBatchRenderer::Add(glm::vec2 position, float size, float alpha, float spawnTime, float lifetime)
+{
+    SpriteInstance instance;
+    instance.position = position;
+    instance.size = size;
+    instance.alpha = alpha;
+    instance.spawnTime = spawnTime;
+    instance.lifetime = lifetime;
+    this->instances.push_back(instance);
+}
+
+void SpriteBatchRenderer::SetFade(bool gpuFade, float time)
+{
+    Shader& shader = ResourceManager::GetShader(this->shader);
+    shader.Use();
+    shader.Set(this->gpuFadeUniform, gpuFade);
+    shader.Set(this->timeUniform, time);
+}
+
+void SpriteBatchRenderer::Flush(Texture2D& texture)
+{
+    if (this->instances.empty()) {
+        return;
+    }
+
+    size_t bytes = this->instances.size() * sizeof(SpriteInstance);
+    size_t offset;
+    void* data = this->stream->Allocate(bytes, sizeof(SpriteInstance), offset);
+    std::memcpy(data, this->instances.data(), bytes);
+    this->stream->Commit(offset, bytes);
+
+    this->drawInstancesAt(texture, this->stream->GetBuffer(), offset, static_cast<unsigned int>(this->instances.size()));
+    this->instances.clear();
+}
+
+void SpriteBatchRenderer::DrawInstances(Texture2D& texture, unsigned int instanceBuffer, unsigned int first, unsigned int count)
+{
+    this->drawInstancesAt(texture, instanceBuffer, first * sizeof(SpriteInstance), count);
+}
+
+void SpriteBatchRenderer::drawInstancesAt(Texture2D& texture, unsigned int buffer, size_t offset, unsigned int count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    ResourceManager::GetShader(this->shader).Use();
+    g_glState.ActiveTexture(GL_TEXTURE0);
+    texture.Bind();
+
+    g_glState.BindVertexArray(this->quadVAO);
+    // point the per-instance attributes at the instance data
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    // per-instance <vec2 position, float size, float alpha>
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(offset + offsetof(SpriteInstance, position)));
+    // per-instance <float spawnTime, float lifetime>
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(offset + offsetof(SpriteInstance, spawnTime)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(count));
+
+    g_stats.frame.drawCalls++;
+    g_stats.frame.spritesDrawn += count;
+}
+
+void SpriteBatchRenderer::initRenderData()
+{
+    // configure VAO/VBO
+    float vertices[] = {
+        // pos      // tex
+        0.0f, 1.0f, 0.0f, 1.0f,
+        1.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f,
+
+        0.0f, 1.0f, 0.0f, 1.0f,
+        1.0f, 1.0f, 1.0f, 1.0f,
+        1.0f, 0.0f, 1.0f, 0.0f
+    };
+
+    glGenVertexArrays(1, &this->quadVAO);
+    glGenBuffers(1, &this->quadVBO);
+    g_stats.glObjects += 2;
+
+    g_glState.BindVertexArray(this->quadVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+
+    // per-instance attributes, their source buffer is set when drawing
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    g_glState.BindVertexArray(0);
+}
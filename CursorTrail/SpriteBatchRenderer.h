@@ -0,0 +1,59 @@
+#ifndef SPRITE_BATCH_RENDERER_H
+#define SPRITE_BATCH_RENDERER_H
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "ResourceManager.h"
+#include "StreamBuffer.h"
+
+
+// Per-instance data consumed by sprite_instanced.vs
+struct SpriteInstance
+{
+    glm::vec2 position;     // top-left corner in screen space
+    float     size;         // edge length of the square sprite
+    float     alpha;        // opacity multiplier (initial opacity when fading on the GPU)
+    float     spawnTime;    // Clock time the sprite was spawned at
+    float     lifetime;     // seconds until the sprite is fully faded
+};
+
+// Collects sprites that share a texture and draws all of them with a
+// single instanced draw call. The instance data is written to a
+// StreamBuffer once per flush instead of one uniform update per sprite.
+class SpriteBatchRenderer
+{
+public:
+    // Constructor (inits shaders/shapes), batches are uploaded through stream
+    SpriteBatchRenderer(ShaderHandle shader, StreamBuffer* stream);
+    // Destructor
+    ~SpriteBatchRenderer();
+    // Starts a new batch
+    void Begin();
+    // Queues a sprite for the current batch
+    void Add(glm::vec2 position, float size, float alpha = 1.0f, float spawnTime = 0.0f, float lifetime = 0.0f);
+    // Enables fading by spawnTime/lifetime in the vertex shader, evaluated at the given Clock time
+    void SetFade(bool gpuFade, float time);
+    // Uploads the queued sprites and draws them with the given texture
+    void Flush(Texture2D& texture);
+    // Draws count instances stored in an external SpriteInstance buffer, starting at instance first
+    void DrawInstances(Texture2D& texture, unsigned int instanceBuffer, unsigned int first, unsigned int count);
+private:
+    // Render state
+    ShaderHandle                shader;
+    unsigned int                quadVAO;
+    unsigned int                quadVBO;
+    StreamBuffer*               stream;
+    std::vector<SpriteInstance> instances;
+    // uniform locations, resolved once
+    Uniform<bool>               gpuFadeUniform;
+    Uniform<float>              timeUniform;
+    // Initializes and configures the quad's buffer and vertex attributes
+    void initRenderData();
+    // Draws count instances starting offset bytes into the given buffer
+    void drawInstancesAt(Texture2D& texture, unsigned int buffer, size_t offset, unsigned int count);
+};
+
+#endif
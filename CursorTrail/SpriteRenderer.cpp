@@ -1,21 +1,30 @@
 #include "SpriteRenderer.h"
+#include "Stats.h"
+#include "GLStateCache.h"
 
 
-SpriteRenderer::SpriteRenderer(Shader& shader)
+SpriteRenderer::SpriteRenderer(ShaderHandle shader)
+    : shader(shader), quadVAO(0), quadVBO(0)
 {
-    this->shader = shader;
+    Shader& program = ResourceManager::GetShader(this->shader);
+    this->modelUniform = program.GetUniform<glm::mat4>("model");
+    this->alphaUniform = program.GetUniform<float>("alpha");
     this->initRenderData();
 }
 
 SpriteRenderer::~SpriteRenderer()
 {
+    g_glState.ForgetVertexArray(this->quadVAO);
     glDeleteVertexArrays(1, &this->quadVAO);
+    glDeleteBuffers(1, &this->quadVBO);
+    g_stats.glObjects -= 2;
 }
 
 void SpriteRenderer::DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec2 size, float rotate, float alpha)
 {
     // prepare transformations
-    this->shader.Use();
+    Shader& shader = ResourceManager::GetShader(this->shader);
+    shader.Use();
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(position, 0.0f));  // first translate (transformations are: scale happens first, then rotation, and then final translation happens; reversed order)
 
@@ -25,23 +34,25 @@ void SpriteRenderer::DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec
 
     model = glm::scale(model, glm::vec3(size, 1.0f)); // last scale
 
-    this->shader.SetMatrix4("model", model);
+    shader.Set(this->modelUniform, model);
 
     // render textured quad
-    this->shader.SetFloat("alpha", alpha);
+    shader.Set(this->alphaUniform, alpha);
 
-    glActiveTexture(GL_TEXTURE0);
+    // bindings repeat from sprite to sprite, the state cache drops the repeats
+    g_glState.ActiveTexture(GL_TEXTURE0);
     texture.Bind();
 
-    glBindVertexArray(this->quadVAO);
+    g_glState.BindVertexArray(this->quadVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+
+    g_stats.frame.drawCalls++;
+    g_stats.frame.spritesDrawn++;
 }
 
 void SpriteRenderer::initRenderData()
 {
     // configure VAO/VBO
-    unsigned int VBO;
     float vertices[] = {
         // pos      // tex
         0.0f, 1.0f, 0.0f, 1.0f,
@@ -54,14 +65,15 @@ void SpriteRenderer::initRenderData()
     };
 
     glGenVertexArrays(1, &this->quadVAO);
-    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &this->quadVBO);
+    g_stats.glObjects += 2;
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    glBindVertexArray(this->quadVAO);
+    g_glState.BindVertexArray(this->quadVAO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    g_glState.BindVertexArray(0);
 }
\ No newline at end of file
@@ -5,23 +5,26 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "Texture2D.h"
-#include "Shader.h"
+#include "ResourceManager.h"
 
 
 class SpriteRenderer
 {
 public:
     // Constructor (inits shaders/shapes)
-    SpriteRenderer(Shader& shader);
+    SpriteRenderer(ShaderHandle shader);
     // Destructor
     ~SpriteRenderer();
     // Renders a defined quad textured with given sprite
     void DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, float alpha = 1.0f);
 private:
     // Render state
-    Shader       shader;
+    ShaderHandle shader;
     unsigned int quadVAO;
+    unsigned int quadVBO;
+    // uniform locations, resolved once
+    Uniform<glm::mat4> modelUniform;
+    Uniform<float>     alphaUniform;
     // Initializes and configures the quad's buffer and vertex attributes
     void initRenderData();
 };
@@ -0,0 +1,69 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue between exactly one producer thread and one
+// consumer thread. Each side only writes its own index, so pushing and
+// popping never block or take a lock. The capacity is rounded up to a
+// power of two; a full queue rejects new items instead of waiting.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity)
+        : head(0), tail(0)
+    {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        this->items.resize(size);
+        this->mask = size - 1;
+    }
+
+    // producer side, false when the queue is full and the item was dropped
+    bool Push(const T& item)
+    {
+        size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - this->head.load(std::memory_order_acquire) > this->mask) {
+            return false;
+        }
+        this->items[tail & this->mask] = item;
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, false when the queue is empty
+    bool Pop(T& item)
+    {
+        size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == this->tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = this->items[head & this->mask];
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side
+    bool Empty() const
+    {
+        return this->head.load(std::memory_order_relaxed) == this->tail.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const { return this->mask + 1; }
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+private:
+    std::vector<T> items;
+    size_t         mask;
+    // the indices only grow; they sit on separate cache lines so the two
+    // threads do not invalidate each other's line on every item
+    alignas(64) std::atomic<size_t> head;   // next item to pop, written by the consumer
+    alignas(64) std::atomic<size_t> tail;   // next slot to push, written by the producer
+};
+
+#endif
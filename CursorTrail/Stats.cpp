@@ -0,0 +1,103 @@
+#include "Stats.h"
+
+#include <iostream>
+
+// Global statistics instance
+RenderStats g_stats;
+
+void FrameCounters::Reset()
+{
+    drawCalls = 0;
+    uploads = 0;
+    bytesUploaded = 0;
+    spritesDrawn = 0;
+    streamWaits = 0;
+    stallMicroseconds = 0;
+    pixelsRepainted = 0;
+    stateCallsIssued = 0;
+    stateCallsSkipped = 0;
+    particlesSpawned = 0;
+    spawnsSuppressed = 0;
+    cursorSamples = 0;
+    cursorSamplesDropped = 0;
+    simulationSteps = 0;
+    handoffMicroseconds = 0;
+    xRequests = 0;
+    xRequestBytes = 0;
+    xRoundTrips = 0;
+}
+
+void FrameCounters::Add(const FrameCounters& other)
+{
+    drawCalls += other.drawCalls;
+    uploads += other.uploads;
+    bytesUploaded += other.bytesUploaded;
+    spritesDrawn += other.spritesDrawn;
+    streamWaits += other.streamWaits;
+    stallMicroseconds += other.stallMicroseconds;
+    pixelsRepainted += other.pixelsRepainted;
+    stateCallsIssued += other.stateCallsIssued;
+    stateCallsSkipped += other.stateCallsSkipped;
+    particlesSpawned += other.particlesSpawned;
+    spawnsSuppressed += other.spawnsSuppressed;
+    cursorSamples += other.cursorSamples;
+    cursorSamplesDropped += other.cursorSamplesDropped;
+    simulationSteps += other.simulationSteps;
+    handoffMicroseconds += other.handoffMicroseconds;
+    xRequests += other.xRequests;
+    xRequestBytes += other.xRequestBytes;
+    xRoundTrips += other.xRoundTrips;
+}
+
+RenderStats::RenderStats() : frames(0), wakeups(0), glObjects(0)
+{
+}
+
+void RenderStats::EndFrame()
+{
+    this->total.Add(this->frame);
+    this->frame.Reset();
+    this->frames++;
+}
+
+void RenderStats::Report(double elapsedSeconds)
+{
+    if (elapsedSeconds <= 0.0) {
+        return;
+    }
+
+    // an idle interval has no frames, its averages are reported as zero
+    double n = this->frames > 0 ? static_cast<double>(this->frames) : 1.0;
+    std::cout << "[stats] " << (this->frames / elapsedSeconds) << " fps"
+              << " | wakeups/s: " << (this->wakeups / elapsedSeconds)
+              << " | draw calls/frame: " << (this->total.drawCalls / n)
+              << " | sprites/frame: " << (this->total.spritesDrawn / n)
+              << " | spawned/frame: " << (this->total.particlesSpawned / n)
+              << " | suppressed/frame: " << (this->total.spawnsSuppressed / n)
+              << " | cursor samples/frame: " << (this->total.cursorSamples / n)
+              << " (" << this->total.cursorSamplesDropped << " dropped)"
+              << " | uploads/frame: " << (this->total.uploads / n)
+              << " | bytes uploaded/frame: " << (this->total.bytesUploaded / n)
+              << " | stream waits: " << this->total.streamWaits
+              << " | stall us/frame: " << (this->total.stallMicroseconds / n)
+              << " | repainted px/frame: " << (this->total.pixelsRepainted / n)
+              << " | GL state calls/frame: " << (this->total.stateCallsIssued / n) << " issued, "
+              << (this->total.stateCallsSkipped / n) << " skipped"
+              << " | GL objects: " << this->glObjects;
+    // only with the simulation on its own thread
+    if (this->total.simulationSteps > 0) {
+        std::cout << " | simulation steps/frame: " << (this->total.simulationSteps / n)
+                  << " | handoff us/frame: " << (this->total.handoffMicroseconds / n);
+    }
+    // only the X11 overlay talks to an X server
+    if (this->total.xRequests > 0) {
+        std::cout << " | X requests/frame: " << (this->total.xRequests / n)
+                  << " (" << (this->total.xRequestBytes / n) << " bytes)"
+                  << " | X round trips/frame: " << (this->total.xRoundTrips / n);
+    }
+    std::cout << std::endl;
+
+    this->total.Reset();
+    this->frames = 0;
+    this->wakeups = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef STATS_H
+#define STATS_H
+
+// Counters collected while a single frame is produced.
+struct FrameCounters
+{
+    unsigned long long drawCalls;       // draw commands submitted to GL
+    unsigned long long uploads;         // buffer upload calls issued
+    unsigned long long bytesUploaded;   // bytes handed to the driver by those uploads
+    unsigned long long spritesDrawn;    // sprites covered by the draw calls
+    unsigned long long streamWaits;     // times the CPU had to wait for the GPU to release a stream buffer region
+    unsigned long long stallMicroseconds; // time spent in those waits
+    unsigned long long pixelsRepainted; // surface pixels cleared and redrawn
+    unsigned long long stateCallsIssued;  // state changes forwarded to GL by GLStateCache
+    unsigned long long stateCallsSkipped; // redundant state changes filtered out by GLStateCache
+    unsigned long long particlesSpawned;  // trail particles added by the simulation
+    unsigned long long spawnsSuppressed;  // cursor moves the input filter dropped as jitter
+    unsigned long long cursorSamples;   // pointer positions queued by the input thread and simulated
+    unsigned long long cursorSamplesDropped; // pointer positions the input thread lost to a full queue
+    unsigned long long simulationSteps; // steps of the simulation thread behind the frame
+    unsigned long long handoffMicroseconds; // age of the simulation snapshot when the frame picked it up
+    unsigned long long xRequests;       // X11 overlay: protocol requests sent to the X server
+    unsigned long long xRequestBytes;   // bytes of those requests, pixel data included
+    unsigned long long xRoundTrips;     // requests that waited for a reply from the X server
+
+    FrameCounters() { this->Reset(); }
+    void Reset();
+    void Add(const FrameCounters& other);
+};
+
+// Per-frame renderer statistics. Subsystems increment the counters of
+// the current frame, EndFrame() folds them into the running totals and
+// Report() prints the per-frame averages since the previous report.
+// Idle loop iterations that skip rendering only count as wakeups.
+class RenderStats
+{
+public:
+    FrameCounters   frame;      // counters of the frame being produced
+    FrameCounters   total;      // accumulated since the last report
+    unsigned int    frames;     // frames accumulated since the last report
+    unsigned int    wakeups;    // main loop iterations since the last report, rendered or idle
+    long long       glObjects;  // GL textures, programs, buffers and vertex arrays currently alive
+
+    RenderStats();
+    // counts one main loop iteration
+    void Wakeup() { this->wakeups++; }
+    // closes the current frame
+    void EndFrame();
+    // prints the averages over the elapsed interval and starts a new one
+    void Report(double elapsedSeconds);
+};
+
+// Global statistics instance
+extern RenderStats g_stats;
+
+#endif
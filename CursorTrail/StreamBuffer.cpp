@@ -0,0 +1,159 @@
+#include "StreamBuffer.h"
+#include "Clock.h"
+#include "Stats.h"
+
+#include <iostream>
+
+
+StreamBuffer::StreamBuffer(size_t regionSize, bool allowPersistent)
+    : ID(0), persistent(false), regionSize(regionSize > 0 ? regionSize : 1), region(0), head(0), orphaned(false), mapped(nullptr)
+{
+    for (unsigned int i = 0; i < RegionCount; i++) {
+        this->fences[i] = nullptr;
+    }
+    this->persistent = allowPersistent && (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage);
+    this->create();
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    this->destroy();
+}
+
+void* StreamBuffer::Allocate(size_t bytes, size_t alignment, size_t& offset)
+{
+    size_t start = (this->head + alignment - 1) / alignment * alignment;
+    if (start + bytes > this->regionSize) {
+        if (bytes > this->regionSize) {
+            // a single allocation does not fit a region: grow the buffer
+            this->destroy();
+            this->regionSize = bytes * 2;
+            this->create();
+        }
+        else {
+            // region full: continue in the next one
+            this->EndFrame();
+        }
+        start = 0;
+    }
+
+    this->head = start + bytes;
+    if (this->persistent) {
+        offset = this->region * this->regionSize + start;
+        return this->mapped + offset;
+    }
+    offset = start;
+    return this->staging.data() + start;
+}
+
+void StreamBuffer::Commit(size_t offset, size_t bytes)
+{
+    if (bytes == 0) {
+        return;
+    }
+
+    g_stats.frame.uploads++;
+    g_stats.frame.bytesUploaded += static_cast<unsigned long long>(bytes);
+
+    if (this->persistent) {
+        // the mapping is coherent, the data is visible to commands issued from now on
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->ID);
+    if (!this->orphaned) {
+        // detach the storage the GPU may still read from instead of waiting for it
+        glBufferData(GL_ARRAY_BUFFER, this->regionSize, nullptr, GL_STREAM_DRAW);
+        this->orphaned = true;
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, this->staging.data() + offset);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::EndFrame()
+{
+    this->head = 0;
+    this->orphaned = false;
+    if (!this->persistent) {
+        return;
+    }
+
+    if (this->fences[this->region] != nullptr) {
+        glDeleteSync(this->fences[this->region]);
+    }
+    this->fences[this->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    this->region = (this->region + 1) % RegionCount;
+    this->waitForRegion(this->region);
+}
+
+void StreamBuffer::waitForRegion(unsigned int index)
+{
+    GLsync fence = this->fences[index];
+    if (fence == nullptr) {
+        return;
+    }
+
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        // the GPU is still reading this region, we are GPU-bound
+        double start = Clock::Seconds();
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+
+        g_stats.frame.streamWaits++;
+        g_stats.frame.stallMicroseconds += static_cast<unsigned long long>((Clock::Seconds() - start) * 1e6);
+    }
+    if (result == GL_WAIT_FAILED) {
+        std::cout << "ERROR::STREAM_BUFFER: glClientWaitSync failed" << std::endl;
+    }
+
+    glDeleteSync(fence);
+    this->fences[index] = nullptr;
+}
+
+void StreamBuffer::create()
+{
+    glGenBuffers(1, &this->ID);
+    g_stats.glObjects++;
+    glBindBuffer(GL_ARRAY_BUFFER, this->ID);
+    if (this->persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr size = static_cast<GLsizeiptr>(this->regionSize * RegionCount);
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        this->mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+        if (this->mapped == nullptr) {
+            std::cout << "ERROR::STREAM_BUFFER: Persistent mapping failed, falling back to orphaning" << std::endl;
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDeleteBuffers(1, &this->ID);
+            g_stats.glObjects--;
+            this->persistent = false;
+            this->create();
+            return;
+        }
+    }
+    else {
+        this->staging.resize(this->regionSize);
+        glBufferData(GL_ARRAY_BUFFER, this->regionSize, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    this->region = 0;
+    this->head = 0;
+}
+
+void StreamBuffer::destroy()
+{
+    for (unsigned int i = 0; i < RegionCount; i++) {
+        this->waitForRegion(i);
+    }
+    if (this->mapped != nullptr) {
+        glBindBuffer(GL_ARRAY_BUFFER, this->ID);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        this->mapped = nullptr;
+    }
+    glDeleteBuffers(1, &this->ID);
+    g_stats.glObjects--;
+    this->ID = 0;
+}
@@ -0,0 +1,54 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+// Streaming vertex buffer for data written by the CPU once per frame.
+// With GL 4.4 (or ARB_buffer_storage) the buffer is created with
+// glBufferStorage and stays persistently and coherently mapped. It is
+// split into RegionCount regions used round-robin, one per frame, and
+// each region is guarded by a fence so the CPU only waits when it gets
+// a full RegionCount frames ahead of the GPU. On older contexts the
+// buffer falls back to orphaning with glBufferData(NULL) once per frame
+// followed by glBufferSubData uploads.
+class StreamBuffer
+{
+public:
+    static const unsigned int RegionCount = 3;
+
+    // Constructor (regionSize is the number of bytes available per frame)
+    StreamBuffer(size_t regionSize, bool allowPersistent = true);
+    // Destructor
+    ~StreamBuffer();
+    // reserves bytes in the current frame's region; returns a pointer the
+    // caller fills and the offset of the data inside GetBuffer(). The
+    // offset is a multiple of alignment.
+    void* Allocate(size_t bytes, size_t alignment, size_t& offset);
+    // makes the bytes written to an allocation available to the GPU
+    void  Commit(size_t offset, size_t bytes);
+    // fences the current region and moves on to the next one
+    void  EndFrame();
+    unsigned int GetBuffer() const { return this->ID; }
+    bool  IsPersistent() const { return this->persistent; }
+private:
+    unsigned int        ID;
+    bool                persistent;
+    size_t              regionSize;
+    unsigned int        region;         // region written during the current frame
+    size_t              head;           // bytes allocated in the current region
+    bool                orphaned;       // fallback: storage orphaned this frame
+    unsigned char*      mapped;         // persistent mapping of the whole buffer
+    std::vector<unsigned char> staging; // fallback: CPU copy of the current region
+    GLsync              fences[RegionCount];
+    // creates the GL buffer for the current regionSize
+    void create();
+    void destroy();
+    // blocks until the GPU has finished reading the given region
+    void waitForRegion(unsigned int index);
+};
+
+#endif
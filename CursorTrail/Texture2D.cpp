@@ -1,12 +1,44 @@
 #include <iostream>
 
 #include "Texture2D.h"
+#include "GLStateCache.h"
+#include "Stats.h"
 
 
 Texture2D::Texture2D()
-    : Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR)
+    : ID(0), Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR)
 {
-    glGenTextures(1, &this->ID);
+}
+
+Texture2D::~Texture2D()
+{
+    this->release();
+}
+
+Texture2D::Texture2D(Texture2D&& other) noexcept
+    : ID(other.ID), Width(other.Width), Height(other.Height), Internal_Format(other.Internal_Format), Image_Format(other.Image_Format),
+      Wrap_S(other.Wrap_S), Wrap_T(other.Wrap_T), Filter_Min(other.Filter_Min), Filter_Max(other.Filter_Max)
+{
+    other.ID = 0;
+}
+
+Texture2D& Texture2D::operator=(Texture2D&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->release();
+        this->ID = other.ID;
+        this->Width = other.Width;
+        this->Height = other.Height;
+        this->Internal_Format = other.Internal_Format;
+        this->Image_Format = other.Image_Format;
+        this->Wrap_S = other.Wrap_S;
+        this->Wrap_T = other.Wrap_T;
+        this->Filter_Min = other.Filter_Min;
+        this->Filter_Max = other.Filter_Max;
+        other.ID = 0;
+    }
+    return *this;
 }
 
 void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char* data)
@@ -14,7 +46,12 @@ void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char*
     this->Width = width;
     this->Height = height;
     // create Texture
-    glBindTexture(GL_TEXTURE_2D, this->ID);
+    if (this->ID == 0)
+    {
+        glGenTextures(1, &this->ID);
+        g_stats.glObjects++;
+    }
+    g_glState.BindTexture2D(this->ID);
     glTexImage2D(GL_TEXTURE_2D, 0, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
     // set Texture wrap and filter modes
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
@@ -22,10 +59,20 @@ void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char*
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
     // unbind texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    g_glState.BindTexture2D(0);
 }
 
 void Texture2D::Bind() const
 {
-    glBindTexture(GL_TEXTURE_2D, this->ID);
+    g_glState.BindTexture2D(this->ID);
+}
+
+void Texture2D::release()
+{
+    if (this->ID == 0)
+        return;
+    g_glState.ForgetTexture(this->ID);
+    glDeleteTextures(1, &this->ID);
+    g_stats.glObjects--;
+    this->ID = 0;
 }
\ No newline at end of file
@@ -4,7 +4,9 @@
 #include <glad/glad.h>
 
 // Texture2D is able to store and configure a texture in OpenGL.
-// It also hosts utility functions for easy management.
+// It also hosts utility functions for easy management. Owns its GL
+// texture: it is created by Generate(), deleted with the object, and
+// can only be moved.
 class Texture2D
 {
 public:
@@ -20,12 +22,22 @@ public:
     unsigned int Wrap_T; // wrapping mode on T axis
     unsigned int Filter_Min; // filtering mode if texture pixels < screen pixels
     unsigned int Filter_Max; // filtering mode if texture pixels > screen pixels
-    // constructor (sets default texture modes)
+    // constructor (sets default texture modes, no GL object yet)
     Texture2D();
+    // destructor (deletes the texture)
+    ~Texture2D();
+    // move-only
+    Texture2D(Texture2D&& other) noexcept;
+    Texture2D& operator=(Texture2D&& other) noexcept;
+    Texture2D(const Texture2D&) = delete;
+    Texture2D& operator=(const Texture2D&) = delete;
     // generates texture from image data
     void Generate(unsigned int width, unsigned int height, unsigned char* data);
     // binds the texture as the current active GL_TEXTURE_2D texture object
     void Bind() const;
+private:
+    // deletes the texture, if any
+    void release();
 };
 
 #endif
\ No newline at end of file
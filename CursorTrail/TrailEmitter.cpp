@@ -0,0 +1,253 @@
+#include "TrailEmitter.h"
+#include "ParticleKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+    // below this spacing a fast flick would cost more particles than the ring holds
+    const float MinSpacing = 0.5f;
+
+    // centripetal knot interval: square root of the distance between two control points
+    float KnotInterval(float x0, float y0, float x1, float y1)
+    {
+        float interval = std::sqrt(std::sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0)));
+        // coincident control points would divide by zero
+        return std::max(interval, 1e-4f);
+    }
+
+    // cubic coefficients, highest power first, of one coordinate of the
+    // Catmull-Rom segment from p1 to p2 in Hermite form
+    void SegmentCoefficients(const float p[4], float dt0, float dt1, float dt2, float coefficients[4])
+    {
+        float m1 = ((p[1] - p[0]) / dt0 - (p[2] - p[0]) / (dt0 + dt1) + (p[2] - p[1]) / dt1) * dt1;
+        float m2 = ((p[2] - p[1]) / dt1 - (p[3] - p[1]) / (dt1 + dt2) + (p[3] - p[2]) / dt2) * dt1;
+        coefficients[0] = 2.0f * p[1] - 2.0f * p[2] + m1 + m2;
+        coefficients[1] = -3.0f * p[1] + 3.0f * p[2] - 2.0f * m1 - m2;
+        coefficients[2] = m1;
+        coefficients[3] = p[1];
+    }
+
+    // writes a single particle at the head of the ring
+    void SpawnAt(ParticleStore& particles, float x, float y, float time, float opacity, float lifetime)
+    {
+        unsigned int first[2], count[2];
+        particles.Append(1, first, count);
+        particles.Attribute(PARTICLE_X)[first[0]] = x;
+        particles.Attribute(PARTICLE_Y)[first[0]] = y;
+        particles.Attribute(PARTICLE_ALPHA)[first[0]] = opacity;
+        particles.Attribute(PARTICLE_SPAWN_TIME)[first[0]] = time;
+        particles.Attribute(PARTICLE_LIFETIME)[first[0]] = lifetime;
+    }
+
+    // rewrites the time and opacity of the newest particle, false when none is live
+    bool RefreshNewest(ParticleStore& particles, float time, float opacity)
+    {
+        if (particles.LiveCount() == 0) {
+            return false;
+        }
+        unsigned int newest = (particles.Head() + particles.Capacity() - 1) % particles.Capacity();
+        particles.Attribute(PARTICLE_ALPHA)[newest] = opacity;
+        particles.Attribute(PARTICLE_SPAWN_TIME)[newest] = time;
+        return true;
+    }
+}
+
+const float TrailEmitter::Tolerance = 0.25f;
+const float TrailEmitter::MaxRestGap = 0.05f;
+
+TrailEmitter::TrailEmitter()
+    : started(false), parked(false), refreshed(false), x(0.0f), y(0.0f), time(0.0f),
+      hasOlder(false), olderX(0.0f), olderY(0.0f), residual(0.0f)
+{
+}
+
+void TrailEmitter::Reset()
+{
+    this->started = false;
+    this->parked = false;
+    this->hasOlder = false;
+    this->residual = 0.0f;
+}
+
+unsigned int TrailEmitter::Move(ParticleStore& particles, float x, float y, float now, PathMode mode,
+                                float spacing, float opacity, float lifetime)
+{
+    float t0 = this->time;
+    this->time = now;
+    this->refreshed = false;
+
+    if (!this->started) {
+        // a path starts with a particle at its first point
+        this->started = true;
+        this->hasOlder = false;
+        this->x = x;
+        this->y = y;
+        this->residual = 0.0f;
+        SpawnAt(particles, x, y, now, opacity, lifetime);
+        return 1;
+    }
+    // a cursor coming to rest gets one head particle under it, or takes
+    // the last one when it already sits there; after that every resting
+    // sample refreshes the head instead of spawning
+    if (x == this->x && y == this->y) {
+        bool adopt = this->parked || this->residual <= 0.0f;
+        this->parked = true;
+        this->residual = 0.0f;
+        if (adopt && RefreshNewest(particles, now, opacity)) {
+            this->refreshed = true;
+            return 0;
+        }
+        SpawnAt(particles, x, y, now, opacity, lifetime);
+        return 1;
+    }
+    // the head fades from when the cursor left it, at most MaxRestGap ago
+    if (this->parked) {
+        this->parked = false;
+        t0 = std::max(t0, now - MaxRestGap);
+        this->refreshed = RefreshNewest(particles, t0, opacity);
+    }
+
+    float pathX[MaxPieces + 1], pathY[MaxPieces + 1];
+    unsigned int points = 2;
+    pathX[0] = this->x;
+    pathY[0] = this->y;
+    pathX[1] = x;
+    pathY[1] = y;
+    if (mode == PATH_SPLINE) {
+        points = this->curve(x, y, pathX, pathY);
+    }
+
+    this->hasOlder = true;
+    this->olderX = this->x;
+    this->olderY = this->y;
+    this->x = x;
+    this->y = y;
+    return this->emitAlong(particles, pathX, pathY, points, t0, now, std::max(spacing, MinSpacing), opacity, lifetime);
+}
+
+unsigned int TrailEmitter::curve(float x, float y, float* pathX, float* pathY) const
+{
+    // The phantom after the end continues the parabola through the last
+    // three samples, so a turning cursor keeps turning. A path that just
+    // started has no sample before the segment and runs straight on at
+    // both ends instead
+    float px[4], py[4];
+    px[1] = this->x;
+    py[1] = this->y;
+    px[2] = x;
+    py[2] = y;
+    if (this->hasOlder) {
+        px[0] = this->olderX;
+        py[0] = this->olderY;
+        px[3] = 3.0f * x - 3.0f * this->x + this->olderX;
+        py[3] = 3.0f * y - 3.0f * this->y + this->olderY;
+    }
+    else {
+        px[0] = 2.0f * this->x - x;
+        py[0] = 2.0f * this->y - y;
+        px[3] = 2.0f * x - this->x;
+        py[3] = 2.0f * y - this->y;
+    }
+    float dt0 = KnotInterval(px[0], py[0], px[1], py[1]);
+    float dt1 = KnotInterval(px[1], py[1], px[2], py[2]);
+    float dt2 = KnotInterval(px[2], py[2], px[3], py[3]);
+    float cx[4], cy[4];
+    SegmentCoefficients(px, dt0, dt1, dt2, cx);
+    SegmentCoefficients(py, dt0, dt1, dt2, cy);
+
+    // A chord of parameter length h is at most h^2 / 8 * max|p''| away from
+    // the curve; p'' is linear in u, so its largest length is at an end
+    float startX = 2.0f * cx[1], startY = 2.0f * cy[1];
+    float endX = 6.0f * cx[0] + startX, endY = 6.0f * cy[0] + startY;
+    float bend = std::sqrt(std::max(startX * startX + startY * startY, endX * endX + endY * endY));
+    unsigned int pieces = static_cast<unsigned int>(std::ceil(std::sqrt(bend / (8.0f * Tolerance))));
+    pieces = std::min(std::max(pieces, 1u), MaxPieces);
+    if (pieces == 1) {
+        return 2;
+    }
+
+    // evaluate all points of the curve as one batch
+    float u[MaxPieces + 1];
+    for (unsigned int i = 0; i <= pieces; i++) {
+        u[i] = static_cast<float>(i) / pieces;
+    }
+    CubicKernel(cx, u, pathX, pieces + 1);
+    CubicKernel(cy, u, pathY, pieces + 1);
+    pathX[pieces] = x;
+    pathY[pieces] = y;
+    return pieces + 1;
+}
+
+unsigned int TrailEmitter::emitAlong(ParticleStore& particles, const float* pathX, const float* pathY, unsigned int points,
+                                     float t0, float t1, float spacing, float opacity, float lifetime)
+{
+    float lengths[MaxPieces], dirX[MaxPieces], dirY[MaxPieces];
+    float length = 0.0f;
+    for (unsigned int i = 0; i + 1 < points; i++) {
+        float dx = pathX[i + 1] - pathX[i];
+        float dy = pathY[i + 1] - pathY[i];
+        lengths[i] = std::sqrt(dx * dx + dy * dy);
+        dirX[i] = lengths[i] > 0.0f ? dx / lengths[i] : 0.0f;
+        dirY[i] = lengths[i] > 0.0f ? dy / lengths[i] : 0.0f;
+        length += lengths[i];
+    }
+    if (length <= 0.0f) {
+        return 0;
+    }
+
+    // particle k sits at arc length (k + 1) * spacing - residual along the path
+    float travelled = this->residual + length;
+    unsigned int spawn = static_cast<unsigned int>(travelled / spacing);
+    this->residual = travelled - spawn * spacing;
+    if (spawn == 0) {
+        return 0;
+    }
+
+    // A segment longer than the ring only keeps its newest particles
+    unsigned int skip = spawn > particles.Capacity() ? spawn - particles.Capacity() : 0;
+    float timePerLength = (t1 - t0) / length;
+    float start = spacing - (travelled - length);
+
+    float* xs = particles.Attribute(PARTICLE_X);
+    float* ys = particles.Attribute(PARTICLE_Y);
+    float* alphas = particles.Attribute(PARTICLE_ALPHA);
+    float* spawnTimes = particles.Attribute(PARTICLE_SPAWN_TIME);
+    float* lifetimes = particles.Attribute(PARTICLE_LIFETIME);
+    unsigned int first[2], count[2];
+    unsigned int spans = particles.Append(spawn - skip, first, count);
+    unsigned int k = skip;
+    unsigned int piece = 0;
+    float pieceStart = 0.0f;   // arc length at the start of the piece
+    for (unsigned int s = 0; s < spans; s++) {
+        unsigned int i = first[s];
+        unsigned int end = first[s] + count[s];
+        while (i < end) {
+            // the run of particles on this piece; the last piece takes the rest
+            unsigned int last = end;
+            if (piece + 2 < points) {
+                float beyond = (pieceStart + lengths[piece] - start) / spacing;
+                unsigned int next = beyond < 0.0f ? 0 : static_cast<unsigned int>(beyond) + 1;
+                last = std::min(end, i + (next > k ? next - k : 0));
+            }
+            // position = origin + direction * arc length, a loop without dependencies
+            float originX = pathX[piece] - dirX[piece] * pieceStart;
+            float originY = pathY[piece] - dirY[piece] * pieceStart;
+            for (; i < last; i++, k++) {
+                float along = start + k * spacing;
+                xs[i] = originX + dirX[piece] * along;
+                ys[i] = originY + dirY[piece] * along;
+                alphas[i] = opacity;
+                spawnTimes[i] = t0 + timePerLength * along;
+                lifetimes[i] = lifetime;
+            }
+            if (i < end) {
+                pieceStart += lengths[piece];
+                piece++;
+            }
+        }
+    }
+    return spawn - skip;
+}
@@ -0,0 +1,75 @@
+#ifndef TRAIL_EMITTER_H
+#define TRAIL_EMITTER_H
+
+#include "ParticleStore.h"
+#include "Config.h"
+
+// Spawns trail particles along the cursor path at a fixed arc length
+// spacing. The distance travelled since the last particle carries over
+// from one sample to the next, so particles sit at exact multiples of
+// the spacing along the whole path however it is cut into samples, and
+// slow or tiny movements spawn only as many particles as they cover.
+// Every particle gets the time the cursor passed it, interpolated
+// between the sample timestamps. The particles of a segment are counted
+// up front and written into the store as one span.
+//
+// A resting cursor keeps one head particle under it: the newest slot is
+// rewritten in place with the current time and full opacity every
+// resting step instead of stacking new particles there, so the head
+// never fades while the trail behind it does. When the cursor moves on,
+// the head fades from the time it left.
+//
+// With PATH_SPLINE the segment between two samples follows a centripetal
+// Catmull-Rom curve through the sample before it, both ends and a
+// phantom point continuing the segment, so the head of the trail does
+// not wait for the next sample. The curve is flattened into as many
+// straight pieces as its curvature needs to stay within Tolerance, at
+// most MaxPieces; a straight segment stays one piece.
+class TrailEmitter
+{
+public:
+    // largest distance of the flattened curve from the spline (pixels)
+    static const float Tolerance;
+    static const unsigned int MaxPieces = 32;
+
+    TrailEmitter();
+    // forgets the path, the next sample starts a new one
+    void         Reset();
+    // moves the cursor to (x, y) at Clock time now and spawns the
+    // particles the segment from the previous sample covers; the first
+    // sample of a path spawns one, and so does the first resting sample
+    // when the last particle lags behind the cursor. Returns the
+    // particles spawned
+    unsigned int Move(ParticleStore& particles, float x, float y, float now, PathMode mode,
+                      float spacing, float opacity, float lifetime);
+    // moves the sample time back by shift seconds (Clock rebase)
+    void         ShiftTime(float shift) { this->time -= shift; }
+    // arc length travelled since the last particle
+    float        Residual() const { return this->residual; }
+    // the cursor rests and the newest particle is its head, refreshed by every Move
+    bool         Parked() const { return this->parked; }
+    // the last Move rewrote the slot before the particles it spawned (the
+    // head); a GPU mirror has to upload it again
+    bool         HeadRefreshed() const { return this->refreshed; }
+private:
+    // longest time a segment leaving a parked head is spread over; the
+    // loop may have slept through the rest (seconds)
+    static const float MaxRestGap;
+
+    bool  started;
+    bool  parked;
+    bool  refreshed;
+    float x, y;         // previous sample
+    float time;
+    bool  hasOlder;     // the sample before it is known
+    float olderX, olderY;
+    float residual;
+    // flattens the spline from the previous sample to (x, y) into
+    // pathX/pathY, MaxPieces + 1 entries each; returns the points
+    unsigned int curve(float x, float y, float* pathX, float* pathY) const;
+    // spawns along the polyline of the given points
+    unsigned int emitAlong(ParticleStore& particles, const float* pathX, const float* pathY, unsigned int points,
+                           float t0, float t1, float spacing, float opacity, float lifetime);
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "TrailPart.h"
 
 TrailPart::TrailPart()
+	: x(0.0f), y(0.0f), time(0.0f), spawnTime(0.0f), lifetime(0.0f)
 {
 }
 
@@ -9,4 +10,28 @@ TrailPart::TrailPart(float x, float y, float time)
 	this->x = x;
 	this->y = y;
 	this->time = time;
+	this->spawnTime = 0.0f;
+	this->lifetime = 0.0f;
+}
+
+TrailPart::TrailPart(float x, float y, float time, float spawnTime, float lifetime)
+{
+	this->x = x;
+	this->y = y;
+	this->time = time;
+	this->spawnTime = spawnTime;
+	this->lifetime = lifetime;
+}
+
+float TrailPart::AlphaAt(float now) const
+{
+	if (this->lifetime <= 0.0f) {
+		return 0.0f;
+	}
+
+	float remaining = 1.0f - (now - this->spawnTime) / this->lifetime;
+	if (remaining <= 0.0f) {
+		return 0.0f;
+	}
+	return this->time * remaining;
 }
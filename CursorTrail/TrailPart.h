@@ -4,8 +4,13 @@ class TrailPart
 public:
 	float x;
 	float y;
-	float time;
+	float time;         // opacity; decremented every frame in FADE_FRAME mode, initial opacity in FADE_TIME mode
+	float spawnTime;    // Clock time the particle was spawned at
+	float lifetime;     // seconds until the particle is fully faded (FADE_TIME mode)
 	TrailPart();
 	TrailPart(float x, float y, float time);
+	TrailPart(float x, float y, float time, float spawnTime, float lifetime);
+	// opacity at the given Clock time when fading by lifetime
+	float AlphaAt(float now) const;
 };
 
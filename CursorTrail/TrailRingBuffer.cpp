@@ -0,0 +1,73 @@
+#include "TrailRingBuffer.h"
+#include "Stats.h"
+
+#include <vector>
+
+
+TrailRingBuffer::TrailRingBuffer(unsigned int capacity, StreamBuffer* stream)
+    : VBO(0), capacity(capacity), stream(stream)
+{
+    // zeroed slots have no lifetime and are never visible
+    std::vector<SpriteInstance> empty(capacity, SpriteInstance());
+    glGenBuffers(1, &this->VBO);
+    g_stats.glObjects++;
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(SpriteInstance), empty.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+TrailRingBuffer::~TrailRingBuffer()
+{
+    glDeleteBuffers(1, &this->VBO);
+    g_stats.glObjects--;
+}
+
+void TrailRingBuffer::Sync(const ParticleStore& particles, unsigned int written, float spriteSize)
+{
+    if (written == 0) {
+        return;
+    }
+    if (written > this->capacity) {
+        written = this->capacity;
+    }
+
+    // the dirty slots end right before the write head and may wrap around the end of the ring
+    unsigned int first = (particles.Head() + this->capacity - written) % this->capacity;
+    unsigned int tail = this->capacity - first;
+
+    if (written <= tail) {
+        this->uploadSpan(particles, first, written, spriteSize);
+    }
+    else {
+        this->uploadSpan(particles, first, tail, spriteSize);
+        this->uploadSpan(particles, 0, written - tail, spriteSize);
+    }
+}
+
+void TrailRingBuffer::uploadSpan(const ParticleStore& particles, unsigned int first, unsigned int count, float spriteSize)
+{
+    size_t bytes = count * sizeof(SpriteInstance);
+    size_t offset;
+    SpriteInstance* staging = static_cast<SpriteInstance*>(this->stream->Allocate(bytes, sizeof(float), offset));
+    const float* xs = particles.Attribute(PARTICLE_X) + first;
+    const float* ys = particles.Attribute(PARTICLE_Y) + first;
+    const float* alphas = particles.Attribute(PARTICLE_ALPHA) + first;
+    const float* spawnTimes = particles.Attribute(PARTICLE_SPAWN_TIME) + first;
+    const float* lifetimes = particles.Attribute(PARTICLE_LIFETIME) + first;
+    for (unsigned int i = 0; i < count; i++) {
+        SpriteInstance& instance = staging[i];
+        instance.position = glm::vec2(xs[i] - spriteSize / 2.0f, ys[i] - spriteSize / 2.0f);
+        instance.size = spriteSize;
+        instance.alpha = alphas[i];
+        instance.spawnTime = spawnTimes[i];
+        instance.lifetime = lifetimes[i];
+    }
+    this->stream->Commit(offset, bytes);
+
+    // copy the span into its place in the mirror on the GPU timeline
+    glBindBuffer(GL_COPY_READ_BUFFER, this->stream->GetBuffer());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->VBO);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, first * sizeof(SpriteInstance), bytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
@@ -0,0 +1,40 @@
+#ifndef TRAIL_RING_BUFFER_H
+#define TRAIL_RING_BUFFER_H
+
+#include <glad/glad.h>
+
+#include "ParticleStore.h"
+#include "SpriteBatchRenderer.h"
+#include "StreamBuffer.h"
+
+
+// GPU-resident mirror of the circular ParticleStore kept by Game.
+// Every slot of the store has a matching SpriteInstance in a vertex
+// buffer; Sync() converts and uploads only the slots written since the
+// previous sync, which form at most two contiguous spans of the ring.
+// The spans are written into a StreamBuffer and copied into the mirror
+// on the GPU, so the CPU never waits for draws still reading the ring.
+// Upload bandwidth therefore follows the spawn rate instead of the
+// particle capacity. Requires fading on the GPU, the instance data of a
+// particle never changes after it has been spawned.
+class TrailRingBuffer
+{
+public:
+    // Constructor (allocates the instance buffer for capacity slots), uploads go through stream
+    TrailRingBuffer(unsigned int capacity, StreamBuffer* stream);
+    // Destructor
+    ~TrailRingBuffer();
+    // uploads the slots written since the last sync, written is their number
+    void Sync(const ParticleStore& particles, unsigned int written, float spriteSize);
+    // vertex buffer holding one SpriteInstance per slot
+    unsigned int GetBuffer() const { return this->VBO; }
+    unsigned int Capacity() const { return this->capacity; }
+private:
+    unsigned int                VBO;
+    unsigned int                capacity;
+    StreamBuffer*               stream;
+    // converts and uploads count slots starting at first (no wrap)
+    void uploadSpan(const ParticleStore& particles, unsigned int first, unsigned int count, float spriteSize);
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "TrailSimulation.h"
+#include "Config.h"
+#include "Stats.h"
+
+#include <chrono>
+
+TrailSimulation::TrailSimulation()
+    : rate(Config::FadeReferenceRate), stopping(false), finished(false), time(0.0f)
+{
+}
+
+TrailSimulation::~TrailSimulation()
+{
+    this->Stop();
+}
+
+void TrailSimulation::Start(std::unique_ptr<CursorSource> source, double rate)
+{
+    this->Stop();
+    this->source = std::move(source);
+    this->rate = rate > 0.0 ? rate : Config::FadeReferenceRate;
+    this->particles.Resize(g_config.maxParticles);
+    this->stopping = false;
+    this->finished = false;
+    this->thread = std::thread(&TrailSimulation::run, this);
+}
+
+void TrailSimulation::Stop()
+{
+    this->stopping = true;
+    if (this->thread.joinable()) {
+        this->source->Interrupt();
+        this->thread.join();
+    }
+}
+
+TrailSnapshot* TrailSimulation::Latest()
+{
+    if (!this->snapshots.Acquire()) {
+        return nullptr;
+    }
+    TrailSnapshot& snapshot = this->snapshots.Front();
+    const TrailTotals& totals = snapshot.totals;
+    g_stats.frame.particlesSpawned += totals.written - this->seen.written;
+    g_stats.frame.spawnsSuppressed += totals.suppressed - this->seen.suppressed;
+    g_stats.frame.cursorSamples += totals.samples - this->seen.samples;
+    g_stats.frame.cursorSamplesDropped += totals.dropped - this->seen.dropped;
+    g_stats.frame.simulationSteps += totals.steps - this->seen.steps;
+    g_stats.frame.handoffMicroseconds += static_cast<unsigned long long>((Clock::Seconds() - snapshot.published) * 1e6);
+    this->seen = totals;
+    return &snapshot;
+}
+
+void TrailSimulation::run()
+{
+    double interval = 1.0 / this->rate;
+    double next = Clock::Seconds();
+    while (!this->stopping.load(std::memory_order_relaxed)) {
+        CursorSample before = this->cursor;
+        bool more = ReadFrameSamples(*this->source, this->totals.samples, this->totals.dropped,
+                                     [this](const CursorSample& sample) { this->update(sample); });
+        bool moved = this->cursor.x != before.x || this->cursor.y != before.y;
+
+        // fadeRate is per frame at FadeReferenceRate, scale it to the step rate
+        if (g_config.fadeMode == FADE_FRAME) {
+            this->particles.Fade(static_cast<float>(g_config.fadeRate * Config::FadeReferenceRate / this->rate));
+        }
+        this->particles.Expire(g_config.fadeMode, this->time);
+        this->totals.steps++;
+        this->publish();
+        if (!more) {
+            this->finished.store(true, std::memory_order_release);
+            return;
+        }
+
+        // Park while the cursor rests and the trail has faded out to its
+        // head: that trail is published, nothing changes until the source
+        // queues a sample. Sources that cannot wait keep the fixed rate
+        unsigned int resting = this->emitter.Parked() ? 1 : 0;
+        if (!moved && this->particles.LiveCount() <= resting && !this->source->Pending() && this->source->Wait(-1)) {
+            next = Clock::Seconds();
+            continue;
+        }
+
+        next += interval;
+        double now = Clock::Seconds();
+        if (next > now) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(next - now));
+        }
+        else if (now - next > interval) {
+            // fell behind by more than a step: carry on from now instead of catching up in a burst
+            next = now;
+        }
+    }
+}
+
+void TrailSimulation::update(const CursorSample& sample)
+{
+    // Same step as the lockstep Update of Game and the overlays
+    this->clock.SetTime(sample.time);
+    float shift;
+    if (this->clock.Rebase(shift)) {
+        this->particles.ShiftSpawnTimes(shift);
+        this->emitter.ShiftTime(shift);
+        this->totals.rebases++;
+    }
+    this->time = this->clock.Now();
+
+    CursorSample cursor = sample;
+    if (!this->filter.Apply(cursor.time, cursor.x, cursor.y, g_config.filterCutoff, g_config.filterBeta, g_config.deadZone)) {
+        this->totals.suppressed++;
+    }
+    this->cursor = cursor;
+
+    unsigned int spawned = this->emitter.Move(this->particles, static_cast<float>(cursor.x), static_cast<float>(cursor.y),
+                                              this->time, g_config.pathMode, g_config.spawnFrequency, g_config.fadeTime,
+                                              g_config.ParticleLifetime());
+    this->totals.written += spawned;
+    if (this->emitter.HeadRefreshed()) {
+        this->totals.refreshes++;
+        this->totals.sinceRefresh = spawned;
+    }
+    else {
+        this->totals.sinceRefresh += spawned;
+    }
+}
+
+void TrailSimulation::publish()
+{
+    TrailSnapshot& snapshot = this->snapshots.Back();
+    snapshot.particles.CopyFrom(this->particles);
+    snapshot.time = this->time;
+    snapshot.cursor = this->cursor;
+    snapshot.parked = this->emitter.Parked();
+    snapshot.totals = this->totals;
+    snapshot.published = Clock::Seconds();
+    this->snapshots.Publish();
+}
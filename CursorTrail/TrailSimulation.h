@@ -0,0 +1,97 @@
+#ifndef TRAIL_SIMULATION_H
+#define TRAIL_SIMULATION_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "ParticleStore.h"
+#include "TrailEmitter.h"
+#include "CursorFilter.h"
+#include "CursorSource.h"
+#include "TripleBuffer.h"
+#include "Clock.h"
+
+// Running totals of a simulation since it started; renderers take the
+// difference to the totals of the snapshot they drew before
+struct TrailTotals
+{
+    unsigned long long steps;
+    unsigned long long written;     // particles spawned, the slots a GPU mirror has to upload
+    unsigned long long rebases;     // Clock rebases, each one moved every spawn time
+    unsigned long long samples;     // queued cursor samples consumed
+    unsigned long long dropped;     // cursor samples the source lost to a full queue
+    unsigned long long suppressed;  // moves the cursor filter dropped
+    unsigned long long refreshes;   // head particles rewritten in place under a resting cursor
+    unsigned long long sinceRefresh;    // particles spawned since the last refresh, after the head slot
+
+    TrailTotals() : steps(0), written(0), rebases(0), samples(0), dropped(0), suppressed(0), refreshes(0), sinceRefresh(0) { }
+};
+
+// The trail as the simulation thread left it after one step
+struct TrailSnapshot
+{
+    ParticleStore particles;
+    float         time;         // Clock time of the step
+    CursorSample  cursor;       // newest sample simulated, after the cursor filter
+    bool          parked;       // the newest particle is the head under the resting cursor
+    double        published;    // Clock::Seconds() when the snapshot was published
+    TrailTotals   totals;
+
+    TrailSnapshot() : time(0.0f), parked(false), published(0.0) { }
+};
+
+// Runs the trail simulation on a thread of its own at a fixed rate,
+// decoupled from input and rendering. Every step drains the samples the
+// cursor source queued since the previous one (the X11 input thread
+// feeds it through an SPSC queue), advances the same filter, emitter and
+// particle ring the render loops use in lockstep, and publishes a copy of
+// the live window through a triple buffer. The render thread picks up the
+// newest complete snapshot with Latest() and never waits for the
+// simulation, so a stalled present delays neither input nor simulation.
+// Once the cursor rests and the trail has faded out to the head under
+// it the thread parks in
+// the source's Wait() until a new sample is queued, for sources that can
+// wait; the others are stepped at the fixed rate throughout.
+//
+// The source is only read on the simulation thread; it has to be safe to
+// use off the thread that created it.
+class TrailSimulation
+{
+public:
+    TrailSimulation();
+    ~TrailSimulation();
+    // takes over the source and starts stepping rate times per second
+    void Start(std::unique_ptr<CursorSource> source, double rate);
+    // stops the thread; the last published snapshot stays readable
+    void Stop();
+    // true once the source is exhausted (the end of a replay)
+    bool Finished() const { return this->finished.load(std::memory_order_acquire); }
+    // render thread: the newest snapshot published since the last call,
+    // or null. Its counters are added to the stats of the current frame.
+    // The snapshot stays valid and owned by the caller until the next call
+    TrailSnapshot* Latest();
+    TrailSimulation(const TrailSimulation&) = delete;
+    TrailSimulation& operator=(const TrailSimulation&) = delete;
+private:
+    std::unique_ptr<CursorSource> source;
+    double                     rate;
+    std::thread                thread;
+    std::atomic<bool>          stopping;
+    std::atomic<bool>          finished;
+    TripleBuffer<TrailSnapshot> snapshots;
+    TrailTotals                seen;        // totals of the snapshot Latest() returned before
+
+    // simulation thread state
+    ParticleStore particles;
+    TrailEmitter  emitter;
+    CursorFilter  filter;
+    Clock         clock;
+    float         time;
+    CursorSample  cursor;
+    TrailTotals   totals;
+    void run();
+    void update(const CursorSample& sample);
+    void publish();
+};
+
+#endif
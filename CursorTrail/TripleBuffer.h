@@ -0,0 +1,52 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Lock-free handoff of whole values from one writer thread to one reader
+// thread. The writer fills the back slot and publishes it by swapping it
+// with the middle slot; the reader takes the middle slot in exchange for
+// the one it held. Neither side ever waits: the writer always has a slot
+// of its own, and the reader keeps the last complete value until a newer
+// one is published. Values the reader did not pick up in time are
+// overwritten, only the newest one matters.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : back(0), middle(1), front(2) { }
+
+    // writer side: the slot to fill, invisible to the reader until Publish()
+    T&   Back() { return this->slots[this->back]; }
+    void Publish()
+    {
+        this->back = this->middle.exchange(this->back | Fresh, std::memory_order_acq_rel) & Index;
+    }
+
+    // reader side: switches Front() to the newest published value, false
+    // when nothing was published since the last call
+    bool Acquire()
+    {
+        if ((this->middle.load(std::memory_order_relaxed) & Fresh) == 0) {
+            return false;
+        }
+        this->front = this->middle.exchange(this->front, std::memory_order_acq_rel) & Index;
+        return true;
+    }
+    // the value taken by the last successful Acquire(); the reader may
+    // modify it, the writer gets the slot back without looking at it
+    T&   Front() { return this->slots[this->front]; }
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+private:
+    // the middle index carries a flag for a value the reader has not taken yet
+    static const unsigned int Fresh = 4;
+    static const unsigned int Index = 3;
+
+    T                         slots[3];
+    unsigned int              back;     // owned by the writer
+    std::atomic<unsigned int> middle;
+    unsigned int              front;    // owned by the reader
+};
+
+#endif
@@ -5,6 +5,7 @@
 #endif
 
 #include "WindowsOverlay.h"
+#include "Stats.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
@@ -21,13 +22,15 @@ WindowsOverlay::WindowsOverlay()
     , m_hOldBitmap(nullptr)
     , m_screenWidth(0)
     , m_screenHeight(0)
-    , m_currentIndex(0)
+    , m_currentTime(0.0f)
+    , m_lastCursor()
+    , m_hasCursor(false)
+    , m_cursorMoved(true)
+    , m_headParked(false)
+    , m_mouseHook(nullptr)
     , m_gdiplusToken(0)
 {
-    m_trailParts.reserve(g_config.maxParticles);
-    for (int i = 0; i < g_config.maxParticles; ++i) {
-        m_trailParts.emplace_back(0.0f, 0.0f, 0.0f);
-    }
+    m_particles.Resize(g_config.maxParticles);
 }
 
 WindowsOverlay::~WindowsOverlay()
@@ -63,13 +66,20 @@ bool WindowsOverlay::Initialize()
         return false;
     }
 
+    // The window covers the screen, or only the trail in bounding-window mode
+    DamageRect window(0, 0, m_screenWidth, m_screenHeight);
+    if (g_config.boundingWindow) {
+        m_trailWindow.SetScreen(window);
+        window = m_trailWindow.Rect();
+    }
+
     // Create layered window for transparent overlay
     m_hwnd = CreateWindowExW(
         WS_EX_LAYERED | WS_EX_TOPMOST | WS_EX_TRANSPARENT | WS_EX_TOOLWINDOW,
         L"CursorTrailOverlay",
         L"Cursor Trail",
         WS_POPUP,
-        0, 0, m_screenWidth, m_screenHeight,
+        window.x, window.y, window.width, window.height,
         nullptr, nullptr, GetModuleHandle(nullptr), this
     );
 
@@ -86,17 +96,10 @@ bool WindowsOverlay::Initialize()
     m_hdc = GetDC(m_hwnd);
     m_memDC = CreateCompatibleDC(m_hdc);
     
-    BITMAPINFO bmi = {};
-    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    bmi.bmiHeader.biWidth = m_screenWidth;
-    bmi.bmiHeader.biHeight = -m_screenHeight; // Top-down DIB
-    bmi.bmiHeader.biPlanes = 1;
-    bmi.bmiHeader.biBitCount = 32;
-    bmi.bmiHeader.biCompression = BI_RGB;
-
-    void* pBits;
-    m_hBitmap = CreateDIBSection(m_memDC, &bmi, DIB_RGB_COLORS, &pBits, nullptr, 0);
-    m_hOldBitmap = (HBITMAP)SelectObject(m_memDC, m_hBitmap);
+    if (!ResizeSurface(window)) {
+        std::cerr << "Failed to create overlay bitmap" << std::endl;
+        return false;
+    }
 
     // Load trail texture from configuration
     // Try multiple paths to find the texture file
@@ -155,109 +158,192 @@ bool WindowsOverlay::Initialize()
     return true;
 }
 
-void WindowsOverlay::Update()
+bool WindowsOverlay::ResizeSurface(const DamageRect& rect)
+{
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = rect.width;
+    bmi.bmiHeader.biHeight = -rect.height; // Top-down DIB
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    void* pBits;
+    HBITMAP bitmap = CreateDIBSection(m_memDC, &bmi, DIB_RGB_COLORS, &pBits, nullptr, 0);
+    if (!bitmap) {
+        return false;
+    }
+
+    // Swap the new DIB in, keeping the DC's original bitmap for Cleanup
+    HBITMAP previous = (HBITMAP)SelectObject(m_memDC, bitmap);
+    if (m_hBitmap) {
+        DeleteObject(m_hBitmap);
+    } else {
+        m_hOldBitmap = previous;
+    }
+    m_hBitmap = bitmap;
+    m_window = rect;
+
+    // The new DIB starts out transparent, the next frame repaints all of it
+    m_damage.Resize(rect.width, rect.height, rect.x, rect.y);
+    return true;
+}
+
+void WindowsOverlay::Update(const CursorSample& sample)
 {
     if (!m_hwnd) return;
 
-    // Get global cursor position
-    POINT cursorPos;
-    if (GetCursorPos(&cursorPos)) {
-        TrailPart currentTrail(static_cast<float>(cursorPos.x), static_cast<float>(cursorPos.y), g_config.fadeTime);
-        
-        // Calculate previous index BEFORE adding current trail
-        size_t prevIndex = (m_currentIndex == 0) ? m_trailParts.size() - 1 : m_currentIndex - 1;
-        
-        // Add the current cursor position to trail (match OpenGL version exactly)
-        AddTrailPart(currentTrail);
-        
-        // Interpolate trail between current and previous position ONLY (like OpenGL Game.cpp)
-        const TrailPart& previousTrail = m_trailParts[prevIndex];
-        
-        float dx = currentTrail.x - previousTrail.x;
-        float dy = currentTrail.y - previousTrail.y;
-        float distance = std::sqrt(dx * dx + dy * dy);
-        
-        // Avoid division by zero and match OpenGL logic exactly
-        if (distance > 0.0f) {
-            float dirX = dx / distance;
-            float dirY = dy / distance;
-            
-            // Use configurable interpolation interval
-            float interval = g_config.spawnFrequency;
-            float stopAt = distance;
-            
-            for (float d = interval; d < stopAt; d += interval) {
-                float interpX = previousTrail.x + dirX * d;
-                float interpY = previousTrail.y + dirY * d;
-                AddTrailPart(TrailPart(interpX, interpY, g_config.fadeTime));
-            }
-        }
-        
+    // The sample clock drives the trail, replays run on recorded time
+    m_clock.SetTime(sample.time);
+    // Keep particle timestamps small so they stay precise as floats
+    float shift;
+    if (m_clock.Rebase(shift)) {
+        m_particles.ShiftSpawnTimes(shift);
+        m_emitter.ShiftTime(shift);
+    }
+    m_currentTime = m_clock.Now();
+    float lifetime = g_config.ParticleLifetime();
+
+    // Smooth out sensor jitter like Game::Update
+    CursorSample cursor = sample;
+    if (!m_filter.Apply(cursor.time, cursor.x, cursor.y, g_config.filterCutoff, g_config.filterBeta, g_config.deadZone)) {
+        g_stats.frame.spawnsSuppressed++;
+    }
+
+    // A resting cursor spawns nothing, the trail fades out and the overlay goes idle
+    m_cursorMoved = !m_hasCursor || cursor.x != m_lastCursor.x || cursor.y != m_lastCursor.y;
+    m_lastCursor = cursor;
+    m_hasCursor = true;
+
+    // Spawn particles every spawnFrequency pixels along the path like Game::Update
+    g_stats.frame.particlesSpawned += m_emitter.Move(m_particles, static_cast<float>(cursor.x), static_cast<float>(cursor.y),
+                                                     m_currentTime, g_config.pathMode, g_config.spawnFrequency, g_config.fadeTime, lifetime);
+    m_headParked = m_emitter.Parked();
+
+    if (m_cursorMoved) {
         // Debug output (first few seconds only)
         static int debugCounter = 0;
         if (debugCounter < 60) { // Print for first 60 frames only
-            std::cout << "Cursor at: " << cursorPos.x << "," << cursorPos.y << " Trail parts active: ";
-            int activeCount = 0;
-            for (const auto& part : m_trailParts) {
-                if (part.time > 0.0f) activeCount++;
-            }
-            std::cout << activeCount << std::endl;
+            std::cout << "Cursor at: " << sample.x << "," << sample.y << " Trail parts active: ";
+            std::cout << m_particles.CountAlive(g_config.fadeMode, m_currentTime) << std::endl;
             debugCounter++;
         }
     }
 
     // Update trail fade times - use configurable fade rate
-    for (auto& part : m_trailParts) {
-        if (part.time > 0.0f) {
-            part.time -= g_config.fadeRate;
-            if (part.time < 0.0f) {
-                part.time = 0.0f;
-            }
-        }
+    // (time-based fading derives opacity from particle age at draw time)
+    if (g_config.fadeMode == FADE_FRAME) {
+        m_particles.Fade(g_config.fadeRate);
     }
+
+    // Drop faded out particles so drawing only visits the live window
+    m_particles.Expire(g_config.fadeMode, m_currentTime);
 }
 
-void WindowsOverlay::AddTrailPart(const TrailPart& part)
+bool WindowsOverlay::IsIdle() const
 {
-    m_trailParts[m_currentIndex] = part;
-    m_currentIndex = (m_currentIndex + 1) % g_config.maxParticles;
+    // A parked head stays under the resting cursor without changing
+    return !m_cursorMoved && m_particles.LiveCount() <= (m_headParked ? 1u : 0u);
+}
+
+void WindowsOverlay::WaitForActivity(bool idle, DWORD frameWaitMs)
+{
+    // The hook is only installed while idle, when this thread waits and can answer it at once
+    if (idle && !m_mouseHook) {
+        m_mouseHook = SetWindowsHookExW(WH_MOUSE_LL, MouseHookProc, GetModuleHandle(nullptr), 0);
+    } else if (!idle && m_mouseHook) {
+        UnhookWindowsHookEx(m_mouseHook);
+        m_mouseHook = nullptr;
+    }
+
+    // Without the hook an idle overlay keeps polling the cursor once per frame
+    DWORD timeout = (idle && m_mouseHook) ? IdleWaitMs : frameWaitMs;
+    MsgWaitForMultipleObjectsEx(0, nullptr, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+}
+
+LRESULT CALLBACK WindowsOverlay::MouseHookProc(int nCode, WPARAM wParam, LPARAM lParam)
+{
+    // Delivering the hook call already ends the message wait, nothing else to do
+    return CallNextHookEx(nullptr, nCode, wParam, lParam);
 }
 
 void WindowsOverlay::Render()
 {
     if (!m_hwnd || !m_memDC) return;
 
-    // Clear the memory DC with fully transparent pixels using Graphics
-    Graphics clearGraphics(m_memDC);
-    clearGraphics.Clear(Color(0, 0, 0, 0)); // Fully transparent
+    // In bounding-window mode the window follows the trail, a new size gets a new DIB
+    if (g_config.boundingWindow) {
+        float bounds[4];
+        bool any = m_particles.Bounds(g_config.fadeMode, m_currentTime, bounds);
+        if (m_trailWindow.Update(any, bounds, g_config.spriteSize)) {
+            const DamageRect& rect = m_trailWindow.Rect();
+            if (rect.width != m_window.width || rect.height != m_window.height) {
+                ResizeSurface(rect);
+            } else {
+                m_window = rect;
+                m_damage.Resize(rect.width, rect.height, rect.x, rect.y);
+            }
+        }
+    }
+
+    // Only the area the trail covered last frame or covers now changes. The
+    // DIB keeps its pixels between frames, which is a buffer age of one.
+    m_damage.Update(m_particles, g_config.fadeMode, m_currentTime, g_config.spriteSize);
+    DamageRect region = m_damage.DamageForAge(1);
+    g_stats.frame.pixelsRepainted += static_cast<unsigned long long>(region.width) * region.height;
+    if (region.Empty()) {
+        return;
+    }
 
-    // Draw trail using GDI+
+    // Clear the damaged part of the memory DC with fully transparent pixels and redraw it
     Graphics graphics(m_memDC);
+    graphics.SetClip(Rect(region.x, region.y, region.width, region.height));
+    graphics.Clear(Color(0, 0, 0, 0)); // Fully transparent
     graphics.SetSmoothingMode(SmoothingModeAntiAlias);
     graphics.SetCompositingMode(CompositingModeSourceOver);
     graphics.SetCompositingQuality(CompositingQualityHighQuality);
     
+    // Particles are in screen coordinates, the DIB starts at the window origin
+    graphics.TranslateTransform(static_cast<REAL>(-m_window.x), static_cast<REAL>(-m_window.y));
+    
     DrawTrail(graphics);
 
-    // Update the layered window
+    // Update the layered window, telling DWM which part changed
+    POINT ptDst = { m_window.x, m_window.y };
     POINT ptSrc = { 0, 0 };
-    SIZE sizeWnd = { m_screenWidth, m_screenHeight };
+    SIZE sizeWnd = { m_window.width, m_window.height };
     BLENDFUNCTION bf = {};
     bf.BlendOp = AC_SRC_OVER;
     bf.BlendFlags = 0;
     bf.SourceConstantAlpha = 255;
     bf.AlphaFormat = AC_SRC_ALPHA;
+    RECT dirty = { region.x, region.y, region.x + region.width, region.y + region.height };
 
-    UpdateLayeredWindow(m_hwnd, nullptr, nullptr, &sizeWnd, m_memDC, &ptSrc, RGB(0, 0, 0), &bf, ULW_ALPHA);
+    UPDATELAYEREDWINDOWINFO info = {};
+    info.cbSize = sizeof(info);
+    info.pptDst = &ptDst;
+    info.psize = &sizeWnd;
+    info.hdcSrc = m_memDC;
+    info.pptSrc = &ptSrc;
+    info.crKey = RGB(0, 0, 0);
+    info.pblend = &bf;
+    info.dwFlags = ULW_ALPHA;
+    info.prcDirty = &dirty;
+    UpdateLayeredWindowIndirect(m_hwnd, &info);
 }
 
 void WindowsOverlay::DrawTrail(Graphics& graphics)
 {
     int drawnCount = 0;
-    for (const auto& part : m_trailParts) {
-        if (part.time > 0.0f) {
+    const float* xs = m_particles.Attribute(PARTICLE_X);
+    const float* ys = m_particles.Attribute(PARTICLE_Y);
+    // Live particles are contiguous from the oldest one, possibly wrapping
+    for (unsigned int n = 0; n < m_particles.LiveCount(); ++n) {
+        unsigned int i = (m_particles.Tail() + n) % m_particles.Capacity();
+        float partAlpha = m_particles.AlphaAt(i, g_config.fadeMode, m_currentTime);
+        if (partAlpha > 0.0f) {
             // Calculate alpha to match OpenGL version exactly (use time directly as alpha)
-            float alpha = (std::max)(0.0f, (std::min)(1.0f, part.time));
+            float alpha = (std::max)(0.0f, (std::min)(1.0f, partAlpha));
             
             // Use configurable sprite size
             float spriteSize = g_config.spriteSize;
@@ -281,8 +367,8 @@ void WindowsOverlay::DrawTrail(Graphics& graphics)
             // Draw the trail sprite at fixed size (same as OpenGL version)
             // Position sprite centered on the trail point
             RectF destRect(
-                part.x - spriteSize / 2.0f,
-                part.y - spriteSize / 2.0f,
+                xs[i] - spriteSize / 2.0f,
+                ys[i] - spriteSize / 2.0f,
                 spriteSize,
                 spriteSize
             );
@@ -311,6 +397,11 @@ void WindowsOverlay::DrawTrail(Graphics& graphics)
 
 void WindowsOverlay::Cleanup()
 {
+    if (m_mouseHook) {
+        UnhookWindowsHookEx(m_mouseHook);
+        m_mouseHook = nullptr;
+    }
+    
     if (m_hOldBitmap && m_memDC) {
         SelectObject(m_memDC, m_hOldBitmap);
         m_hOldBitmap = nullptr;
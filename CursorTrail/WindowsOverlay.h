@@ -14,7 +14,14 @@
 #include <vector>
 #include <memory>
 #include "TrailPart.h"
+#include "ParticleStore.h"
+#include "TrailEmitter.h"
+#include "CursorFilter.h"
 #include "Config.h"
+#include "Clock.h"
+#include "DamageTracker.h"
+#include "BoundingWindow.h"
+#include "CursorTrace.h"
 
 // Windows-specific overlay implementation for guaranteed top-level transparent overlay
 class WindowsOverlay
@@ -24,16 +31,27 @@ public:
     ~WindowsOverlay();
     
     bool Initialize();
-    void Update();
+    // Advances the trail to the sample's time and cursor position
+    void Update(const CursorSample& sample);
     void Render();
     void Cleanup();
     
     bool IsActive() const { return m_hwnd != nullptr; }
+    // True once the trail has faded out and the cursor rests
+    bool IsIdle() const;
+    // Blocks until a message arrives or frameWaitMs pass. While idle a
+    // low-level mouse hook wakes the wait on cursor motion instead.
+    void WaitForActivity(bool idle, DWORD frameWaitMs);
+    
+    // Safety wake-up while idle, for cursor moves that bypass the mouse hook
+    static const DWORD IdleWaitMs = 500;
     
 private:
     static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+    static LRESULT CALLBACK MouseHookProc(int nCode, WPARAM wParam, LPARAM lParam);
     void DrawTrail(Gdiplus::Graphics& graphics);
-    void AddTrailPart(const TrailPart& part);
+    // (Re)creates the DIB for a window covering the given screen rectangle
+    bool ResizeSurface(const DamageRect& rect);
     
     HWND m_hwnd;
     HDC m_hdc;
@@ -43,9 +61,20 @@ private:
     
     int m_screenWidth;
     int m_screenHeight;
+    DamageRect m_window;            // Screen rectangle covered by the window and its DIB
+    BoundingWindow m_trailWindow;   // Window placement in bounding-window mode
     
-    std::vector<TrailPart> m_trailParts;
-    size_t m_currentIndex;
+    ParticleStore m_particles;
+    TrailEmitter m_emitter;
+    CursorFilter m_filter;
+    Clock m_clock;
+    float m_currentTime;
+    DamageTracker m_damage;
+    CursorSample m_lastCursor;
+    bool m_hasCursor;
+    bool m_cursorMoved;
+    bool m_headParked;                      // the newest particle is the head under the resting cursor
+    HHOOK m_mouseHook;
     
     std::unique_ptr<Gdiplus::Bitmap> m_trailTexture;
     ULONG_PTR m_gdiplusToken;
@@ -0,0 +1,89 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+
+WorkerPool::WorkerPool(unsigned int threads)
+    : call(nullptr), task(nullptr), count(0), next(0), generation(0), busy(0), stopping(false)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 1; i < threads; i++) {
+        this->workers.emplace_back(&WorkerPool::work, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (std::thread& worker : this->workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::run(unsigned int count, Invoke call, const void* task)
+{
+    if (this->workers.empty() || count <= 1) {
+        for (unsigned int i = 0; i < count; i++) {
+            call(task, i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->call = call;
+        this->task = task;
+        this->count = count;
+        this->next.store(0, std::memory_order_relaxed);
+        this->busy = static_cast<unsigned int>(this->workers.size());
+        this->generation++;
+    }
+    this->wake.notify_all();
+
+    this->runIndices();
+
+    // the task must outlive every worker still finishing an index
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->finished.wait(lock, [this]() { return this->busy == 0; });
+    this->task = nullptr;
+}
+
+void WorkerPool::work()
+{
+    unsigned long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wake.wait(lock, [&]() { return this->stopping || this->generation != seen; });
+            if (this->stopping) {
+                return;
+            }
+            seen = this->generation;
+        }
+
+        this->runIndices();
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->busy--;
+        }
+        this->finished.notify_one();
+    }
+}
+
+void WorkerPool::runIndices()
+{
+    for (;;) {
+        unsigned int index = this->next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= this->count) {
+            return;
+        }
+        this->call(this->task, index);
+    }
+}
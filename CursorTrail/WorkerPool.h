@@ -0,0 +1,53 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads running the iterations of parallel loops. Every
+// thread takes the next unclaimed index until none is left, so uneven
+// iterations balance themselves. The calling thread works along, a pool
+// of one thread runs the loop inline.
+class WorkerPool
+{
+public:
+    // 0 threads uses one per hardware thread
+    explicit WorkerPool(unsigned int threads = 0);
+    ~WorkerPool();
+    // threads working on a loop, including the caller
+    unsigned int Threads() const { return static_cast<unsigned int>(this->workers.size()) + 1; }
+    // calls task(index) for every index below count and returns once all
+    // are done. The task is only referenced, nothing is allocated per loop
+    template <typename Task>
+    void         Run(unsigned int count, const Task& task)
+    {
+        this->run(count, &WorkerPool::invoke<Task>, &task);
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+private:
+    // a task without its type: the callable and how to call it
+    typedef void (*Invoke)(const void* task, unsigned int index);
+    template <typename Task>
+    static void invoke(const void* task, unsigned int index) { (*static_cast<const Task*>(task))(index); }
+
+    std::vector<std::thread>               workers;
+    std::mutex                             mutex;
+    std::condition_variable                wake;        // a loop was started or the pool stops
+    std::condition_variable                finished;    // a worker is done with the loop
+    Invoke                                 call;
+    const void*                            task;
+    unsigned int                           count;
+    std::atomic<unsigned int>              next;        // next unclaimed index
+    unsigned long long                     generation;  // loops started so far
+    unsigned int                           busy;        // workers still in the current loop
+    bool                                   stopping;
+    void run(unsigned int count, Invoke call, const void* task);
+    void work();
+    void runIndices();
+};
+
+#endif
@@ -0,0 +1,179 @@
+#ifdef CURSORTRAIL_X11
+
+#include "X11Input.h"
+#include "Clock.h"
+#include "Config.h"
+
+#ifdef CURSORTRAIL_XINPUT2
+#include <X11/extensions/XInput2.h>
+#endif
+#include <poll.h>
+#include <unistd.h>
+
+#include <iostream>
+
+
+X11InputSource::X11InputSource()
+    : display(nullptr)
+    , xiOpcode(0)
+    , stopping(false)
+{
+    this->stopPipe[0] = -1;
+    this->stopPipe[1] = -1;
+}
+
+X11InputSource::~X11InputSource()
+{
+    this->Stop();
+}
+
+bool X11InputSource::Start()
+{
+    // Xlib connections are not shared between threads, the thread gets its own
+    this->display = XOpenDisplay(nullptr);
+    if (!this->display) {
+        return false;
+    }
+    if (pipe(this->stopPipe) != 0) {
+        XCloseDisplay(this->display);
+        this->display = nullptr;
+        return false;
+    }
+    // Without raw motion the thread would have to poll; reading the pointer
+    // once per frame is cheaper. The first position is queued before Start()
+    // returns, so the trail never starts from a made-up one
+    if (!this->selectRawMotion() || !this->sample()) {
+        std::cout << "Cursor input: no XInput2 raw motion, reading the pointer once per frame" << std::endl;
+        this->Stop();
+        return false;
+    }
+    std::cout << "Cursor input: XInput2 raw motion on an input thread" << std::endl;
+
+    this->stopping = false;
+    this->thread = std::thread(&X11InputSource::run, this);
+    return true;
+}
+
+void X11InputSource::Stop()
+{
+    if (this->thread.joinable()) {
+        this->stopping = true;
+        char wake = 0;
+        if (write(this->stopPipe[1], &wake, 1) < 0) {
+            // the thread still sees stopping at its next wakeup
+        }
+        this->thread.join();
+    }
+    if (this->Dropped() > 0) {
+        std::cout << "Cursor input: " << this->Dropped() << " samples dropped by a full queue" << std::endl;
+    }
+    for (int& fd : this->stopPipe) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (this->display) {
+        XCloseDisplay(this->display);
+        this->display = nullptr;
+    }
+}
+
+bool X11InputSource::selectRawMotion()
+{
+#ifdef CURSORTRAIL_XINPUT2
+    int event, error;
+    if (!XQueryExtension(this->display, "XInputExtension", &this->xiOpcode, &event, &error)) {
+        return false;
+    }
+    // Raw events reach the root window of every client since XInput 2.0,
+    // whichever window the pointer is over
+    int major = 2, minor = 0;
+    if (XIQueryVersion(this->display, &major, &minor) != Success) {
+        return false;
+    }
+    unsigned char bits[XIMaskLen(XI_LASTEVENT)] = {};
+    XISetMask(bits, XI_RawMotion);
+    XIEventMask mask;
+    mask.deviceid = XIAllMasterDevices;
+    mask.mask_len = sizeof(bits);
+    mask.mask = bits;
+    XISelectEvents(this->display, DefaultRootWindow(this->display), &mask, 1);
+    XFlush(this->display);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void X11InputSource::run()
+{
+    while (!this->stopping) {
+        // Sleep until the server reports motion, then read the position
+        // once for everything that arrived together
+        if (!this->wait(-1)) {
+            break;
+        }
+        bool moved = false;
+        while (XPending(this->display)) {
+            XEvent event;
+            XNextEvent(this->display, &event);
+            // raw motion is the only XInput event selected
+            if (event.xcookie.type == GenericEvent && event.xcookie.extension == this->xiOpcode) {
+                moved = true;
+            }
+        }
+        if (moved) {
+            this->sample();
+        }
+    }
+}
+
+bool X11InputSource::wait(int timeoutMs)
+{
+    // events Xlib already read from the socket would not wake poll()
+    if (XPending(this->display) > 0) {
+        return !this->stopping;
+    }
+    pollfd fds[2] = {};
+    fds[0].fd = ConnectionNumber(this->display);
+    fds[0].events = POLLIN;
+    fds[1].fd = this->stopPipe[0];
+    fds[1].events = POLLIN;
+    poll(fds, 2, timeoutMs);
+    return !this->stopping;
+}
+
+bool X11InputSource::sample()
+{
+    Window root, child;
+    int rootX, rootY, windowX, windowY;
+    unsigned int mask;
+    // an unreadable pointer (on another screen) keeps its last position
+    if (!XQueryPointer(this->display, DefaultRootWindow(this->display), &root, &child, &rootX, &rootY, &windowX, &windowY, &mask)) {
+        return false;
+    }
+    double time = Clock::Seconds();
+    if (this->produced.time > 0.0 && rootX == this->produced.x && rootY == this->produced.y) {
+        return true;
+    }
+    this->produced = CursorSample(time, rootX, rootY);
+    this->Queue(this->produced);
+    return true;
+}
+
+
+std::unique_ptr<X11InputSource> StartX11InputSource()
+{
+    // a replay reads no pointer
+    if (!g_config.inputThread || !g_config.replayTrace.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<X11InputSource> source(new X11InputSource());
+    if (!source->Start()) {
+        return nullptr;
+    }
+    return source;
+}
+
+#endif // CURSORTRAIL_X11
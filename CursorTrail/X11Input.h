@@ -0,0 +1,51 @@
+#ifndef X11_INPUT_H
+#define X11_INPUT_H
+
+#ifdef CURSORTRAIL_X11
+
+#include <X11/Xlib.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "QueuedCursorSource.h"
+
+// The global X pointer read on a thread of its own, over a connection of
+// its own. The thread sleeps until the server reports XInput2 raw motion
+// on any device, then reads the pointer position. Every new position is
+// timestamped when it is read and queued, and the simulation drains the
+// queue once per frame or simulation step, so it sees the path between
+// them and spends no round trips on a resting pointer. A full queue drops
+// new positions, see QueuedCursorSource. Without XInput2 the thread
+// would have to poll the pointer and wake more often than the render
+// loop, so it does not start.
+class X11InputSource : public QueuedCursorSource
+{
+public:
+    X11InputSource();
+    ~X11InputSource();
+    // opens the connection, queues the current pointer position and starts
+    // the thread; false without an X display, XInput2 or a readable pointer
+    bool Start();
+    void Stop();
+private:
+    Display*                display;
+    int                     stopPipe[2];    // Stop() writes here to end a blocking wait
+    int                     xiOpcode;
+    std::thread             thread;
+    std::atomic<bool>       stopping;
+    CursorSample            produced;       // last sample queued, owned by the thread once it runs
+    bool selectRawMotion();
+    void run();
+    // waits for X events, at most timeoutMs (-1 = forever); false once stopping
+    bool wait(int timeoutMs);
+    // reads the pointer and queues it when it moved, false when it is unreadable
+    bool sample();
+};
+
+// The threaded source when the configuration asks for it and it starts,
+// null otherwise; the render loops then read the pointer once per frame
+std::unique_ptr<X11InputSource> StartX11InputSource();
+
+#endif // CURSORTRAIL_X11
+
+#endif // X11_INPUT_H
@@ -0,0 +1,671 @@
+#ifdef CURSORTRAIL_X11
+
+#include "X11Overlay.h"
+#include "Stats.h"
+
+#include <X11/Xproto.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/shmproto.h>
+#ifdef CURSORTRAIL_XRENDER
+#include <X11/extensions/renderproto.h>
+#endif
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <poll.h>
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+
+namespace
+{
+    // XShmAttach fails asynchronously, on remote displays for example;
+    // Xlib's default handler would end the process
+    bool g_shmAttachFailed = false;
+
+    int CatchShmError(Display*, XErrorEvent*)
+    {
+        g_shmAttachFailed = true;
+        return 0;
+    }
+}
+
+X11Overlay::X11Overlay()
+    : m_display(nullptr)
+    , m_window(0)
+    , m_colormap(0)
+    , m_gc(nullptr)
+    , m_visual(nullptr)
+    , m_image(nullptr)
+    , m_shm()
+    , m_useShm(false)
+    , m_useRender(false)
+#ifdef CURSORTRAIL_XRENDER
+    , m_windowPicture(0)
+    , m_backPixmap(0)
+    , m_backPicture(0)
+    , m_spritePicture(0)
+    , m_spritePictureSize(0)
+#endif
+    , m_fullRepaint(true)
+    , m_currentTime(0.0f)
+    , m_lastCursor()
+    , m_hasCursor(false)
+    , m_cursorMoved(true)
+    , m_headParked(false)
+    , m_simulated(false)
+{
+    m_particles.Resize(g_config.maxParticles);
+}
+
+X11Overlay::~X11Overlay()
+{
+    Cleanup();
+}
+
+bool X11Overlay::Initialize()
+{
+    m_display = XOpenDisplay(nullptr);
+    if (!m_display) {
+        std::cerr << "Failed to open the X display" << std::endl;
+        return false;
+    }
+    int screen = DefaultScreen(m_display);
+    Window root = RootWindow(m_display, screen);
+
+    // Per-pixel transparency needs a visual with an alpha channel
+    XVisualInfo visualInfo;
+    if (!XMatchVisualInfo(m_display, screen, 32, TrueColor, &visualInfo)) {
+        std::cerr << "The X server has no 32-bit ARGB visual" << std::endl;
+        Cleanup();
+        return false;
+    }
+    m_visual = visualInfo.visual;
+
+    // A screen-sized window that takes the clicks would lock up the desktop
+    int shapeEvent, shapeError;
+    if (!XShapeQueryExtension(m_display, &shapeEvent, &shapeError)) {
+        std::cerr << "The X server has no SHAPE extension for a click-through window" << std::endl;
+        Cleanup();
+        return false;
+    }
+
+    // Shared memory images are written in the client's byte order as they are
+    m_useShm = XShmQueryExtension(m_display) && ImageByteOrder(m_display) == LSBFirst;
+    if (!m_useShm) {
+        std::cout << "MIT-SHM is not available, frames are sent through the X connection" << std::endl;
+    }
+
+    // The window covers the screen, or only the trail in bounding-window mode
+    DamageRect window(0, 0, DisplayWidth(m_display, screen), DisplayHeight(m_display, screen));
+    if (g_config.boundingWindow) {
+        m_trailWindow.SetScreen(window);
+        window = m_trailWindow.Rect();
+    }
+
+    m_colormap = XCreateColormap(m_display, root, m_visual, AllocNone);
+    XSetWindowAttributes attributes = {};
+    attributes.override_redirect = True;    // no window manager decorations, focus or placement
+    attributes.colormap = m_colormap;
+    attributes.border_pixel = 0;
+    attributes.background_pixel = 0;        // transparent
+    attributes.event_mask = ExposureMask | VisibilityChangeMask;
+    m_window = XCreateWindow(m_display, root, window.x, window.y, window.width, window.height, 0,
+                             visualInfo.depth, InputOutput, m_visual,
+                             CWOverrideRedirect | CWColormap | CWBorderPixel | CWBackPixel | CWEventMask, &attributes);
+    if (!m_window) {
+        std::cerr << "Failed to create overlay window" << std::endl;
+        Cleanup();
+        return false;
+    }
+    XStoreName(m_display, m_window, "Cursor Trail");
+
+    // An empty input region passes every click to the windows below
+    XShapeCombineRectangles(m_display, m_window, ShapeInput, 0, 0, nullptr, 0, ShapeSet, Unsorted);
+
+    m_gc = XCreateGC(m_display, m_window, 0, nullptr);
+#ifdef CURSORTRAIL_XRENDER
+    m_useRender = g_config.x11Backend == X11_RENDER && InitializeRender();
+#else
+    if (g_config.x11Backend == X11_RENDER) {
+        std::cout << "This build has no XRender backend, compositing on the CPU" << std::endl;
+    }
+#endif
+    if (!ResizeSurface(window)) {
+        std::cerr << "Failed to create overlay image" << std::endl;
+        Cleanup();
+        return false;
+    }
+    LoadSprite();
+
+    XMapRaised(m_display, m_window);
+    XFlush(m_display);
+
+    std::cout << "X11 overlay window created and shown successfully!" << std::endl;
+    std::cout << "Screen size: " << DisplayWidth(m_display, screen) << "x" << DisplayHeight(m_display, screen)
+              << ", compositing: " << (m_useRender ? "XRender" : m_useShm ? "CPU + MIT-SHM" : "CPU") << std::endl;
+    return true;
+}
+
+void X11Overlay::LoadSprite()
+{
+    // Try the configured path, then the file name next to the binary and the sources
+    std::string baseName = g_config.texturePath;
+    size_t lastSlash = baseName.find_last_of("\\/");
+    if (lastSlash != std::string::npos) {
+        baseName = baseName.substr(lastSlash + 1);
+    }
+    const std::string paths[] = { g_config.texturePath, baseName, "CursorTrail/" + baseName, "../CursorTrail/" + baseName };
+
+    for (const std::string& path : paths) {
+        int width, height, channels;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+        if (data) {
+            m_compositor.SetSprite(data, width, height);
+            stbi_image_free(data);
+            std::cout << "Successfully loaded " << path << " texture (" << width << "x" << height << ")" << std::endl;
+            return;
+        }
+    }
+
+    // Fallback: a white circle the size of the original 8x8 texture
+    std::cout << "Failed to load " << g_config.texturePath << " from all paths, creating fallback texture" << std::endl;
+    const int textureSize = 8;
+    std::vector<unsigned char> circle(textureSize * textureSize * 4, 255);
+    for (int y = 0; y < textureSize; y++) {
+        for (int x = 0; x < textureSize; x++) {
+            float dx = x + 0.5f - textureSize * 0.5f;
+            float dy = y + 0.5f - textureSize * 0.5f;
+            float coverage = std::min(1.0f, std::max(0.0f, textureSize * 0.5f - std::sqrt(dx * dx + dy * dy) + 0.5f));
+            circle[(y * textureSize + x) * 4 + 3] = static_cast<unsigned char>(coverage * 255.0f);
+        }
+    }
+    m_compositor.SetSprite(circle.data(), textureSize, textureSize);
+}
+
+bool X11Overlay::ResizeSurface(const DamageRect& rect)
+{
+    DestroySurface();
+#ifdef CURSORTRAIL_XRENDER
+    bool created = m_useRender ? CreatePictures(rect) : CreateImage(rect);
+#else
+    bool created = CreateImage(rect);
+#endif
+    if (!created) {
+        return false;
+    }
+
+    if (m_rect.width != rect.width || m_rect.height != rect.height || m_rect.x != rect.x || m_rect.y != rect.y) {
+        XMoveResizeWindow(m_display, m_window, rect.x, rect.y, rect.width, rect.height);
+    }
+    m_rect = rect;
+    m_damage.Resize(rect.width, rect.height, rect.x, rect.y);
+    m_previousTiles.clear();
+    m_fullRepaint = true;
+    return true;
+}
+
+bool X11Overlay::CreateImage(const DamageRect& rect)
+{
+    if (m_useShm) {
+        m_image = XShmCreateImage(m_display, m_visual, 32, ZPixmap, nullptr, &m_shm, rect.width, rect.height);
+        if (m_image) {
+            m_shm.shmid = shmget(IPC_PRIVATE, static_cast<size_t>(m_image->bytes_per_line) * rect.height, IPC_CREAT | 0600);
+            m_shm.shmaddr = m_shm.shmid >= 0 ? static_cast<char*>(shmat(m_shm.shmid, nullptr, 0)) : reinterpret_cast<char*>(-1);
+            m_shm.readOnly = False;
+            bool attached = false;
+            if (m_shm.shmaddr != reinterpret_cast<char*>(-1)) {
+                g_shmAttachFailed = false;
+                XErrorHandler previous = XSetErrorHandler(CatchShmError);
+                attached = XShmAttach(m_display, &m_shm);
+                XSync(m_display, False);
+                XSetErrorHandler(previous);
+                attached = attached && !g_shmAttachFailed;
+            }
+            if (attached) {
+                m_image->data = m_shm.shmaddr;
+            }
+            else {
+                if (m_shm.shmaddr != reinterpret_cast<char*>(-1)) {
+                    shmdt(m_shm.shmaddr);
+                }
+                XDestroyImage(m_image);
+                m_image = nullptr;
+            }
+            // the segment goes away with the last detach, even when the process dies
+            if (m_shm.shmid >= 0) {
+                shmctl(m_shm.shmid, IPC_RMID, nullptr);
+            }
+        }
+        if (!m_image) {
+            std::cout << "MIT-SHM image creation failed, frames are sent through the X connection" << std::endl;
+            m_useShm = false;
+        }
+    }
+    if (!m_image) {
+        m_pixels.assign(static_cast<size_t>(rect.width) * rect.height * 4, 0);
+        m_image = XCreateImage(m_display, m_visual, 32, ZPixmap, 0, reinterpret_cast<char*>(m_pixels.data()),
+                               rect.width, rect.height, 32, rect.width * 4);
+        if (!m_image) {
+            return false;
+        }
+        // the compositor writes BGRA bytes, Xlib swaps them for other servers
+        m_image->byte_order = LSBFirst;
+    }
+    m_compositor.SetTarget(m_image->data, rect.width, rect.height, m_image->bytes_per_line);
+    m_compositor.Clear(DamageRect(0, 0, rect.width, rect.height));
+    return true;
+}
+
+#ifdef CURSORTRAIL_XRENDER
+bool X11Overlay::InitializeRender()
+{
+    int renderEvent, renderError;
+    if (!XRenderQueryExtension(m_display, &renderEvent, &renderError)) {
+        std::cout << "The X server has no RENDER extension, compositing on the CPU" << std::endl;
+        return false;
+    }
+    XRenderPictFormat* windowFormat = XRenderFindVisualFormat(m_display, m_visual);
+    XRenderPictFormat* argbFormat = XRenderFindStandardFormat(m_display, PictStandardARGB32);
+    XRenderPictFormat* alphaFormat = XRenderFindStandardFormat(m_display, PictStandardA8);
+    if (!windowFormat || !argbFormat || !alphaFormat) {
+        std::cout << "The X server lacks the picture formats for XRender, compositing on the CPU" << std::endl;
+        return false;
+    }
+    m_windowPicture = XRenderCreatePicture(m_display, m_window, windowFormat, 0, nullptr);
+
+    // One repeating 1x1 alpha mask per fade level scales the sprite by the particle opacity
+    XRenderPictureAttributes repeat = {};
+    repeat.repeat = RepeatNormal;
+    m_fadeMasks.resize(FadeLevels + 1);
+    for (int level = 1; level <= FadeLevels; level++) {
+        Pixmap pixmap = XCreatePixmap(m_display, m_window, 1, 1, 8);
+        m_fadeMasks[level] = XRenderCreatePicture(m_display, pixmap, alphaFormat, CPRepeat, &repeat);
+        XFreePixmap(m_display, pixmap);
+        XRenderColor alpha = {};
+        alpha.alpha = static_cast<unsigned short>(level * 65535 / FadeLevels);
+        XRenderFillRectangle(m_display, PictOpSrc, m_fadeMasks[level], &alpha, 0, 0, 1, 1);
+    }
+    return true;
+}
+
+bool X11Overlay::CreatePictures(const DamageRect& rect)
+{
+    // Frames are drawn into a back pixmap and copied to the window once complete
+    m_backPixmap = XCreatePixmap(m_display, m_window, rect.width, rect.height, 32);
+    m_backPicture = XRenderCreatePicture(m_display, m_backPixmap, XRenderFindStandardFormat(m_display, PictStandardARGB32), 0, nullptr);
+    XRenderColor transparent = {};
+    XRenderFillRectangle(m_display, PictOpSrc, m_backPicture, &transparent, 0, 0, rect.width, rect.height);
+    return m_backPicture != 0;
+}
+
+void X11Overlay::UploadSprite(int size)
+{
+    if (m_spritePicture && m_spritePictureSize == size) {
+        return;
+    }
+    if (m_spritePicture) {
+        XRenderFreePicture(m_display, m_spritePicture);
+        m_spritePicture = 0;
+    }
+    const uint32_t* pixels = m_compositor.ResampledSprite(size);
+    if (!pixels) {
+        return;
+    }
+
+    // The only pixel upload: the premultiplied sprite at its drawn size
+    Pixmap pixmap = XCreatePixmap(m_display, m_window, size, size, 32);
+    XImage* image = XCreateImage(m_display, m_visual, 32, ZPixmap, 0, reinterpret_cast<char*>(const_cast<uint32_t*>(pixels)),
+                                 size, size, 32, size * 4);
+    image->byte_order = LSBFirst;
+    GC gc = XCreateGC(m_display, pixmap, 0, nullptr);
+    XPutImage(m_display, pixmap, gc, image, 0, 0, 0, 0, size, size);
+    XFreeGC(m_display, gc);
+    image->data = nullptr;
+    XDestroyImage(image);
+    g_stats.frame.xRequestBytes += sz_xPutImageReq + static_cast<unsigned long long>(size) * size * 4;
+
+    m_spritePicture = XRenderCreatePicture(m_display, pixmap, XRenderFindStandardFormat(m_display, PictStandardARGB32), 0, nullptr);
+    XFreePixmap(m_display, pixmap);
+    m_spritePictureSize = size;
+}
+#endif
+
+void X11Overlay::DestroySurface()
+{
+#ifdef CURSORTRAIL_XRENDER
+    if (m_backPicture) {
+        XRenderFreePicture(m_display, m_backPicture);
+        XFreePixmap(m_display, m_backPixmap);
+        m_backPicture = 0;
+        m_backPixmap = 0;
+    }
+#endif
+    if (!m_image) {
+        return;
+    }
+    if (m_useShm) {
+        XShmDetach(m_display, &m_shm);
+        XSync(m_display, False);
+        shmdt(m_shm.shmaddr);
+    }
+    // the pixels are not Xlib's to free
+    m_image->data = nullptr;
+    XDestroyImage(m_image);
+    m_image = nullptr;
+}
+
+void X11Overlay::Update(const CursorSample& sample)
+{
+    if (!m_window) return;
+
+    // The sample clock drives the trail, replays run on recorded time
+    m_clock.SetTime(sample.time);
+    // Keep particle timestamps small so they stay precise as floats
+    float shift;
+    if (m_clock.Rebase(shift)) {
+        m_particles.ShiftSpawnTimes(shift);
+        m_emitter.ShiftTime(shift);
+    }
+    m_currentTime = m_clock.Now();
+    float lifetime = g_config.ParticleLifetime();
+
+    // Smooth out sensor jitter like Game::Update
+    CursorSample cursor = sample;
+    if (!m_filter.Apply(cursor.time, cursor.x, cursor.y, g_config.filterCutoff, g_config.filterBeta, g_config.deadZone)) {
+        g_stats.frame.spawnsSuppressed++;
+    }
+
+    // A resting cursor spawns nothing, the trail fades out and the overlay goes idle
+    m_cursorMoved = !m_hasCursor || cursor.x != m_lastCursor.x || cursor.y != m_lastCursor.y;
+    m_lastCursor = cursor;
+    m_hasCursor = true;
+
+    // Spawn particles every spawnFrequency pixels along the path like Game::Update
+    g_stats.frame.particlesSpawned += m_emitter.Move(m_particles, static_cast<float>(cursor.x), static_cast<float>(cursor.y),
+                                                     m_currentTime, g_config.pathMode, g_config.spawnFrequency, g_config.fadeTime, lifetime);
+    m_headParked = m_emitter.Parked();
+
+    // Drop faded out particles so drawing only visits the live window
+    m_particles.Expire(g_config.fadeMode, m_currentTime);
+}
+
+void X11Overlay::Show(TrailSnapshot& snapshot)
+{
+    m_particles.Swap(snapshot.particles);
+    m_currentTime = snapshot.time;
+    m_cursorMoved = !m_hasCursor || snapshot.cursor.x != m_lastCursor.x || snapshot.cursor.y != m_lastCursor.y;
+    m_lastCursor = snapshot.cursor;
+    m_hasCursor = true;
+    m_headParked = snapshot.parked;
+    m_simulated = true;
+}
+
+bool X11Overlay::IsIdle() const
+{
+    // A parked head stays under the resting cursor without changing
+    return !m_cursorMoved && m_particles.LiveCount() <= (m_headParked ? 1u : 0u);
+}
+
+void X11Overlay::WaitForActivity(int waitMs, int wakeFd)
+{
+    if (!XPending(m_display)) {
+        pollfd fds[2] = { { ConnectionNumber(m_display), POLLIN, 0 }, { wakeFd, POLLIN, 0 } };
+        poll(fds, wakeFd >= 0 ? 2 : 1, waitMs);
+    }
+    while (XPending(m_display)) {
+        XEvent event;
+        XNextEvent(m_display, &event);
+        if (event.type == Expose) {
+            m_fullRepaint = true;
+        }
+        else if (event.type == VisibilityNotify && event.xvisibility.state != VisibilityUnobscured) {
+            // Nothing keeps an unmanaged window on top, raise it again when covered
+            XRaiseWindow(m_display, m_window);
+        }
+    }
+}
+
+void X11Overlay::Render()
+{
+    if (!m_window || (!m_image && !m_useRender)) return;
+    unsigned long firstRequest = XNextRequest(m_display);
+
+    // Frame-based fading steps once per rendered frame, not per cursor sample
+    if (g_config.fadeMode == FADE_FRAME && !m_simulated) {
+        m_particles.Fade(g_config.fadeRate);
+        m_particles.Expire(g_config.fadeMode, m_currentTime);
+    }
+
+    // In bounding-window mode the window follows the trail, a new size gets a new surface
+    if (g_config.boundingWindow) {
+        float bounds[4];
+        bool any = m_particles.Bounds(g_config.fadeMode, m_currentTime, bounds);
+        if (m_trailWindow.Update(any, bounds, g_config.spriteSize)) {
+            const DamageRect& rect = m_trailWindow.Rect();
+            if (rect.width != m_rect.width || rect.height != m_rect.height) {
+                ResizeSurface(rect);
+            } else {
+                // The window content moves along, everything is drawn at new offsets
+                XMoveWindow(m_display, m_window, rect.x, rect.y);
+                m_rect = rect;
+                m_damage.Resize(rect.width, rect.height, rect.x, rect.y);
+                if (m_image) {
+                    m_compositor.Clear(DamageRect(0, 0, rect.width, rect.height));
+                }
+                m_previousTiles.clear();
+                m_fullRepaint = true;
+            }
+        }
+    }
+
+#ifdef CURSORTRAIL_XRENDER
+    if (m_useRender) {
+        ComposeRender();
+    }
+    else
+#endif
+    {
+        ComposeShm();
+    }
+    g_stats.frame.xRequests += XNextRequest(m_display) - firstRequest;
+}
+
+void X11Overlay::ComposeShm()
+{
+    // Erase the last frame where it was drawn and draw the trail again.
+    // The image keeps its pixels between frames, so only tiles that held
+    // sprites in either frame change.
+    for (const DamageRect& tile : m_previousTiles) {
+        m_compositor.Clear(tile);
+    }
+    DamageRect surface(0, 0, m_rect.width, m_rect.height);
+    m_compositor.Draw(m_particles, g_config.fadeMode, m_currentTime, g_config.spriteSize, m_rect.x, m_rect.y, surface);
+    const std::vector<DamageRect>& tiles = m_compositor.DrawnTiles();
+
+    if (m_fullRepaint) {
+        Put(surface);
+        m_fullRepaint = false;
+    }
+    else {
+        // Merge the tiles of both frames into runs along each tile row, one request per run
+        int tilesX = (m_rect.width + CpuCompositor::TileSize - 1) / CpuCompositor::TileSize;
+        int tilesY = (m_rect.height + CpuCompositor::TileSize - 1) / CpuCompositor::TileSize;
+        m_dirtyTiles.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+        const std::vector<DamageRect>* frames[] = { &m_previousTiles, &tiles };
+        for (const std::vector<DamageRect>* list : frames) {
+            for (const DamageRect& tile : *list) {
+                m_dirtyTiles[(tile.y / CpuCompositor::TileSize) * tilesX + tile.x / CpuCompositor::TileSize] = 1;
+            }
+        }
+        for (int ty = 0; ty < tilesY; ty++) {
+            for (int tx = 0; tx < tilesX; tx++) {
+                if (!m_dirtyTiles[ty * tilesX + tx]) {
+                    continue;
+                }
+                int first = tx;
+                while (tx + 1 < tilesX && m_dirtyTiles[ty * tilesX + tx + 1]) {
+                    tx++;
+                }
+                DamageRect run(first * CpuCompositor::TileSize, ty * CpuCompositor::TileSize,
+                               (tx + 1 - first) * CpuCompositor::TileSize, CpuCompositor::TileSize);
+                Put(run.Intersect(surface));
+            }
+        }
+    }
+    m_previousTiles = tiles;
+
+    // The server reads the shared image asynchronously; wait until it has
+    // so the next frame does not draw into pixels still being copied
+    XSync(m_display, False);
+    g_stats.frame.xRequestBytes += sz_xReq;
+    g_stats.frame.xRoundTrips++;
+}
+
+#ifdef CURSORTRAIL_XRENDER
+void X11Overlay::ComposeRender()
+{
+    int size = std::max(1, static_cast<int>(std::lround(g_config.spriteSize)));
+    UploadSprite(size);
+
+    // Only the area the trail covered last frame or covers now changes. The
+    // back pixmap keeps its pixels between frames, which is a buffer age of one.
+    m_damage.Update(m_particles, g_config.fadeMode, m_currentTime, g_config.spriteSize);
+    DamageRect region = m_fullRepaint ? m_damage.Surface() : m_damage.DamageForAge(1);
+    m_fullRepaint = false;
+    g_stats.frame.pixelsRepainted += static_cast<unsigned long long>(region.width) * region.height;
+    if (region.Empty() || !m_spritePicture) {
+        return;
+    }
+
+    // Clear the damaged part of the back pixmap and clip the sprites to it
+    XRenderColor transparent = {};
+    XRenderFillRectangle(m_display, PictOpSrc, m_backPicture, &transparent, region.x, region.y, region.width, region.height);
+    XRectangle clip = { static_cast<short>(region.x), static_cast<short>(region.y),
+                        static_cast<unsigned short>(region.width), static_cast<unsigned short>(region.height) };
+    XRenderSetPictureClipRectangles(m_display, m_backPicture, 0, 0, &clip, 1);
+    g_stats.frame.xRequestBytes += sz_xRenderFillRectanglesReq + sz_xRectangle
+                                 + sz_xRenderSetPictureClipRectanglesReq + sz_xRectangle;
+
+    // One small composite request per sprite, in spawn order; Xlib queues
+    // them in its output buffer and writes them to the socket in batches
+    unsigned int first[2], count[2];
+    unsigned int spans = m_particles.LiveSpans(first, count);
+    const float* xs = m_particles.Attribute(PARTICLE_X);
+    const float* ys = m_particles.Attribute(PARTICLE_Y);
+    for (unsigned int s = 0; s < spans; s++) {
+        for (unsigned int i = first[s]; i < first[s] + count[s]; i++) {
+            float alpha = std::min(1.0f, std::max(0.0f, m_particles.AlphaAt(i, g_config.fadeMode, m_currentTime)));
+            int level = static_cast<int>(alpha * FadeLevels + 0.5f);
+            if (level == 0) {
+                continue;
+            }
+            // same placement as CpuCompositor: nearest whole pixel to the centered sprite corner
+            int x = static_cast<int>(std::floor(xs[i] - size * 0.5f + 0.5f)) - m_rect.x;
+            int y = static_cast<int>(std::floor(ys[i] - size * 0.5f + 0.5f)) - m_rect.y;
+            if (DamageRect(x, y, size, size).Intersect(region).Empty()) {
+                continue;
+            }
+            XRenderComposite(m_display, PictOpOver, m_spritePicture, m_fadeMasks[level], m_backPicture,
+                             0, 0, 0, 0, x, y, size, size);
+            g_stats.frame.xRequestBytes += sz_xRenderCompositeReq;
+            g_stats.frame.spritesDrawn++;
+        }
+    }
+
+    // Copy the finished region to the window
+    XRenderComposite(m_display, PictOpSrc, m_backPicture, None, m_windowPicture,
+                     region.x, region.y, 0, 0, region.x, region.y, region.width, region.height);
+    g_stats.frame.xRequestBytes += sz_xRenderCompositeReq;
+    XFlush(m_display);
+}
+#endif
+
+void X11Overlay::Put(const DamageRect& rect)
+{
+    if (rect.Empty()) {
+        return;
+    }
+    g_stats.frame.pixelsRepainted += static_cast<unsigned long long>(rect.width) * rect.height;
+    if (m_useShm) {
+        XShmPutImage(m_display, m_window, m_gc, m_image, rect.x, rect.y, rect.x, rect.y, rect.width, rect.height, False);
+        g_stats.frame.xRequestBytes += sz_xShmPutImageReq;
+    }
+    else {
+        XPutImage(m_display, m_window, m_gc, m_image, rect.x, rect.y, rect.x, rect.y, rect.width, rect.height);
+        g_stats.frame.xRequestBytes += sz_xPutImageReq + static_cast<unsigned long long>(rect.width) * rect.height * 4;
+    }
+}
+
+void X11Overlay::Cleanup()
+{
+    if (!m_display) {
+        return;
+    }
+    DestroySurface();
+#ifdef CURSORTRAIL_XRENDER
+    for (Picture mask : m_fadeMasks) {
+        if (mask) {
+            XRenderFreePicture(m_display, mask);
+        }
+    }
+    m_fadeMasks.clear();
+    if (m_spritePicture) {
+        XRenderFreePicture(m_display, m_spritePicture);
+        m_spritePicture = 0;
+    }
+    if (m_windowPicture) {
+        XRenderFreePicture(m_display, m_windowPicture);
+        m_windowPicture = 0;
+    }
+#endif
+    if (m_gc) {
+        XFreeGC(m_display, m_gc);
+        m_gc = nullptr;
+    }
+    if (m_window) {
+        XDestroyWindow(m_display, m_window);
+        m_window = 0;
+    }
+    if (m_colormap) {
+        XFreeColormap(m_display, m_colormap);
+        m_colormap = 0;
+    }
+    XCloseDisplay(m_display);
+    m_display = nullptr;
+}
+
+
+X11CursorSource::X11CursorSource(Display* display)
+    : display(display)
+{
+}
+
+bool X11CursorSource::Next(CursorSample& sample)
+{
+    double xpos = this->last.x;
+    double ypos = this->last.y;
+
+    Window root, child;
+    int rootX, rootY, windowX, windowY;
+    unsigned int mask;
+    bool onScreen = XQueryPointer(this->display, DefaultRootWindow(this->display), &root, &child, &rootX, &rootY, &windowX, &windowY, &mask);
+    g_stats.frame.xRequests++;
+    g_stats.frame.xRequestBytes += sz_xResourceReq;
+    g_stats.frame.xRoundTrips++;
+    if (onScreen) {
+        xpos = rootX;
+        ypos = rootY;
+    }
+
+    // an unreadable cursor (on another screen) keeps its last position
+    this->last = CursorSample(Clock::Seconds(), xpos, ypos);
+    sample = this->last;
+    return true;
+}
+
+#endif // CURSORTRAIL_X11
@@ -0,0 +1,130 @@
+#ifndef X11_OVERLAY_H
+#define X11_OVERLAY_H
+
+#ifdef CURSORTRAIL_X11
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#ifdef CURSORTRAIL_XRENDER
+#include <X11/extensions/Xrender.h>
+#endif
+#include <vector>
+#include "TrailPart.h"
+#include "ParticleStore.h"
+#include "TrailEmitter.h"
+#include "CursorFilter.h"
+#include "Config.h"
+#include "Clock.h"
+#include "BoundingWindow.h"
+#include "CpuCompositor.h"
+#include "CursorSource.h"
+#include "TrailSimulation.h"
+
+// Linux counterpart of WindowsOverlay: an override-redirect X11 window
+// with a 32-bit ARGB visual that lets clicks through with an empty XShape
+// input region. Frames are composited in one of two ways (x11Backend):
+//   X11_SHM:    on the CPU into an MIT-SHM image, only the tiles that
+//               changed are pushed with XShmPutImage. Displays without
+//               MIT-SHM (remote ones) get plain XPutImage.
+//   X11_RENDER: in the X server. The sprite is uploaded once as a
+//               premultiplied Picture and every particle is one
+//               XRenderComposite through a mask of its quantized fade
+//               level, so no pixels cross the socket per frame.
+// The window is only transparent under a compositing manager; it also
+// runs under Xvfb.
+class X11Overlay
+{
+public:
+    X11Overlay();
+    ~X11Overlay();
+
+    bool Initialize();
+    // Advances the trail to the sample's time and cursor position
+    void Update(const CursorSample& sample);
+    // Takes the trail of a simulation thread snapshot instead of running
+    // Update; the snapshot gets the previous trail in exchange
+    void Show(TrailSnapshot& snapshot);
+    void Render();
+    void Cleanup();
+
+    bool IsActive() const { return m_window != 0; }
+    // True once the trail has faded out and the cursor rests
+    bool IsIdle() const;
+    // Blocks until X events arrive, wakeFd turns readable or waitMs pass
+    // (-1 = forever), then handles the events. Without the input thread
+    // to wake it through wakeFd, an idle overlay still polls the cursor
+    // once per frame
+    void WaitForActivity(int waitMs, int wakeFd = -1);
+    Display* GetDisplay() const { return m_display; }
+
+private:
+    // (Re)creates the surface for a window covering the given screen rectangle
+    bool ResizeSurface(const DamageRect& rect);
+    bool CreateImage(const DamageRect& rect);
+    void DestroySurface();
+    void ComposeShm();
+    void LoadSprite();
+    // copies a rectangle of the image to the window
+    void Put(const DamageRect& rect);
+
+    Display* m_display;
+    Window m_window;
+    Colormap m_colormap;
+    GC m_gc;
+    Visual* m_visual;
+    XImage* m_image;
+    XShmSegmentInfo m_shm;
+    bool m_useShm;
+    std::vector<unsigned char> m_pixels;    // image memory without MIT-SHM
+    bool m_useRender;
+#ifdef CURSORTRAIL_XRENDER
+    // opacity steps of the XRender masks
+    static const int FadeLevels = 64;
+    bool InitializeRender();
+    bool CreatePictures(const DamageRect& rect);
+    // uploads the sprite resampled to size x size unless it already is
+    void UploadSprite(int size);
+    void ComposeRender();
+    Picture m_windowPicture;
+    Pixmap m_backPixmap;                    // frames are drawn here, then copied to the window
+    Picture m_backPicture;
+    Picture m_spritePicture;
+    int m_spritePictureSize;
+    std::vector<Picture> m_fadeMasks;       // 1x1 repeating A8 masks, index = fade level
+#endif
+
+    DamageRect m_rect;                      // Screen rectangle covered by the window and its image
+    BoundingWindow m_trailWindow;           // Window placement in bounding-window mode
+    bool m_fullRepaint;                     // the window content is unknown, push all of it
+    DamageTracker m_damage;                 // XRender damage, the back pixmap has a buffer age of one
+    std::vector<DamageRect> m_previousTiles; // tiles drawn in the last frame
+    std::vector<unsigned char> m_dirtyTiles; // per tile: pushed this frame
+
+    ParticleStore m_particles;
+    TrailEmitter m_emitter;
+    CursorFilter m_filter;
+    CpuCompositor m_compositor;
+    Clock m_clock;
+    float m_currentTime;
+    CursorSample m_lastCursor;
+    bool m_hasCursor;
+    bool m_cursorMoved;
+    bool m_headParked;                      // the newest particle is the head under the resting cursor
+    bool m_simulated;                       // the trail comes from Show, already faded
+};
+
+// The X pointer in root window coordinates, timestamped with the system clock
+class X11CursorSource : public CursorSource
+{
+public:
+    X11CursorSource(Display* display);
+    bool Next(CursorSample& sample) override;
+private:
+    Display*     display;
+    CursorSample last;
+};
+
+#endif // CURSORTRAIL_X11
+
+#endif // X11_OVERLAY_H
@@ -1,11 +1,11 @@
 #version 330 core
 in vec2 TexCoords;
+in float Alpha;
 out vec4 color;
 
 uniform sampler2D image;
-uniform float alpha;
 
 void main()
 {    
-    color = vec4(1.0, 1.0, 1.0, alpha) * texture(image, TexCoords);
-}  
\ No newline at end of file
+    color = vec4(1.0, 1.0, 1.0, Alpha) * texture(image, TexCoords);
+}  
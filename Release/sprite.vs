@@ -2,12 +2,15 @@
 layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
 
 out vec2 TexCoords;
+out float Alpha;
 
 uniform mat4 model;
 uniform mat4 projection;
+uniform float alpha;
 
 void main()
 {
     TexCoords = vertex.zw;
+    Alpha = alpha;
     gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
-}
\ No newline at end of file
+}
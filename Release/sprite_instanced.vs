@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec4 vertex;   // <vec2 position, vec2 texCoords>
+layout (location = 1) in vec4 instance; // <vec2 position, float size, float alpha>
+layout (location = 2) in vec2 lifespan; // <float spawnTime, float lifetime>
+
+out vec2 TexCoords;
+out float Alpha;
+
+uniform mat4 projection;
+uniform float time;
+uniform bool gpuFade;
+
+void main()
+{
+    TexCoords = vertex.zw;
+    Alpha = instance.w;
+    if (gpuFade)
+        Alpha *= lifespan.y > 0.0 ? clamp(1.0 - (time - lifespan.x) / lifespan.y, 0.0, 1.0) : 0.0;
+    gl_Position = projection * vec4(instance.xy + vertex.xy * instance.z, 0.0, 1.0);
+    // move faded out sprites behind the far plane so they are clipped before rasterization
+    if (Alpha <= 0.0)
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+}
@@ -0,0 +1,239 @@
+// Microbenchmark of the CpuCompositor against the approach of the GDI+
+// overlay it can replace: resampling and blending the straight-alpha
+// sprite in floating point for every particle. Both stamp the same trail
+// into a 1920x1080 BGRA32 surface; the largest channel difference of the
+// two images is printed as a check.
+// A second table shows how the tile-binned compositor scales from one
+// thread to all hardware threads on a 4K surface with the sprite size of
+// config-dense.ini. Every thread count must produce the same image.
+//
+// usage: cpu_compositor_bench [frames] [max threads]
+
+#include "CpuCompositor.h"
+#include "ParticleStore.h"
+#include "TrailPart.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    const int SurfaceWidth = 1920;
+    const int SurfaceHeight = 1080;
+    const int ImageSize = 32;
+    const int ScalingWidth = 3840;
+    const int ScalingHeight = 2160;
+    const float ScalingSpriteSize = 20.0f;
+
+    // soft white dot with a colored rim, straight alpha
+    std::vector<unsigned char> MakeImage()
+    {
+        std::vector<unsigned char> rgba(ImageSize * ImageSize * 4);
+        for (int y = 0; y < ImageSize; y++) {
+            for (int x = 0; x < ImageSize; x++) {
+                float dx = (x + 0.5f) / ImageSize * 2.0f - 1.0f;
+                float dy = (y + 0.5f) / ImageSize * 2.0f - 1.0f;
+                float r = std::sqrt(dx * dx + dy * dy);
+                unsigned char* p = &rgba[(y * ImageSize + x) * 4];
+                p[0] = 255;
+                p[1] = static_cast<unsigned char>(255 * std::min(1.0f, 1.5f - r));
+                p[2] = static_cast<unsigned char>(255 * std::max(0.0f, 1.0f - r));
+                p[3] = static_cast<unsigned char>(255 * std::max(0.0f, 1.0f - r * r));
+            }
+        }
+        return rgba;
+    }
+
+    // spiral trail over a width x height surface, fading from the newest particle back
+    void FillTrail(ParticleStore& store, unsigned int particles, int width = SurfaceWidth, int height = SurfaceHeight)
+    {
+        store.Resize(particles);
+        float scale = height / 1080.0f;
+        for (unsigned int i = 0; i < particles; i++) {
+            float t = static_cast<float>(i) / particles;
+            float angle = t * 40.0f;
+            float radius = (50.0f + t * 450.0f) * scale;
+            store.Add(TrailPart(width * 0.5f + radius * std::cos(angle),
+                                height * 0.5f + radius * std::sin(angle), t));
+        }
+    }
+
+    // the former per-particle path: bilinear resampling of the straight
+    // image, premultiplying and blending every pixel in floating point
+    void DrawReference(const std::vector<unsigned char>& image, const ParticleStore& store, int size, std::vector<uint32_t>& surface)
+    {
+        const float* xs = store.Attribute(PARTICLE_X);
+        const float* ys = store.Attribute(PARTICLE_Y);
+        for (unsigned int n = 0; n < store.LiveCount(); n++) {
+            unsigned int i = (store.Tail() + n) % store.Capacity();
+            float alpha = std::min(1.0f, std::max(0.0f, store.AlphaAt(i, FADE_FRAME, 0.0f)));
+            if (alpha <= 0.0f) {
+                continue;
+            }
+            int left = static_cast<int>(std::floor(xs[i] - size * 0.5f + 0.5f));
+            int top = static_cast<int>(std::floor(ys[i] - size * 0.5f + 0.5f));
+            for (int y = std::max(0, top); y < std::min(SurfaceHeight, top + size); y++) {
+                float v = std::min(std::max((y - top + 0.5f) * ImageSize / size - 0.5f, 0.0f), ImageSize - 1.0f);
+                int y0 = static_cast<int>(v), y1 = std::min(y0 + 1, ImageSize - 1);
+                float fy = v - y0;
+                for (int x = std::max(0, left); x < std::min(SurfaceWidth, left + size); x++) {
+                    float u = std::min(std::max((x - left + 0.5f) * ImageSize / size - 0.5f, 0.0f), ImageSize - 1.0f);
+                    int x0 = static_cast<int>(u), x1 = std::min(x0 + 1, ImageSize - 1);
+                    float fx = u - x0;
+                    float texel[4];
+                    for (int c = 0; c < 4; c++) {
+                        auto premultiplied = [&](int tx, int ty) {
+                            const unsigned char* p = &image[(ty * ImageSize + tx) * 4];
+                            return c == 3 ? p[3] : p[c] * (p[3] / 255.0f);
+                        };
+                        float top0 = premultiplied(x0, y0) + (premultiplied(x1, y0) - premultiplied(x0, y0)) * fx;
+                        float bottom = premultiplied(x0, y1) + (premultiplied(x1, y1) - premultiplied(x0, y1)) * fx;
+                        texel[c] = (top0 + (bottom - top0) * fy) * alpha;
+                    }
+                    uint32_t& d = surface[y * SurfaceWidth + x];
+                    float inverse = 1.0f - texel[3] / 255.0f;
+                    // RGBA texel over a BGRA pixel
+                    const int shifts[4] = { 16, 8, 0, 24 };
+                    uint32_t out = 0;
+                    for (int c = 0; c < 4; c++) {
+                        float blended = texel[c] + ((d >> shifts[c]) & 0xFF) * inverse;
+                        out |= static_cast<uint32_t>(std::min(255.0f, blended + 0.5f)) << shifts[c];
+                    }
+                    d = out;
+                }
+            }
+        }
+    }
+
+    template <typename Function>
+    double MillisecondsPerFrame(Function function, int frames)
+    {
+        function();  // warm up caches
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++) {
+            function();
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / frames;
+    }
+
+    void Run(const std::vector<unsigned char>& image, unsigned int particles, int size, int frames)
+    {
+        ParticleStore store;
+        FillTrail(store, particles);
+        DamageRect surfaceRect(0, 0, SurfaceWidth, SurfaceHeight);
+
+        std::vector<uint32_t> reference(SurfaceWidth * SurfaceHeight);
+        double referenceMs = MillisecondsPerFrame([&]() {
+            std::fill(reference.begin(), reference.end(), 0u);
+            DrawReference(image, store, size, reference);
+        }, frames);
+
+        std::vector<uint32_t> surface(SurfaceWidth * SurfaceHeight);
+        CpuCompositor compositor;
+        compositor.SetThreads(1);
+        compositor.SetSprite(image.data(), ImageSize, ImageSize);
+        compositor.SetTarget(surface.data(), SurfaceWidth, SurfaceHeight, SurfaceWidth * 4);
+        double compositorMs = MillisecondsPerFrame([&]() {
+            compositor.Clear(surfaceRect);
+            compositor.Draw(store, FADE_FRAME, 0.0f, static_cast<float>(size), 0, 0, surfaceRect);
+        }, frames);
+
+        int maxDelta = 0;
+        for (size_t i = 0; i < surface.size(); i++) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                int delta = std::abs(static_cast<int>((surface[i] >> shift) & 0xFF) - static_cast<int>((reference[i] >> shift) & 0xFF));
+                maxDelta = std::max(maxDelta, delta);
+            }
+        }
+
+        std::cout << std::setw(9) << particles << std::setw(6) << size
+                  << std::fixed << std::setprecision(3)
+                  << " | " << std::setw(9) << referenceMs << " -> " << std::setw(8) << compositorMs << " ms"
+                  << " | " << std::setprecision(1) << std::setw(6) << referenceMs / compositorMs << "x"
+                  << " | max delta " << maxDelta
+                  << std::endl;
+    }
+
+    unsigned long long Hash(const std::vector<uint32_t>& pixels)
+    {
+        unsigned long long hash = 14695981039346656037ull;
+        for (uint32_t pixel : pixels) {
+            hash = (hash ^ pixel) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    void RunScaling(const std::vector<unsigned char>& image, unsigned int particles, int frames, unsigned int maxThreads)
+    {
+        ParticleStore store;
+        FillTrail(store, particles, ScalingWidth, ScalingHeight);
+        DamageRect surfaceRect(0, 0, ScalingWidth, ScalingHeight);
+        std::vector<uint32_t> surface(static_cast<size_t>(ScalingWidth) * ScalingHeight);
+
+        CpuCompositor compositor;
+        compositor.SetSprite(image.data(), ImageSize, ImageSize);
+        compositor.SetTarget(surface.data(), ScalingWidth, ScalingHeight, ScalingWidth * 4);
+
+        std::cout << std::setw(9) << particles << " |";
+        double single = 0.0;
+        unsigned long long expected = 0;
+        bool identical = true;
+        for (unsigned int threads = 1; threads <= maxThreads; threads = threads < maxThreads ? std::min(threads * 2, maxThreads) : threads + 1) {
+            compositor.SetThreads(threads);
+            double ms = MillisecondsPerFrame([&]() {
+                // clearing the tiles of the previous frame is part of the work of a frame
+                for (const DamageRect& tile : compositor.DrawnTiles()) {
+                    compositor.Clear(tile);
+                }
+                compositor.Draw(store, FADE_FRAME, 0.0f, ScalingSpriteSize, 0, 0, surfaceRect);
+            }, frames);
+            if (threads == 1) {
+                single = ms;
+                expected = Hash(surface);
+            }
+            identical = identical && Hash(surface) == expected;
+            std::cout << std::fixed << std::setprecision(2) << " " << threads << ": " << ms << " ms ("
+                      << std::setprecision(1) << single / ms << "x)";
+        }
+        std::cout << " | tiles " << compositor.DrawnTiles().size()
+                  << (identical ? " | identical" : " | IMAGES DIFFER") << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 20;
+    int maxThreads = argc > 2 ? std::atoi(argv[2]) : 0;
+    if (maxThreads <= 0) {
+        maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    std::cout << "CpuCompositor kernels: " << CpuCompositor::Arch() << std::endl;
+    std::cout << "particles  size | ms per frame, per-particle float -> compositor" << std::endl;
+
+    std::vector<unsigned char> image = MakeImage();
+    const unsigned int counts[] = { 500, 2000, 10000 };
+    const int sizes[] = { 15, 25, 64 };
+    for (unsigned int particles : counts) {
+        for (int size : sizes) {
+            Run(image, particles, size, std::max(1, frames));
+        }
+    }
+
+    std::cout << std::endl << "thread scaling, " << ScalingWidth << "x" << ScalingHeight << ", sprite size "
+              << ScalingSpriteSize << ", " << CpuCompositor::TileSize << " px tiles" << std::endl;
+    const unsigned int scalingCounts[] = { 10000, 100000, 1000000 };
+    for (unsigned int particles : scalingCounts) {
+        RunScaling(image, particles, std::max(1, frames / 4), static_cast<unsigned int>(maxThreads));
+    }
+    return 0;
+}
@@ -0,0 +1,487 @@
+// Trace-driven benchmark of the whole trail: synthetic cursor traces are
+// written to trace files and replayed through the simulation and every
+// render path, once per shipped config preset: the OpenGL paths offscreen,
+// the software compositor of the overlays into memory and, when built
+// with X11 and a display opens, the X11 overlay through MIT-SHM and
+// XRender with its X request counts.
+// Results are printed as JSON so runs of two commits can be diffed;
+// program logs go to stderr.
+//
+// usage: cursortrail_bench [--seconds <s>] [--resolution <w>x<h>] [--out <file>]
+
+#include "Game.h"
+#include "Config.h"
+#include "Stats.h"
+#include "Clock.h"
+#include "CursorSource.h"
+#include "GLStateCache.h"
+#include "HeadlessContext.h"
+#include "ResourceManager.h"
+#include "CpuCompositor.h"
+#include "stb/stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+// Xlib defines macros (None, Status, Bool) the headers above must not see
+#ifdef CURSORTRAIL_X11
+#include "X11Overlay.h"
+#endif
+
+
+namespace
+{
+    // samples per second of the synthetic traces
+    const double SampleRate = 60.0;
+
+    const char* const Presets[] = {
+        "config.ini", "config-dense.ini", "config-minimal.ini", "config-large.ini", "config-rainbow.ini"
+    };
+
+    enum BackendKind
+    {
+        BACKEND_GL,     // Game::Render into the EGL framebuffer
+        BACKEND_CPU,    // CpuCompositor into a memory surface, as the overlays do
+        BACKEND_X11,    // X11Overlay on the display of $DISPLAY, Xvfb or a real one
+    };
+
+    struct Backend
+    {
+        const char* name;
+        BackendKind kind;
+        bool        batch;          // Config::batchRendering
+        bool        persistent;     // Config::persistentBuffers
+        X11Backend  x11;            // Config::x11Backend
+    };
+
+    const Backend Backends[] = {
+        { "sprite", BACKEND_GL, false, false, X11_SHM },
+        { "batch-orphan", BACKEND_GL, true, false, X11_SHM },
+        { "batch-persistent", BACKEND_GL, true, true, X11_SHM },
+        { "cpu", BACKEND_CPU, false, false, X11_SHM },
+        { "x11-shm", BACKEND_X11, false, false, X11_SHM },
+        { "x11-render", BACKEND_X11, false, false, X11_RENDER },
+    };
+
+    struct Trace
+    {
+        std::string name;
+        std::string path;
+        double      seconds;
+    };
+
+    struct Result
+    {
+        unsigned int       frames;      // samples replayed
+        unsigned int       rendered;    // frames drawn, idle frames are skipped like in the main loop
+        double             p50, p99, max;   // frame time in milliseconds
+        double             spawnedPerSecond;
+        unsigned long long drawCalls;
+        unsigned long long bytesUploaded;
+        unsigned long long pixelsRepainted;
+        unsigned long long xRequests;
+        unsigned long long xRequestBytes;
+        unsigned long long xRoundTrips;
+        long               peakRssKb;
+    };
+
+    double Triangle(double t)
+    {
+        double phase = t - std::floor(t);
+        return phase < 0.5 ? phase * 2.0 : 2.0 - phase * 2.0;
+    }
+
+    // cursor position of a synthetic trace at time t on a width x height screen
+    void SamplePath(const std::string& name, double t, double seconds, int width, int height, double& x, double& y)
+    {
+        const double pi = 3.14159265358979323846;
+        double cx = width * 0.5, cy = height * 0.5;
+        if (name == "drift") {
+            // 40 px/s
+            x = width * 0.2 + 40.0 * t;
+            y = cy + 10.0 * std::sin(t);
+        }
+        else if (name == "circles") {
+            // one revolution per second
+            x = cx + height * 0.3 * std::cos(2.0 * pi * t);
+            y = cy + height * 0.3 * std::sin(2.0 * pi * t);
+        }
+        else if (name == "zigzag") {
+            x = width * 0.2 + width * 0.6 * Triangle(t);
+            y = height * 0.2 + height * 0.6 * Triangle(t / seconds * 4.0);
+        }
+        else if (name == "flicks") {
+            // 0.1 s flicks at 10000 px/s every half second, resting in between
+            double distance = std::min(1000.0, width * 0.8);
+            double period = std::fmod(t, 0.5);
+            double progress = std::min(period / (distance / 10000.0), 1.0);
+            bool forward = static_cast<int>(t / 0.5) % 2 == 0;
+            double from = cx - distance * 0.5, to = cx + distance * 0.5;
+            x = forward ? from + (to - from) * progress : to + (from - to) * progress;
+            y = cy;
+        }
+        else {
+            // idle: one second of circles, then the cursor rests
+            double moving = std::min(t, 1.0);
+            x = cx + height * 0.3 * std::cos(2.0 * pi * moving);
+            y = cy + height * 0.3 * std::sin(2.0 * pi * moving);
+        }
+    }
+
+    Trace WriteTrace(const std::string& name, double seconds, int width, int height)
+    {
+        Trace trace;
+        trace.name = name;
+        trace.seconds = seconds;
+        trace.path = (std::filesystem::temp_directory_path() / ("cursortrail_bench_" + name + ".trace")).string();
+
+        CursorTraceWriter writer;
+        writer.Open(trace.path);
+        unsigned int samples = static_cast<unsigned int>(seconds * SampleRate);
+        for (unsigned int i = 0; i < samples; i++) {
+            double t = i / SampleRate;
+            double x, y;
+            SamplePath(name, t, seconds, width, height, x, y);
+            writer.Append(CursorSample(t, x, y));
+        }
+        writer.Close();
+        return trace;
+    }
+
+    // forgets the peak resident set size so the next run measures its own
+    void ResetPeakRss()
+    {
+#ifdef __linux__
+        std::ofstream clear("/proc/self/clear_refs");
+        clear << "5";
+#endif
+    }
+
+    long PeakRssKb()
+    {
+#ifdef __linux__
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                return std::atol(line.c_str() + 6);
+            }
+        }
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+#else
+        return 0;
+#endif
+    }
+
+    double Percentile(std::vector<double> values, double fraction)
+    {
+        if (values.empty()) {
+            return 0.0;
+        }
+        std::sort(values.begin(), values.end());
+        size_t index = static_cast<size_t>(std::ceil(fraction * values.size()));
+        return values[std::min(values.size() - 1, index > 0 ? index - 1 : 0)];
+    }
+
+    // the software compositor of the overlays: the tiles drawn last frame
+    // are cleared, then the live particles are stamped into the surface
+    class CpuTarget
+    {
+    public:
+        CpuTarget(int width, int height) : surface(static_cast<size_t>(width) * height), area(0, 0, width, height)
+        {
+            int spriteWidth, spriteHeight, channels;
+            unsigned char* data = stbi_load(g_config.texturePath.c_str(), &spriteWidth, &spriteHeight, &channels, 4);
+            if (data) {
+                this->compositor.SetSprite(data, spriteWidth, spriteHeight);
+                stbi_image_free(data);
+            }
+            else {
+                std::cout << "Failed to load " << g_config.texturePath << ", the cpu backend draws nothing" << std::endl;
+            }
+            this->compositor.SetTarget(this->surface.data(), width, height, width * 4);
+        }
+
+        void Render(ParticleStore& particles, float now)
+        {
+            if (g_config.fadeMode != FADE_TIME) {
+                particles.Fade(g_config.fadeRate);
+            }
+            particles.Expire(g_config.fadeMode, now);
+            for (const DamageRect& tile : this->previous) {
+                this->compositor.Clear(tile);
+                g_stats.frame.pixelsRepainted += static_cast<unsigned long long>(tile.width) * tile.height;
+            }
+            g_stats.frame.spritesDrawn += this->compositor.Draw(particles, g_config.fadeMode, now, g_config.spriteSize, 0, 0, this->area);
+            this->previous = this->compositor.DrawnTiles();
+        }
+    private:
+        std::vector<uint32_t>   surface;
+        DamageRect              area;
+        CpuCompositor           compositor;
+        std::vector<DamageRect> previous;
+    };
+
+    // the X11 backends this build and the display support, false with a note otherwise
+    bool X11BackendAvailable(const Backend& backend)
+    {
+#ifdef CURSORTRAIL_X11
+        Display* display = XOpenDisplay(nullptr);
+        if (!display) {
+            std::cerr << backend.name << " skipped: no X display (run under xvfb-run)" << std::endl;
+            return false;
+        }
+        bool render = false;
+#ifdef CURSORTRAIL_XRENDER
+        int event, error;
+        render = XRenderQueryExtension(display, &event, &error);
+#endif
+        XCloseDisplay(display);
+        if (backend.x11 == X11_RENDER && !render) {
+            std::cerr << backend.name << " skipped: no XRender in this build or on the display" << std::endl;
+            return false;
+        }
+        return true;
+#else
+        std::cerr << backend.name << " skipped: built without X11" << std::endl;
+        return false;
+#endif
+    }
+
+    Result Run(const std::string& preset, const Trace& trace, const Backend& backend, int width, int height)
+    {
+        g_config = Config();
+        g_config.LoadFromFile(preset);
+        g_config.batchRendering = backend.batch;
+        g_config.persistentBuffers = backend.persistent;
+        g_config.x11Backend = backend.x11;
+
+        g_stats.frame.Reset();
+        g_stats.total.Reset();
+        g_stats.frames = 0;
+        g_stats.wakeups = 0;
+        ResetPeakRss();
+
+        Result result = Result();
+        std::vector<double> frameTimes;
+        {
+            Game game;
+            game.Width = width;
+            game.Height = height;
+            game.Init();
+            std::unique_ptr<CpuTarget> cpu;
+            if (backend.kind == BACKEND_CPU) {
+                cpu.reset(new CpuTarget(width, height));
+            }
+#ifdef CURSORTRAIL_X11
+            // the overlay simulates the trail itself, like its main loop
+            std::unique_ptr<X11Overlay> overlay;
+            if (backend.kind == BACKEND_X11) {
+                overlay.reset(new X11Overlay());
+                if (!overlay->Initialize()) {
+                    return result;
+                }
+            }
+#endif
+
+            ReplayCursorSource input;
+            input.Open(trace.path);
+            CursorSample sample;
+            bool presentedEmpty = false;
+            while (input.Next(sample)) {
+                double start = Clock::Seconds();
+                bool idle;
+#ifdef CURSORTRAIL_X11
+                if (overlay) {
+                    overlay->WaitForActivity(0);
+                    overlay->Update(sample);
+                    idle = overlay->IsIdle();
+                }
+                else
+#endif
+                {
+                    game.Update(sample);
+                    idle = game.IsIdle();
+                }
+                // the main loop stops drawing once the empty frame is shown
+                if (!idle || !presentedEmpty) {
+                    if (cpu) {
+                        cpu->Render(game.particles, game.currentTime);
+                    }
+#ifdef CURSORTRAIL_X11
+                    else if (overlay) {
+                        overlay->Render();
+                        // time the frame until the server has drawn it; this
+                        // round trip is the bench's, it is not counted
+                        XSync(overlay->GetDisplay(), False);
+                    }
+#endif
+                    else {
+                        game.Render(result.rendered == 0 ? 0 : 1);
+                        glFinish();
+                    }
+                    g_stats.EndFrame();
+                    presentedEmpty = idle;
+                    result.rendered++;
+                }
+                else {
+                    g_stats.total.Add(g_stats.frame);
+                    g_stats.frame.Reset();
+                }
+                frameTimes.push_back((Clock::Seconds() - start) * 1000.0);
+                result.frames++;
+            }
+        }
+
+        result.p50 = Percentile(frameTimes, 0.50);
+        result.p99 = Percentile(frameTimes, 0.99);
+        result.max = frameTimes.empty() ? 0.0 : *std::max_element(frameTimes.begin(), frameTimes.end());
+        result.spawnedPerSecond = g_stats.total.particlesSpawned / trace.seconds;
+        result.drawCalls = g_stats.total.drawCalls;
+        result.bytesUploaded = g_stats.total.bytesUploaded;
+        result.pixelsRepainted = g_stats.total.pixelsRepainted;
+        result.xRequests = g_stats.total.xRequests;
+        result.xRequestBytes = g_stats.total.xRequestBytes;
+        result.xRoundTrips = g_stats.total.xRoundTrips;
+        result.peakRssKb = PeakRssKb();
+        return result;
+    }
+
+    std::string JsonString(const std::string& value)
+    {
+        std::string quoted = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    double seconds = 5.0;
+    int width = 1280, height = 720;
+    std::string out;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--resolution" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::cerr << "Invalid --resolution, expected <width>x<height>" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--out" && i + 1 < argc) {
+            out = argv[++i];
+        }
+        else {
+            std::cerr << "usage: cursortrail_bench [--seconds <s>] [--resolution <w>x<h>] [--out <file>]" << std::endl;
+            return 1;
+        }
+    }
+
+    // program logs would mix with the JSON on stdout
+    std::ostringstream json;
+    std::streambuf* stdoutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    // presets live in the repository root, shaders and textures next to the sources
+    std::filesystem::path root = CURSORTRAIL_SOURCE_DIR;
+    std::filesystem::current_path(root / "CursorTrail");
+
+    HeadlessContext context;
+    if (!context.Create(width, height)) {
+        std::cout.rdbuf(stdoutBuffer);
+        return 1;
+    }
+    glViewport(0, 0, width, height);
+    g_glState.SetBlend(true);
+    g_glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    const char* const traceNames[] = { "drift", "circles", "zigzag", "flicks", "idle" };
+    std::vector<Trace> traces;
+    for (const char* name : traceNames) {
+        traces.push_back(WriteTrace(name, seconds, width, height));
+    }
+
+    json << std::fixed << std::setprecision(3);
+    json << "{\n  \"renderer\": " << JsonString(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) << ",\n"
+         << "  \"resolution\": [" << width << ", " << height << "],\n"
+         << "  \"trace_seconds\": " << seconds << ",\n"
+         << "  \"runs\": [";
+
+    std::vector<Backend> backends;
+    for (const Backend& backend : Backends) {
+        if (backend.kind != BACKEND_X11 || X11BackendAvailable(backend)) {
+            backends.push_back(backend);
+        }
+    }
+
+    bool first = true;
+    for (const char* preset : Presets) {
+        for (const Trace& trace : traces) {
+            for (const Backend& backend : backends) {
+                Result result = Run((root / preset).string(), trace, backend, width, height);
+                std::cerr << preset << " " << trace.name << " " << backend.name << ": p50 " << result.p50
+                          << " ms, p99 " << result.p99 << " ms" << std::endl;
+                double perFrame = result.rendered > 0 ? static_cast<double>(result.rendered) : 1.0;
+
+                json << (first ? "\n" : ",\n")
+                     << "    {\"config\": " << JsonString(preset)
+                     << ", \"trace\": " << JsonString(trace.name)
+                     << ", \"backend\": " << JsonString(backend.name)
+                     << ", \"frames\": " << result.frames
+                     << ", \"rendered\": " << result.rendered
+                     << ", \"frame_ms\": {\"p50\": " << result.p50 << ", \"p99\": " << result.p99 << ", \"max\": " << result.max << "}"
+                     << ", \"spawned_per_second\": " << result.spawnedPerSecond
+                     << ", \"draw_calls\": " << result.drawCalls
+                     << ", \"bytes_uploaded\": " << result.bytesUploaded
+                     << ", \"pixels_repainted\": " << result.pixelsRepainted
+                     << ", \"x_requests_per_frame\": " << result.xRequests / perFrame
+                     << ", \"x_request_bytes_per_frame\": " << result.xRequestBytes / perFrame
+                     << ", \"x_round_trips_per_frame\": " << result.xRoundTrips / perFrame
+                     << ", \"peak_rss_kb\": " << result.peakRssKb << "}";
+                first = false;
+            }
+        }
+    }
+    json << "\n  ]\n}\n";
+
+    for (const Trace& trace : traces) {
+        std::remove(trace.path.c_str());
+    }
+    ResourceManager::Clear();
+    std::cout.rdbuf(stdoutBuffer);
+
+    if (out.empty()) {
+        std::cout << json.str();
+    }
+    else {
+        std::ofstream file(out);
+        file << json.str();
+        std::cerr << "Results written to " << out << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Microbenchmark comparing the structure-of-arrays ParticleStore kernels
+// with the array-of-structs TrailPart loops they replaced.
+//
+// usage: particle_store_bench [iterations]
+
+#include "ParticleStore.h"
+#include "ParticleKernels.h"
+#include "TrailPart.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+
+namespace
+{
+    // keeps results alive so the compiler cannot drop the measured loops
+    volatile float g_sink;
+
+    template <typename Function>
+    double NanosecondsPerParticle(Function function, unsigned int particles, int iterations)
+    {
+        function();  // warm up caches
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            function();
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (static_cast<double>(iterations) * particles);
+    }
+
+    // deterministic particle spread over a 4K screen, a third of them dead
+    TrailPart MakeParticle(unsigned int i)
+    {
+        float x = static_cast<float>((i * 7919u) % 3840u);
+        float y = static_cast<float>((i * 104729u) % 2160u);
+        float alive = (i % 3 == 0) ? 0.0f : 1.0f;
+        return TrailPart(x, y, alive, static_cast<float>(i % 100) * 0.01f, alive * 0.5f);
+    }
+
+    // the per-frame loops of the former array-of-structs implementation
+    void FadeAoS(std::vector<TrailPart>& parts, float rate)
+    {
+        for (auto& part : parts) {
+            if (part.time > 0.0f) {
+                part.time -= rate;
+                if (part.time < 0.0f) {
+                    part.time = 0.0f;
+                }
+            }
+        }
+    }
+
+    unsigned int CountAliveAoS(const std::vector<TrailPart>& parts)
+    {
+        unsigned int alive = 0;
+        for (const auto& part : parts) {
+            if (part.time > 0.0f) alive++;
+        }
+        return alive;
+    }
+
+    void BoundsAoS(const std::vector<TrailPart>& parts, float bounds[4])
+    {
+        for (const auto& part : parts) {
+            if (part.time <= 0.0f) continue;
+            if (part.x < bounds[0]) bounds[0] = part.x;
+            if (part.y < bounds[1]) bounds[1] = part.y;
+            if (part.x > bounds[2]) bounds[2] = part.x;
+            if (part.y > bounds[3]) bounds[3] = part.y;
+        }
+    }
+
+    void Run(unsigned int particles, int iterations)
+    {
+        std::vector<TrailPart> parts(particles);
+        ParticleStore store;
+        store.Resize(particles);
+        for (unsigned int i = 0; i < particles; i++) {
+            parts[i] = MakeParticle(i);
+            store.Add(parts[i]);
+        }
+
+        // a tiny rate keeps particles alive over all iterations
+        const float rate = 1e-9f;
+
+        double fadeAoS = NanosecondsPerParticle([&]() { FadeAoS(parts, rate); }, particles, iterations);
+        double fadeSoA = NanosecondsPerParticle([&]() { store.Fade(rate); }, particles, iterations);
+
+        double countAoS = NanosecondsPerParticle([&]() { g_sink = static_cast<float>(CountAliveAoS(parts)); }, particles, iterations);
+        double countSoA = NanosecondsPerParticle([&]() { g_sink = static_cast<float>(store.CountAlive(FADE_FRAME, 0.0f)); }, particles, iterations);
+
+        double boundsAoS = NanosecondsPerParticle([&]() {
+            float bounds[4] = { 1e30f, 1e30f, -1e30f, -1e30f };
+            BoundsAoS(parts, bounds);
+            g_sink = bounds[0];
+        }, particles, iterations);
+        double boundsSoA = NanosecondsPerParticle([&]() {
+            float bounds[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            store.Bounds(FADE_FRAME, 0.0f, bounds);
+            g_sink = bounds[0];
+        }, particles, iterations);
+
+        std::cout << std::setw(9) << particles
+                  << std::fixed << std::setprecision(3)
+                  << " | fade " << std::setw(7) << fadeAoS << " -> " << std::setw(7) << fadeSoA
+                  << " | count " << std::setw(7) << countAoS << " -> " << std::setw(7) << countSoA
+                  << " | bounds " << std::setw(7) << boundsAoS << " -> " << std::setw(7) << boundsSoA
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 0;
+
+    std::cout << "ParticleStore kernels: " << ParticleKernelArch() << std::endl;
+    std::cout << "ns per particle, AoS -> SoA" << std::endl;
+
+    const unsigned int sizes[] = { 2000, 10000, 1000000 };
+    for (unsigned int particles : sizes) {
+        // roughly the same amount of work for every size
+        int runs = iterations > 0 ? iterations : static_cast<int>(200000000u / particles);
+        Run(particles, runs);
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+// Spawn throughput of TrailEmitter against the per-point interpolation
+// loop it replaced, from a crawling cursor to extreme flick speeds, the
+// spacing both produce along a straight path, and how far linear and
+// spline paths stray from a fast circular motion sampled once per frame.
+//
+// usage: trail_emitter_bench [frames]
+
+#include "ParticleStore.h"
+#include "TrailEmitter.h"
+#include "TrailPart.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+
+namespace
+{
+    const float Spacing = 6.0f;
+    const unsigned int Capacity = 2048;
+
+    // the former loop: restarts at one spacing every sample and always
+    // adds the raw cursor position, one Add() per particle
+    class LegacyEmitter
+    {
+    public:
+        LegacyEmitter() : started(false), x(0.0f), y(0.0f) { }
+        unsigned int Move(ParticleStore& particles, float x, float y, float now)
+        {
+            float x0 = this->x;
+            float y0 = this->y;
+            bool started = this->started;
+            this->x = x;
+            this->y = y;
+            this->started = true;
+            if (started && x == x0 && y == y0) {
+                return 0;
+            }
+            particles.Add(TrailPart(x, y, 1.0f, now, 1.0f));
+            unsigned int spawned = 1;
+            float dx = x - x0;
+            float dy = y - y0;
+            float distance = std::sqrt(dx * dx + dy * dy);
+            if (!started || distance <= 0.0f) {
+                return spawned;
+            }
+            float dirX = dx / distance;
+            float dirY = dy / distance;
+            for (float d = Spacing; d < distance; d += Spacing) {
+                particles.Add(TrailPart(x0 + dirX * d, y0 + dirY * d, 1.0f, now, 1.0f));
+                spawned++;
+            }
+            return spawned;
+        }
+    private:
+        bool  started;
+        float x, y;
+    };
+
+    // cursor position after frame f: flicks back and forth speed px
+    // apart, the direction turning a little every frame
+    void Position(unsigned int frame, float speed, float& x, float& y)
+    {
+        float angle = frame * 0.01f;
+        float half = (frame % 2 == 0 ? 0.5f : -0.5f) * speed;
+        x = 1920.0f + half * std::cos(angle);
+        y = 1080.0f + half * std::sin(angle);
+    }
+
+    template <typename Emitter>
+    void Measure(Emitter& emitter, float speed, unsigned int frames, double& nsPerFrame, double& perFrame)
+    {
+        ParticleStore particles;
+        particles.Resize(Capacity);
+        unsigned long long spawned = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int f = 0; f < frames; f++) {
+            float x, y;
+            Position(f, speed, x, y);
+            spawned += emitter.Move(particles, x, y, f / 60.0f);
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        nsPerFrame = elapsed.count() / frames;
+        perFrame = static_cast<double>(spawned) / frames;
+    }
+
+    // adapts TrailEmitter to the call the measurement makes
+    struct ArcLengthEmitter
+    {
+        TrailEmitter emitter;
+        PathMode     mode;
+        ArcLengthEmitter(PathMode mode = PATH_LINEAR) : mode(mode) { }
+        unsigned int Move(ParticleStore& particles, float x, float y, float now)
+        {
+            return this->emitter.Move(particles, x, y, now, this->mode, Spacing, 1.0f, 1.0f);
+        }
+    };
+
+    // particles spawned and their mean and largest distance from a circle
+    // of the given radius traced at speed px per frame, sampled every frame
+    void CircleError(PathMode mode, float radius, float speed, unsigned int& spawned, float& mean, float& largest)
+    {
+        ArcLengthEmitter emitter(mode);
+        ParticleStore particles;
+        particles.Resize(Capacity);
+        const float centerX = 1000.0f, centerY = 500.0f;
+        unsigned int frames = static_cast<unsigned int>(2.0f * 3.14159265f * radius / speed) + 1;
+        spawned = 0;
+        // the first segment has no sample before it and is straight either way
+        unsigned int straight = 0;
+        for (unsigned int f = 0; f <= frames; f++) {
+            float angle = f * speed / radius;
+            spawned += emitter.Move(particles, centerX + radius * std::cos(angle), centerY + radius * std::sin(angle), f / 60.0f);
+            if (f == 1) {
+                straight = spawned;
+            }
+        }
+        double sum = 0.0;
+        largest = 0.0f;
+        unsigned int first[2], count[2];
+        unsigned int spans = particles.LiveSpans(first, count);
+        unsigned int measured = 0;
+        for (unsigned int s = 0; s < spans; s++) {
+            for (unsigned int i = first[s]; i < first[s] + count[s]; i++) {
+                if (measured++ < straight) {
+                    continue;
+                }
+                float dx = particles.Attribute(PARTICLE_X)[i] - centerX;
+                float dy = particles.Attribute(PARTICLE_Y)[i] - centerY;
+                float error = std::fabs(std::sqrt(dx * dx + dy * dy) - radius);
+                sum += error;
+                largest = std::max(largest, error);
+            }
+        }
+        mean = measured > straight ? static_cast<float>(sum / (measured - straight)) : 0.0f;
+    }
+
+    // smallest and largest distance between consecutive particles along a
+    // straight line sampled every step pixels
+    template <typename Emitter>
+    void Spacings(Emitter& emitter, float step, float& smallest, float& largest)
+    {
+        ParticleStore particles;
+        particles.Resize(Capacity);
+        for (int f = 0; f < 200; f++) {
+            emitter.Move(particles, 100.0f + f * step, 300.0f, f / 60.0f);
+        }
+        std::vector<float> xs;
+        unsigned int first[2], count[2];
+        unsigned int spans = particles.LiveSpans(first, count);
+        for (unsigned int s = 0; s < spans; s++) {
+            xs.insert(xs.end(), particles.Attribute(PARTICLE_X) + first[s], particles.Attribute(PARTICLE_X) + first[s] + count[s]);
+        }
+        // the legacy loop adds the cursor position before the points leading to it
+        std::sort(xs.begin(), xs.end());
+        smallest = 1e30f;
+        largest = 0.0f;
+        for (size_t i = 1; i < xs.size(); i++) {
+            smallest = std::min(smallest, xs[i] - xs[i - 1]);
+            largest = std::max(largest, xs[i] - xs[i - 1]);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int frames = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 20000;
+
+    std::cout << "Spawn throughput, spacing " << Spacing << " px, ring of " << Capacity << " particles, "
+              << frames << " frames" << std::endl;
+    std::cout << "   px/frame | particles/frame legacy -> emitter | ns/frame legacy -> emitter (spline)" << std::endl;
+    const float speeds[] = { 1.0f, 4.0f, 20.0f, 200.0f, 2000.0f, 20000.0f, 200000.0f };
+    for (float speed : speeds) {
+        LegacyEmitter legacy;
+        ArcLengthEmitter arc;
+        ArcLengthEmitter spline(PATH_SPLINE);
+        double legacyNs, legacyRate, arcNs, arcRate, splineNs, splineRate;
+        Measure(legacy, speed, frames, legacyNs, legacyRate);
+        Measure(arc, speed, frames, arcNs, arcRate);
+        Measure(spline, speed, frames, splineNs, splineRate);
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(11) << speed
+                  << " | " << std::setw(10) << legacyRate << " -> " << std::setw(10) << arcRate
+                  << "        | " << std::setw(9) << legacyNs << " -> " << std::setw(9) << arcNs
+                  << " (" << splineNs << ")" << std::endl;
+    }
+
+    std::cout << "Spacing along a straight line (min..max px)" << std::endl;
+    const float steps[] = { 1.0f, 5.0f, 7.0f, 16.0f };
+    for (float step : steps) {
+        LegacyEmitter legacy;
+        ArcLengthEmitter arc;
+        float legacyMin, legacyMax, arcMin, arcMax;
+        Spacings(legacy, step, legacyMin, legacyMax);
+        Spacings(arc, step, arcMin, arcMax);
+        std::cout << std::fixed << std::setprecision(3)
+                  << "  " << std::setw(5) << step << " px/frame | legacy " << legacyMin << ".." << legacyMax
+                  << " | emitter " << arcMin << ".." << arcMax << std::endl;
+    }
+
+    std::cout << "Distance from a circle of radius 100 px sampled every frame (mean / max px, particles)" << std::endl;
+    const float circleSpeeds[] = { 10.0f, 30.0f, 60.0f, 100.0f };
+    for (float speed : circleSpeeds) {
+        unsigned int linearSpawned, splineSpawned;
+        float linearMean, linearMax, splineMean, splineMax;
+        CircleError(PATH_LINEAR, 100.0f, speed, linearSpawned, linearMean, linearMax);
+        CircleError(PATH_SPLINE, 100.0f, speed, splineSpawned, splineMean, splineMax);
+        std::cout << std::fixed << std::setprecision(3)
+                  << "  " << std::setw(6) << speed << " px/frame | linear " << linearMean << " / " << linearMax
+                  << " (" << linearSpawned << ") | spline " << splineMean << " / " << splineMax
+                  << " (" << splineSpawned << ")" << std::endl;
+    }
+
+    return 0;
+}
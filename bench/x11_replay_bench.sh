@@ -0,0 +1,74 @@
+#!/bin/sh
+# Replays a cursor trace through every X11 overlay backend under Xvfb and
+# prints the frame-weighted averages of the --stats reports, then measures
+# the wakeups of an idle overlay reading the live pointer.
+#
+#   bench/x11_replay_bench.sh [build dir] [trace] [backends...]
+#
+# Defaults: _gate_build, tests/golden/trail.trace, shm render. The backend
+# "gl" selects the OpenGL window (--no-native-overlay, needs GLFW). Needs
+# xvfb-run; the render backend needs a build with the Xrender files.
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+build=${1:-$root/_gate_build}
+trace=${2:-$root/tests/golden/trail.trace}
+backends="shm render"
+if [ $# -gt 2 ]; then
+    shift 2
+    backends=$*
+fi
+
+if ! command -v xvfb-run >/dev/null 2>&1; then
+    echo "xvfb-run not found" >&2
+    exit 1
+fi
+# both are used from the source directory below
+build=$(cd "$build" && pwd)
+trace=$(cd "$(dirname "$trace")" && pwd)/$(basename "$trace")
+if [ ! -x "$build/CursorTrail" ]; then
+    echo "$build/CursorTrail not found, build it first" >&2
+    exit 1
+fi
+
+# the sprites and shaders are looked up next to the sources
+cd "$root/CursorTrail"
+xvfb="-screen 0 1280x720x24 +extension RENDER +extension MIT-SHM"
+
+# frame-weighted averages of the per-second [stats] lines
+summarize() {
+    awk -F' \\| ' '
+        /^\[stats\]/ {
+            split($1, f, " "); fps = f[2]
+            for (i = 2; i <= NF; i++) {
+                split($i, kv, ": "); split(kv[2], v, " ")
+                sum[kv[1]] += fps * v[1]
+                if (kv[1] == "X requests/frame") { gsub(/[()]/, "", v[2]); bytes += fps * v[2] }
+            }
+            frames += fps; reports++
+        }
+        END {
+            if (frames == 0) { print "  no frames reported"; exit }
+            printf "  frames %d over %d s\n", frames, reports
+            n = split("sprites/frame|repainted px/frame|cursor samples/frame|X requests/frame|X round trips/frame", keys, "|")
+            for (i = 1; i <= n; i++) {
+                if (keys[i] in sum) printf "  %-22s %.2f\n", keys[i], sum[keys[i]] / frames
+            }
+            if ("X requests/frame" in sum) printf "  %-22s %.0f\n", "X request bytes/frame", bytes / frames
+        }'
+}
+
+for backend in $backends; do
+    case $backend in
+        gl) args="--no-native-overlay" ;;
+        *)  args="--x11-backend $backend" ;;
+    esac
+    echo "$backend: replay of $trace"
+    xvfb-run -a -s "$xvfb" "$build/CursorTrail" --replay-trace "$trace" --stats $args | summarize
+done
+
+# a resting pointer: the input thread queues nothing, the overlay should sleep
+echo "idle: live pointer at rest for 5 s"
+xvfb-run -a -s "$xvfb" sh -c "timeout 5 '$build/CursorTrail' --stats || true" \
+    | awk -F' \\| ' '/^\[stats\]/ { split($2, kv, ": "); sum += kv[2]; n++ }
+                     END { if (n) printf "  wakeups/s              %.2f\n", sum / n }'
@@ -0,0 +1,135 @@
+// Replays the golden trace through the game and draws the same particles
+// twice at each capture time: with OpenGL, offscreen, and with the
+// software compositor of the overlays. Both have to produce the same
+// picture within the perceptual threshold of the golden images. The GL
+// framebuffer is blended straight alpha over transparent black, so its
+// color channels are the premultiplied trail over black, which is what
+// the premultiplied CPU surface holds; the two are compared as opaque
+// images over black. Exits with 1 on a mismatch.
+//
+// usage: compositor_parity_test <trace> <width>x<height> <time>...
+
+#include "Game.h"
+#include "Config.h"
+#include "CursorSource.h"
+#include "CpuCompositor.h"
+#include "FrameDump.h"
+#include "GLStateCache.h"
+#include "HeadlessContext.h"
+#include "ImageCompare.h"
+#include "ResourceManager.h"
+#include "stb/stb_image.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+
+namespace
+{
+    // sprites land on whole pixels on the CPU and on subpixel positions
+    // with GL, which moves their edges by up to half a pixel
+    const double Threshold = 0.1;
+}
+
+int main(int argc, char* argv[])
+{
+    int width = 0, height = 0;
+    if (argc < 4 || std::sscanf(argv[2], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+        std::cerr << "usage: compositor_parity_test <trace> <width>x<height> <time>..." << std::endl;
+        return 1;
+    }
+    std::string trace = std::filesystem::absolute(argv[1]).string();
+    std::vector<double> captureAt;
+    for (int i = 3; i < argc; i++) {
+        captureAt.push_back(std::atof(argv[i]));
+    }
+
+    // shaders and textures are loaded relative to the sources, diff images
+    // are written where the test was started
+    std::filesystem::path output = std::filesystem::current_path();
+    std::filesystem::current_path(std::filesystem::path(CURSORTRAIL_SOURCE_DIR) / "CursorTrail");
+
+    HeadlessContext context;
+    if (!context.Create(width, height)) {
+        return 1;
+    }
+    glViewport(0, 0, width, height);
+    g_glState.SetBlend(true);
+    g_glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    // the cursor input of the trail the threshold was measured with, not
+    // the defaults: a full opacity sprite on a whole pixel lands exactly
+    // half a pixel off the CPU stamp
+    g_config = Config();
+    g_config.pathMode = PATH_SPLINE;
+    g_config.filterCutoff = 2.0f;
+    g_config.deadZone = 2.0f;
+    Game game;
+    game.Width = width;
+    game.Height = height;
+    game.Init();
+
+    CpuCompositor compositor;
+    int spriteWidth, spriteHeight, channels;
+    unsigned char* sprite = stbi_load(g_config.texturePath.c_str(), &spriteWidth, &spriteHeight, &channels, 4);
+    if (!sprite) {
+        std::cerr << "Failed to load " << g_config.texturePath << std::endl;
+        return 1;
+    }
+    compositor.SetSprite(sprite, spriteWidth, spriteHeight);
+    stbi_image_free(sprite);
+    std::vector<unsigned char> surface(static_cast<size_t>(width) * height * 4);
+    compositor.SetTarget(surface.data(), width, height, width * 4);
+    DamageRect area(0, 0, width, height);
+
+    ReplayCursorSource input;
+    if (!input.Open(trace)) {
+        return 1;
+    }
+    CursorSample sample;
+    size_t next = 0;
+    unsigned int frames = 0, failures = 0;
+    std::vector<unsigned char> gl, cpu(surface.size());
+    while (next < captureAt.size() && input.Next(sample)) {
+        game.Update(sample);
+        game.Render(frames == 0 ? 0 : 1);
+        frames++;
+        if (sample.time < captureAt[next]) {
+            continue;
+        }
+        next++;
+
+        context.ReadPixels(gl);
+        compositor.Clear(area);
+        unsigned int drawn = compositor.Draw(game.particles, g_config.fadeMode, game.currentTime, g_config.spriteSize, 0, 0, area);
+        // BGRA premultiplied and RGBA over black, both made opaque
+        for (size_t p = 0; p < surface.size(); p += 4) {
+            cpu[p + 0] = surface[p + 2];
+            cpu[p + 1] = surface[p + 1];
+            cpu[p + 2] = surface[p + 0];
+            cpu[p + 3] = 255;
+            gl[p + 3] = 255;
+        }
+
+        std::vector<unsigned char> diff;
+        ImageDiff result = ImageCompare::Compare(gl, cpu, width, height, Threshold, &diff);
+        std::cout << "t=" << sample.time << " s: " << drawn << " sprites, " << result.mismatched << " of " << result.total
+                  << " pixels differ (max difference " << result.maxDelta << ")" << std::endl;
+        if (!result.Passed()) {
+            std::string path = (output / FrameDump::FileName(next - 1, DUMP_PNG, "parity")).string();
+            FrameDump::WritePng(path, width, height, diff);
+            std::cout << "  see " << path << std::endl;
+            failures++;
+        }
+    }
+    ResourceManager::Clear();
+    if (next < captureAt.size()) {
+        std::cerr << "The trace ends before " << captureAt[next] << " s" << std::endl;
+        return 1;
+    }
+    return failures > 0 ? 1 : 0;
+}
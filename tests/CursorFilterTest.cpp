@@ -0,0 +1,186 @@
+// Checks the cursor filter and the emitter with a parked mouse: a second
+// of motion at 8 px per frame, then ten seconds at rest while the sensor
+// jitters by up to 1 px, inside the 2 px dead zone, sampled at 60 Hz with
+// the opt-in filter settings.
+//   - unfiltered jitter keeps spawning; filtered, at most two particles
+//     are spawned after the stop, within 0.1 s of it
+//   - the trail head lags the moving cursor by less than 4 px
+//   - the parked cursor keeps exactly one live head particle under it at
+//     full opacity, refreshed in place every step for the GPU mirror
+//   - when the cursor moves on after the loop slept through the rest,
+//     the head and the new segment are timed from when it left, so none
+//     of them is born faded out
+// Exits with 1 on a failed check.
+//
+// usage: cursor_filter_test
+
+#include "CursorFilter.h"
+#include "ParticleStore.h"
+#include "TrailEmitter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+
+namespace
+{
+    const float Spacing = 6.0f;
+    const float Lifetime = 1.0f;
+    const unsigned int Capacity = 2048;
+
+    // the smoothing a user opts into
+    const float Cutoff = 2.0f;
+    const float Beta = 0.05f;
+    const float DeadZone = 2.0f;
+
+    // frames of the scenario: 60 moving, then 600 parked
+    const unsigned int MovingFrames = 60;
+    const unsigned int Frames = 660;
+    const double RestX = 400.0 + MovingFrames * 8.0;
+    const double RestY = 300.0;
+
+    struct Parked
+    {
+        unsigned int spawned;       // after the stop
+        unsigned int suppressed;    // moves the filter dropped after the stop
+        unsigned int refreshes;     // resting steps that refreshed the head
+        double       lastSpawn;     // seconds after the stop, negative when none was spawned
+        double       lag;           // mean head distance from the moving cursor (px)
+    };
+
+    bool Check(bool condition, const char* what)
+    {
+        if (!condition) {
+            std::cout << "  FAILED: " << what << std::endl;
+        }
+        return condition;
+    }
+
+    // the newest particle of the ring
+    unsigned int Newest(const ParticleStore& particles)
+    {
+        return (particles.Head() + particles.Capacity() - 1) % particles.Capacity();
+    }
+
+    // runs the scenario and leaves the trail as it is after the rest
+    Parked Run(float jitter, bool filtered, TrailEmitter& emitter, ParticleStore& particles)
+    {
+        CursorFilter filter;
+        Parked result = Parked();
+        result.lastSpawn = -1.0;
+        unsigned int seed = 12345;
+        for (unsigned int f = 0; f < Frames; f++) {
+            double time = f / 60.0;
+            double x = 400.0 + std::min(f, MovingFrames) * 8.0;
+            double y = RestY;
+            if (f > MovingFrames) {
+                // integer pointer positions around the resting point
+                seed = seed * 1103515245u + 12345u;
+                x += std::floor(((seed >> 16) % 1000) / 1000.0 * (2.0 * jitter + 1.0)) - jitter;
+                seed = seed * 1103515245u + 12345u;
+                y += std::floor(((seed >> 16) % 1000) / 1000.0 * (2.0 * jitter + 1.0)) - jitter;
+            }
+            double rawX = x;
+            if (filtered && !filter.Apply(time, x, y, Cutoff, Beta, DeadZone) && f > MovingFrames) {
+                result.suppressed++;
+            }
+            if (f <= MovingFrames) {
+                result.lag += std::fabs(rawX - x) / (MovingFrames + 1);
+            }
+            unsigned int count = emitter.Move(particles, static_cast<float>(x), static_cast<float>(y), static_cast<float>(time),
+                                              PATH_SPLINE, Spacing, 1.0f, Lifetime);
+            particles.Expire(FADE_TIME, static_cast<float>(time));
+            if (f > MovingFrames) {
+                result.spawned += count;
+                if (count > 0) {
+                    result.lastSpawn = time - 1.0;
+                }
+                if (emitter.HeadRefreshed()) {
+                    result.refreshes++;
+                }
+            }
+        }
+        return result;
+    }
+
+    bool Jitter()
+    {
+        bool passed = true;
+        std::cout << "Parked for 10 s after moving 8 px/frame (particles spawned / moves suppressed, last spawn after the stop, head lag)"
+                  << std::endl;
+        const float jitters[] = { 0.0f, 1.0f };
+        for (float jitter : jitters) {
+            Parked raw, filtered;
+            {
+                TrailEmitter emitter;
+                ParticleStore particles;
+                particles.Resize(Capacity);
+                raw = Run(jitter, false, emitter, particles);
+            }
+            TrailEmitter emitter;
+            ParticleStore particles;
+            particles.Resize(Capacity);
+            filtered = Run(jitter, true, emitter, particles);
+
+            std::cout << std::fixed << std::setprecision(2)
+                      << "  +-" << std::setprecision(0) << jitter << " px | raw " << raw.spawned << " / " << raw.suppressed
+                      << " | filtered " << filtered.spawned << " / " << filtered.suppressed << ", "
+                      << std::setprecision(2) << filtered.lastSpawn << " s, " << filtered.lag << " px" << std::endl;
+
+            if (jitter > 0.0f) {
+                passed &= Check(raw.spawned > 10 * std::max(filtered.spawned, 1u), "unfiltered jitter spawns");
+            }
+            passed &= Check(filtered.spawned <= 2, "at most two spawns after the stop");
+            passed &= Check(filtered.lastSpawn < 0.1, "no spawn later than 0.1 s after the stop");
+            passed &= Check(filtered.lag < 4.0, "head lag below 4 px");
+
+            // the trail behind the head has faded out, the head has not
+            float now = (Frames - 1) / 60.0f;
+            unsigned int head = Newest(particles);
+            float dx = particles.Attribute(PARTICLE_X)[head] - static_cast<float>(RestX);
+            float dy = particles.Attribute(PARTICLE_Y)[head] - static_cast<float>(RestY);
+            passed &= Check(particles.LiveCount() == 1, "one live particle at rest");
+            passed &= Check(emitter.Parked(), "the emitter parks the head");
+            passed &= Check(std::sqrt(dx * dx + dy * dy) <= jitter + DeadZone, "the head sits under the resting cursor");
+            passed &= Check(particles.AlphaAt(head, FADE_TIME, now) == 1.0f, "the head keeps full opacity");
+            passed &= Check(filtered.refreshes + filtered.spawned >= Frames - MovingFrames - 1, "every resting step refreshes the head");
+        }
+        return passed;
+    }
+
+    bool LeaveRest()
+    {
+        TrailEmitter emitter;
+        ParticleStore particles;
+        particles.Resize(Capacity);
+        Run(0.0f, true, emitter, particles);
+
+        // the loop slept for five seconds, the next sample is a move
+        float now = (Frames - 1) / 60.0f + 5.0f;
+        unsigned int head = Newest(particles);
+        unsigned int spawned = emitter.Move(particles, static_cast<float>(RestX) + 60.0f, static_cast<float>(RestY), now,
+                                            PATH_SPLINE, Spacing, 1.0f, Lifetime);
+        particles.Expire(FADE_TIME, now);
+        float headTime = particles.Attribute(PARTICLE_SPAWN_TIME)[head];
+
+        std::cout << "Moving 60 px after 5 s asleep at rest: " << spawned << " spawned, " << particles.LiveCount()
+                  << " live, head faded to " << particles.AlphaAt(head, FADE_TIME, now) << std::endl;
+        bool passed = true;
+        passed &= Check(!emitter.Parked(), "the head is released");
+        passed &= Check(emitter.HeadRefreshed(), "the released head is rewritten");
+        passed &= Check(spawned >= 9, "the segment spawns");
+        passed &= Check(particles.LiveCount() == spawned + 1, "the head and the new segment are live");
+        passed &= Check(headTime >= now - 0.1f && headTime < now, "the head fades from when the cursor left");
+        return passed;
+    }
+}
+
+int main()
+{
+    bool passed = true;
+    passed &= Jitter();
+    passed &= LeaveRest();
+    return passed ? 0 : 1;
+}
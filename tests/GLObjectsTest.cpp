@@ -0,0 +1,110 @@
+// Renders a moving trail for a million frames, split between the OpenGL
+// render paths, offscreen, and fails when the number of live GL objects changes
+// after the first frame: per-frame buffers, textures or programs that are
+// created and not deleted would show up here long before a driver runs
+// out of memory. Also checks that destroying the game deletes everything
+// it created. Exits with 1 on a mismatch.
+//
+// usage: gl_objects_test [frames]   (all render paths together)
+
+#include "Game.h"
+#include "Config.h"
+#include "Stats.h"
+#include "Clock.h"
+#include "CursorSource.h"
+#include "GLStateCache.h"
+#include "HeadlessContext.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+
+namespace
+{
+    const int Size = 64;
+
+    struct Backend
+    {
+        const char* name;
+        bool        batch;          // Config::batchRendering
+        bool        persistent;     // Config::persistentBuffers
+    };
+
+    const Backend Backends[] = {
+        { "sprite", false, false },
+        { "batch-orphan", true, false },
+        { "batch-persistent", true, true },
+    };
+
+    // renders frames frames of a cursor circling the surface at 60 fps;
+    // false when the GL object count moved
+    bool Run(const Backend& backend, unsigned long long frames)
+    {
+        g_config = Config();
+        g_config.batchRendering = backend.batch;
+        g_config.persistentBuffers = backend.persistent;
+
+        double start = Clock::Seconds();
+        long long created = 0;
+        bool steady = true;
+        {
+            Game game;
+            game.Width = Size;
+            game.Height = Size;
+            game.Init();
+
+            for (unsigned long long frame = 0; frame < frames; frame++) {
+                if (frame == frames / 2) {
+                    game.Init();
+                }
+                double time = frame / 60.0;
+                CursorSample sample(time, Size * (0.5 + 0.4 * std::cos(time * 3.0)), Size * (0.5 + 0.4 * std::sin(time * 3.0)));
+                game.Update(sample);
+                game.Render(frame == 0 ? 0 : 1);
+                g_stats.frame.Reset();
+                if (frame == 0) {
+                    created = g_stats.glObjects;
+                }
+                else if (g_stats.glObjects != created) {
+                    std::cerr << backend.name << ": " << g_stats.glObjects << " GL objects after frame " << frame
+                              << ", " << created << " after the first one" << std::endl;
+                    steady = false;
+                    break;
+                }
+                // keeps the driver's command queue short
+                if (frame % 1024 == 0) {
+                    glFinish();
+                }
+            }
+        }
+        std::cout << backend.name << ": " << frames << " frames in " << (Clock::Seconds() - start) << " s, "
+                  << created << " GL objects"
+                  << (steady ? "" : ", FAILED") << std::endl;
+        return steady;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned long long frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    // shaders and textures are loaded relative to the sources
+    std::filesystem::current_path(std::filesystem::path(CURSORTRAIL_SOURCE_DIR) / "CursorTrail");
+
+    HeadlessContext context;
+    if (!context.Create(Size, Size)) {
+        return 1;
+    }
+    glViewport(0, 0, Size, Size);
+    g_glState.SetBlend(true);
+    g_glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    bool passed = true;
+    for (const Backend& backend : Backends) {
+        passed &= Run(backend, frames / (sizeof(Backends) / sizeof(Backends[0])));
+    }
+    return passed ? 0 : 1;
+}
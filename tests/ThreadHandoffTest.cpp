@@ -0,0 +1,199 @@
+// Checks the threaded pipeline end to end with the queue the X11 input
+// thread uses: a producer thread queues numbered cursor samples into a
+// QueuedCursorSource of the same capacity, which drops samples when it is
+// full, a TrailSimulation consumes them at a fixed rate and publishes
+// snapshots, and this thread picks them up like a 60 fps render loop that
+// stalls for 100 ms every second.
+//   - at gaming mouse rates (1 and 8 kHz) against a 240 Hz simulation no
+//     sample may be dropped, and every one arrives once and in order
+//   - against a simulation too slow for the input the queue overflows:
+//     the samples that arrive stay in order, and the drops are counted
+//     exactly, by the source and in the snapshot totals that feed --stats
+//   - once the cursor rests and the trail has faded out the simulation
+//     parks, and the next queued sample wakes it
+// It prints how old the snapshots and samples are when drawn. Exits with
+// 1 on a failed check.
+//
+// usage: thread_handoff_test [seconds per rate]
+
+#include "TrailSimulation.h"
+#include "QueuedCursorSource.h"
+#include "Clock.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    // The production queue; x is the sample number. The simulation thread
+    // checks that the numbers it pops only grow
+    class NumberedSource : public QueuedCursorSource
+    {
+    public:
+        NumberedSource() : popped(0), outOfOrder(0), next(0) { }
+
+        bool Next(CursorSample& sample) override
+        {
+            bool queued = this->Pending();
+            QueuedCursorSource::Next(sample);
+            if (queued) {
+                unsigned long long number = static_cast<unsigned long long>(sample.x);
+                if (number < this->next) {
+                    this->outOfOrder++;
+                }
+                this->next = number + 1;
+                this->popped.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        std::atomic<unsigned long long> popped;
+        std::atomic<unsigned long long> outOfOrder;
+    private:
+        unsigned long long next;    // lowest number the next pop may have
+    };
+
+    double Percentile(std::vector<double> values, double p)
+    {
+        if (values.empty()) {
+            return 0.0;
+        }
+        size_t index = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    void PrintLatency(const char* name, const std::vector<double>& values)
+    {
+        std::cout << std::fixed << std::setprecision(3)
+                  << "  " << name << " p50 " << Percentile(values, 0.5) * 1000.0
+                  << " ms, p99 " << Percentile(values, 0.99) * 1000.0
+                  << " ms, max " << Percentile(values, 1.0) * 1000.0 << " ms" << std::endl;
+    }
+
+    // queues total samples at inputRate into source, a millisecond worth at a time
+    void Produce(NumberedSource& source, unsigned long long total, double inputRate)
+    {
+        double start = Clock::Seconds();
+        for (unsigned long long i = 0; i < total; i++) {
+            double due = start + i / inputRate;
+            double now = Clock::Seconds();
+            if (due - now > 0.001) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(due - now));
+            }
+            source.Queue(CursorSample(Clock::Seconds(), static_cast<double>(i), 500.0));
+        }
+    }
+
+    // one input rate against one simulation rate; expectDrops tells whether
+    // the queue has to overflow. False when a check failed
+    bool Run(double seconds, double simulationRate, double inputRate, bool expectDrops)
+    {
+        unsigned long long total = static_cast<unsigned long long>(seconds * inputRate);
+        NumberedSource* source = new NumberedSource();
+        TrailSimulation simulation;
+        simulation.Start(std::unique_ptr<CursorSource>(source), simulationRate);
+        std::thread input(Produce, std::ref(*source), total, inputRate);
+
+        // a 60 fps render loop that misses frames now and then, until the
+        // simulation has accounted for every sample
+        std::vector<double> snapshotAge, inputAge;
+        TrailTotals last;
+        bool backwards = false;
+        unsigned int frames = 0;
+        double deadline = Clock::Seconds() + seconds + 5.0;
+        for (;;) {
+            TrailSnapshot* snapshot = simulation.Latest();
+            double now = Clock::Seconds();
+            if (snapshot) {
+                snapshotAge.push_back(now - snapshot->published);
+                inputAge.push_back(now - snapshot->cursor.time);
+                backwards |= snapshot->totals.samples < last.samples;
+                last = snapshot->totals;
+            }
+            if (last.samples + last.dropped >= total || now > deadline) {
+                break;
+            }
+            frames++;
+            std::this_thread::sleep_for(std::chrono::microseconds(frames % 60 == 0 ? 100000 : 16667));
+        }
+        input.join();
+        simulation.Stop();
+
+        unsigned long long popped = source->popped, dropped = source->Dropped();
+        bool passed = popped + dropped == total && last.samples == popped && last.dropped == dropped
+                   && source->outOfOrder == 0 && !backwards && (dropped > 0) == expectDrops;
+        std::cout << "Input " << inputRate << " Hz, simulation " << simulationRate << " Hz, render 60 fps with a 100 ms stall every second"
+                  << (passed ? "" : ": FAILED") << std::endl;
+        std::cout << "  samples queued " << total << ", simulated " << popped << ", dropped " << dropped
+                  << " (" << last.samples << " simulated and " << last.dropped << " dropped in the snapshot totals)"
+                  << ", out of order " << source->outOfOrder << (backwards ? ", a snapshot went back in time" : "") << std::endl;
+        PrintLatency("snapshot age when drawn (simulation -> render):", snapshotAge);
+        PrintLatency("newest sample age when drawn (input -> render):", inputAge);
+        return passed;
+    }
+
+    // the simulation stops stepping once the trail has faded out, and a
+    // sample wakes it. False when a check failed
+    bool Park()
+    {
+        NumberedSource* source = new NumberedSource();
+        TrailSimulation simulation;
+        simulation.Start(std::unique_ptr<CursorSource>(source), 240.0);
+        for (int i = 0; i < 30; i++) {
+            source->Queue(CursorSample(Clock::Seconds(), 100.0 + i * 10.0, 500.0));
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+        }
+
+        // the trail fades within its lifetime, after that the steps stop
+        std::this_thread::sleep_for(std::chrono::duration<double>(g_config.ParticleLifetime() + 0.2));
+        TrailTotals parked;
+        for (TrailSnapshot* snapshot; (snapshot = simulation.Latest()) != nullptr; ) {
+            parked = snapshot->totals;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        TrailSnapshot* idle = simulation.Latest();
+        unsigned long long idleSteps = idle ? idle->totals.steps - parked.steps : 0;
+
+        // a new sample wakes it right away
+        double sent = Clock::Seconds();
+        source->Queue(CursorSample(sent, 1000.0, 500.0));
+        double woken = 0.0;
+        while (Clock::Seconds() - sent < 1.0) {
+            TrailSnapshot* snapshot = simulation.Latest();
+            if (snapshot && snapshot->totals.samples > parked.samples) {
+                woken = Clock::Seconds() - sent;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        simulation.Stop();
+
+        bool passed = idleSteps == 0 && woken > 0.0;
+        std::cout << "Resting cursor, simulation 240 Hz" << (passed ? "" : ": FAILED") << std::endl;
+        std::cout << "  steps while parked for 500 ms " << idleSteps << ", woken by a sample after "
+                  << woken * 1000.0 << " ms" << std::endl;
+        return passed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+
+    bool passed = true;
+    passed &= Run(seconds, 240.0, 1000.0, false);
+    passed &= Run(seconds, 240.0, 8000.0, false);
+    // 8000 samples in a second against four steps: the 1024 queue overflows between steps
+    passed &= Run(1.0, 4.0, 8000.0, true);
+    passed &= Park();
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+// Moves the X pointer with XTest and checks what X11InputSource delivers:
+// every position it was moved to, in order, timestamped between the move
+// and its arrival at Next(), and nothing dropped. A burst of moves sent
+// without waiting may be read fewer times than it was sent (the thread
+// reads the pointer once for everything that arrived together) but still
+// has to arrive in order and end at the last position. The position the
+// pointer rests at when the source starts is queued before Start()
+// returns. Needs an X server with the XTEST and XInputExtension
+// extensions, ctest runs it under Xvfb. Exits with 1 on a
+// mismatch.
+//
+// usage: x11_input_test [moves]
+
+#include "X11Input.h"
+#include "Clock.h"
+
+#include <X11/extensions/XTest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    // how long a move may take to reach Next()
+    const double Timeout = 1.0;
+
+    // waits until the source has queued samples, false after Timeout
+    bool WaitPending(X11InputSource& source)
+    {
+        double start = Clock::Seconds();
+        while (!source.Pending()) {
+            if (Clock::Seconds() - start > Timeout) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        return true;
+    }
+
+    // every sample still queued
+    void Drain(X11InputSource& source, std::vector<CursorSample>& samples)
+    {
+        CursorSample sample;
+        while (source.Pending() && source.Next(sample)) {
+            samples.push_back(sample);
+        }
+    }
+
+    void Move(Display* display, int x, int y)
+    {
+        XTestFakeMotionEvent(display, -1, x, y, CurrentTime);
+        XFlush(display);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int moves = argc > 1 ? std::atoi(argv[1]) : 200;
+
+    Display* display = XOpenDisplay(nullptr);
+    if (!display) {
+        std::cerr << "No X display" << std::endl;
+        return 1;
+    }
+    int event, error, major, minor;
+    if (!XTestQueryExtension(display, &event, &error, &major, &minor)) {
+        std::cerr << "The X server has no XTEST extension" << std::endl;
+        XCloseDisplay(display);
+        return 1;
+    }
+
+    // park the pointer before Start() reads its first position, which has
+    // to be queued by the time it returns
+    Move(display, 10, 10);
+    XSync(display, False);
+    X11InputSource source;
+    if (!source.Start()) {
+        XCloseDisplay(display);
+        return 1;
+    }
+    std::vector<CursorSample> samples;
+    Drain(source, samples);
+    if (samples.size() != 1 || samples[0].x != 10 || samples[0].y != 10) {
+        std::cerr << "Start() queued " << samples.size() << " samples instead of the pointer at 10,10" << std::endl;
+        source.Stop();
+        XCloseDisplay(display);
+        return 1;
+    }
+    samples.clear();
+
+    // one move at a time: each has to arrive on its own, in order
+    unsigned int failures = 0;
+    double previous = 0.0;
+    for (int i = 0; i < moves; i++) {
+        int x = 100 + i % 500, y = 100 + (i / 500) * 5 + i % 2;
+        double sent = Clock::Seconds();
+        Move(display, x, y);
+        if (!WaitPending(source)) {
+            std::cerr << "Move " << i << " to " << x << "," << y << " never arrived" << std::endl;
+            failures++;
+            break;
+        }
+        double received = Clock::Seconds();
+        samples.clear();
+        Drain(source, samples);
+        if (samples.size() != 1 || samples[0].x != x || samples[0].y != y) {
+            std::cerr << "Move " << i << " to " << x << "," << y << " arrived as " << samples.size() << " samples, the last at "
+                      << samples.back().x << "," << samples.back().y << std::endl;
+            failures++;
+        }
+        const CursorSample& sample = samples.back();
+        if (sample.time < sent || sample.time > received || sample.time <= previous) {
+            std::cerr << "Move " << i << ": timestamp " << sample.time << " outside " << sent << " - " << received
+                      << " or not after " << previous << std::endl;
+            failures++;
+        }
+        previous = sample.time;
+    }
+
+    // a burst: fewer samples than moves is fine, out of order is not
+    samples.clear();
+    for (int i = 0; i < moves; i++) {
+        Move(display, 600 + i, 300);
+    }
+    XSync(display, False);
+    double start = Clock::Seconds();
+    while ((samples.empty() || samples.back().x != 600 + moves - 1) && Clock::Seconds() - start < Timeout) {
+        if (WaitPending(source)) {
+            Drain(source, samples);
+        }
+    }
+    if (samples.empty() || samples.back().x != 600 + moves - 1) {
+        std::cerr << "The burst did not end at its last position" << std::endl;
+        failures++;
+    }
+    for (size_t i = 1; i < samples.size(); i++) {
+        if (samples[i].x <= samples[i - 1].x || samples[i].time <= samples[i - 1].time) {
+            std::cerr << "Burst sample " << i << " at " << samples[i].x << " is not after " << samples[i - 1].x << std::endl;
+            failures++;
+            break;
+        }
+    }
+
+    unsigned long long dropped = source.TakeDropped();
+    if (dropped > 0) {
+        std::cerr << dropped << " samples dropped" << std::endl;
+        failures++;
+    }
+    std::cout << moves << " single moves, a burst of " << moves << " read as " << samples.size() << " samples, "
+              << dropped << " dropped" << (failures > 0 ? ", FAILED" : "") << std::endl;
+
+    source.Stop();
+    XCloseDisplay(display);
+    return failures > 0 ? 1 : 0;
+}